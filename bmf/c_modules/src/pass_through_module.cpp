@@ -14,6 +14,7 @@
 
 #include "pass_through_module.h"
 #include <bmf/sdk/log.h>
+#include <bmf/sdk/module_tag.h>
 
 PassThroughModule::PassThroughModule(int node_id, JsonParam json_param)
     : Module(node_id, json_param) {
@@ -80,3 +81,12 @@ int PassThroughModule::reset() {
 }
 
 int PassThroughModule::close() { return 0; }
+
+REGISTER_MODULE_INFO(PassThroughModule, info) {
+    info.module_description = "Builtin pass through module.";
+    info.module_tag = ModuleTag::BMF_TAG_UTILS;
+    // every packet of a task is forwarded, so any batch size is fine
+    info.module_max_batch = 64;
+    // reset() forgets the streams which reached eof
+    info.module_reusable = true;
+}
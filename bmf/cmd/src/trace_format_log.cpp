@@ -21,7 +21,8 @@ USE_BMF_SDK_NS
 
 int main(int argc, char **argv) {
 #ifndef NO_TRACE
-    // Perform log formatting to tracelog without including trace tool's
+    // Convert the binary logs in the working directory (log<N>.bin) to a
+    // tracelog, streaming event by event, without including trace tool's
     // additional information e.g. on buffer capacity etc
     TraceLogger::instance()->format_logs(false);
 #endif
@@ -18,7 +18,15 @@
 #include <bmf/sdk/module.h>
 #include <bmf/sdk/module_registry.h>
 
+#include <functional>
+#include <queue>
+
 USE_BMF_SDK_NS
+
+// Merges the outputs of the replicas of a distributed node back into one
+// stream in timestamp order. Every replica keeps the order of its own
+// packets, so the smallest head of the per replica buffers can go out once
+// each replica which is not done has a packet buffered.
 class AssembleModule : public Module {
   public:
     AssembleModule(int node_id, JsonParam json_param);
@@ -29,17 +37,31 @@ class AssembleModule : public Module {
 
     int close();
 
+    bool ready_to_emit();
+
     std::map<int, bool> in_eof_;
 
     int last_input_num_;
 
     int last_output_num_;
 
-    int queue_index_;
+    // packets buffered beyond this are sent without waiting for a lagging
+    // replica, which may then deliver late, "max_skew" option
+    int64_t max_skew_ = 16;
+
+    int64_t buffered_ = 0;
+
+    int64_t last_timestamp_ = INT64_MIN;
+
+    int64_t late_cnt_ = 0;
 
     std::map<int, std::shared_ptr<std::queue<Packet>>> queue_map_;
-};
 
-REGISTER_MODULE_CLASS(AssembleModule)
+    // (timestamp, stream) of the head of every non empty buffer
+    std::priority_queue<std::pair<int64_t, int>,
+                        std::vector<std::pair<int64_t, int>>,
+                        std::greater<std::pair<int64_t, int>>>
+        heads_;
+};
 
 #endif // BMF_PASS_THROUGH_MODULE_H
@@ -23,6 +23,8 @@
 #include "scheduler.h"
 #include "input_stream.h"
 #include "callback_layer.h"
+#include "metrics.h"
+#include "profiler.h"
 
 #include "../../connector/include/running_info.h"
 
@@ -130,11 +132,36 @@ class Graph {
 
     bmf::GraphRunningInfo status();
 
+    // the registry may outlive the graph, it is emptied when the graph is
+    // destroyed as its readers point into the nodes and queues
+    std::shared_ptr<MetricsRegistry> get_metrics();
+
+    // "latency_tracking" graph option only, percentiles of the packet
+    // latency per path so far
+    std::vector<PathLatency> get_latency();
+
   private:
+    void register_node_metrics(std::shared_ptr<Node> const &node);
+
+    void register_latency_path(int node_id, int source,
+                               const LatencyHistogram *latency);
+
+    // BMF_PROFILE=1 only, logs a ProfileReport of the run
+    void report_profile();
+
+    // cancels a pending timed resume and joins its thread
+    void stop_resume_timer();
+
     // visible to monitor.
     friend class RunningInfoCollector;
 
     bool paused_ = false;
+    // pause_running(timeout) resumes the graph from this thread unless it
+    // is cancelled first
+    std::thread resume_timer_;
+    std::condition_variable resume_timer_var_;
+    std::mutex resume_timer_mutex_;
+    bool resume_timer_cancel_ = false;
     bool server_mode_ = false;
     //    struct sigaction term_,intrpt_;
     BmfMode mode_;
@@ -155,6 +182,11 @@ class Graph {
     std::mutex con_var_mutex_;
     int32_t closed_count_ = 0;
     bool exception_from_scheduler_ = false;
+    bool profile_ = false;
+    int64_t profile_start_ = 0;
+    bool latency_tracking_ = false;
+    // declared last so its listener stops before the nodes go away
+    std::shared_ptr<MetricsRegistry> metrics_;
 };
 
 END_BMF_ENGINE_NS
@@ -110,6 +110,20 @@ class NodeMetaInfo {
 
     uint32_t get_queue_size_limit();
 
+    int64_t get_queue_bytes_limit();
+
+    uint32_t get_queue_length_min();
+
+    uint32_t get_queue_length_max();
+
+    uint32_t get_max_batch();
+
+    int32_t get_priority();
+
+    bool get_drop_expired();
+
+    bool get_module_pool();
+
     std::map<int64_t, uint32_t> get_callback_binding();
 
     nlohmann::json to_json();
@@ -117,7 +131,14 @@ class NodeMetaInfo {
     bool operator==(NodeMetaInfo const &rhs) {
         return this->premodule_id == rhs.premodule_id &&
                this->bundle == rhs.bundle &&
-               this->queue_size_limit == rhs.queue_size_limit;
+               this->queue_size_limit == rhs.queue_size_limit &&
+               this->queue_bytes_limit == rhs.queue_bytes_limit &&
+               this->queue_length_min == rhs.queue_length_min &&
+               this->queue_length_max == rhs.queue_length_max &&
+               this->max_batch == rhs.max_batch &&
+               this->priority == rhs.priority &&
+               this->drop_expired == rhs.drop_expired &&
+               this->module_pool == rhs.module_pool;
     }
 
   private:
@@ -126,6 +147,25 @@ class NodeMetaInfo {
     int32_t premodule_id = -1;
     int32_t bundle = -1;
     uint32_t queue_size_limit = 5;
+    // input queues are also full once their payloads take this many bytes,
+    // 0 for no byte budget
+    int64_t queue_bytes_limit = 0;
+    // if max is above min, the queue length limit starts from
+    // queue_size_limit and adapts between them to the producer and consumer
+    // rates
+    uint32_t queue_length_min = 0;
+    uint32_t queue_length_max = 0;
+    // max number of timestamps packed into one task, only takes effect if
+    // the module also opts in through ModuleInfo::module_max_batch
+    uint32_t max_batch = 1;
+    // tasks of a higher priority node run first on its scheduler queue
+    int32_t priority = 0;
+    // in deadline mode, tasks which are already late are skipped instead of
+    // processed
+    bool drop_expired = false;
+    // the module is taken from and given back to the ModulePool, it is
+    // recycled through reset() instead of being closed
+    bool module_pool = false;
     std::map<int64_t, uint32_t> callback_binding;
 };
 
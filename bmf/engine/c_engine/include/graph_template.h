@@ -0,0 +1,54 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_GRAPH_TEMPLATE_H
+#define BMF_GRAPH_TEMPLATE_H
+
+#include "graph_config.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+// A graph config taken through subgraph merging, distributed node expansion
+// and the filter optimizer once. Graphs which only differ in some node
+// options, like the files of a short clip service, are instantiated from it
+// without parsing and optimizing again.
+class GraphTemplate {
+  public:
+    GraphTemplate(GraphConfig graph_config, bool need_merge = true);
+
+    // the prepared config with the options of the nodes given by id
+    // replaced, e.g. the input and output of decoders and encoders. Nodes
+    // merged by the optimizer, like ffmpeg filters, can't be given.
+    GraphConfig
+    instantiate(std::map<int, JsonParam> const &node_options = {}) const;
+
+    // the template of the graph config text, prepared on first use
+    static std::shared_ptr<GraphTemplate> get(std::string const &graph_config,
+                                              bool need_merge = true);
+
+    static void clear_cache();
+
+  private:
+    GraphConfig graph_config_;
+};
+
+END_BMF_ENGINE_NS
+#endif // BMF_GRAPH_TEMPLATE_H
@@ -21,6 +21,7 @@
 #include "graph_config.h"
 #include "safe_queue.h"
 
+#include <atomic>
 #include <queue>
 #include <condition_variable>
 #include <thread>
@@ -28,6 +29,11 @@
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
 
+// Immutable packets an output stream shares with all its mirrors. Every input
+// stream reads the batch with its own cursor and keeps references to the
+// packets, so fanning out needs no per mirror copy of the queue.
+typedef std::shared_ptr<const std::vector<Packet>> PacketBatch;
+
 class InputStream {
   public:
     InputStream(int stream_id, std::string const &identifier,
@@ -45,6 +51,10 @@ class InputStream {
 
     int add_packets(std::shared_ptr<SafeQueue<Packet>> &packet);
 
+    int add_packets(PacketBatch const &packets);
+
+    void add_packet(Packet const &pkt);
+
     Packet pop_packet_at_timestamp(int64_t timestamp);
 
     Packet pop_next_packet(bool block = true);
@@ -57,6 +67,9 @@ class InputStream {
 
     int64_t get_time_bounding();
 
+    // no packet up to timestamp will arrive, e.g. the upstream dropped them
+    void advance_time_bounding(int64_t timestamp);
+
     void set_connected(bool connected);
 
     bool is_connected();
@@ -79,8 +92,32 @@ class InputStream {
 
     void wait_on_empty();
 
+    void set_queue_limit(int64_t max_bytes, int min_size, int max_size);
+
+    void adapt_queue_size();
+
+    void account_pop(Packet const &pkt);
+
   public:
-    int max_queue_size_;
+    // current length limit, moves between min_queue_size_ and
+    // max_queue_size_limit_ if they differ
+    std::atomic<int> max_queue_size_;
+    int min_queue_size_ = 0;
+    int max_queue_size_limit_ = 0;
+    // the queue is also full once its payloads take max_queue_bytes_, 0 for
+    // no byte budget. queue_bytes_ is only counted with a budget, which is
+    // set before the first packet arrives
+    int64_t max_queue_bytes_ = 0;
+    std::atomic<int64_t> queue_bytes_{0};
+    // adaptive limit only: producer was throttled or consumer drained the
+    // queue since the last adaption, which happens once per adapt_period_
+    std::atomic<bool> full_hit_{false};
+    std::atomic<bool> empty_hit_{false};
+    int64_t adapt_period_ = 100000000;
+    std::atomic<int64_t> next_adapt_{0};
+    // packets discarded without being processed, by clear_queue or with a
+    // task shed in deadline mode
+    std::atomic<int64_t> drop_cnt_{0};
     std::shared_ptr<SafeQueue<Packet>> queue_;
     std::string identifier_;
     std::string notify_;
@@ -88,7 +125,7 @@ class InputStream {
     int stream_id_;
     int node_id_;
     std::string stream_manager_name_;
-    int64_t next_time_bounding_;
+    int64_t next_time_bounding_ = 0;
     int64_t pop_number_ = 0;
     mutable std::mutex mutex_;
     std::condition_variable fill_packet_event_;
@@ -100,6 +137,9 @@ class InputStream {
     bool connected_ = false;
     bool probed_ = false;
 };
+
+// payload size of a packet in bytes, 0 for types of unknown size
+int64_t packet_nbytes(Packet const &pkt);
 END_BMF_ENGINE_NS
 
 #endif // BMF_INPUT_STREAM_H
@@ -18,10 +18,12 @@
 #define BMF_INPUT_STREAM_MANAGER_H
 
 #include "input_stream.h"
+#include "task_pool.h"
 #include "graph_config.h"
 
 #include <bmf/sdk/task.h>
 
+#include <atomic>
 #include <mutex>
 #include <set>
 
@@ -73,6 +75,12 @@ class InputStreamManager {
 
     void add_packets(int stream_id, std::shared_ptr<SafeQueue<Packet>> packets);
 
+    void add_packets(int stream_id, PacketBatch const &packets);
+
+    void advance_time_bounding(int stream_id, int64_t timestamp);
+
+    void set_queue_limit(int64_t max_bytes, int min_size, int max_size);
+
     int add_upstream_nodes(int node_id);
     void remove_upstream_nodes(int node_id);
     bool find_upstream_nodes(int node_id);
@@ -88,6 +96,19 @@ class InputStreamManager {
     int max_id_;
     std::mutex mtx_;
     std::set<int> upstream_nodes_;
+    // set by event driven backpressure, record when filling a task moves an
+    // input stream from full to not full so the upstreams can be re-armed
+    bool track_backpressure_ = false;
+    std::atomic<bool> backpressure_released_{false};
+    // max number of ready timestamps packed into one task
+    uint32_t max_batch_ = 1;
+    // tasks of the node, recycled once processed
+    TaskPool task_pool_;
+    // queue limits of the input streams, also applied to streams added later
+    uint32_t max_queue_size_;
+    int64_t max_queue_bytes_ = 0;
+    int min_queue_size_ = 0;
+    int max_queue_size_limit_ = 0;
 };
 
 class DefaultInputManager : public InputStreamManager {
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_ENGINE_METRICS_H
+#define BMF_ENGINE_METRICS_H
+
+#include <bmf/sdk/common.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+BEGIN_BMF_ENGINE_NS
+
+// Duration histogram with fixed buckets, observe() only does relaxed atomic
+// adds so it can sit on the task path of every node.
+class MetricHistogram {
+  public:
+    // upper bounds of the buckets in nanoseconds, from 10us to 10s
+    static constexpr int BUCKET_NUM = 19;
+    static const int64_t bounds_ns[BUCKET_NUM];
+
+    void observe(int64_t ns);
+
+    // the last bucket is +Inf
+    std::atomic<int64_t> buckets_[BUCKET_NUM + 1] = {};
+    std::atomic<int64_t> sum_ns_{0};
+    std::atomic<int64_t> count_{0};
+};
+
+// Latency distribution fine enough for tail percentiles, log-linear buckets
+// with 16 sub-buckets per power of two put a percentile within 1/32 of its
+// value. observe() is lock free like MetricHistogram::observe().
+class LatencyHistogram {
+  public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int BUCKET_NUM = (64 - SUB_BITS) << SUB_BITS;
+
+    void observe(int64_t ns);
+
+    // q in [0, 1], the middle of the bucket holding it or 0 without samples
+    int64_t percentile(double q) const;
+
+    static int bucket(int64_t ns);
+
+    std::atomic<int64_t> buckets_[BUCKET_NUM] = {};
+    std::atomic<int64_t> sum_ns_{0};
+    std::atomic<int64_t> count_{0};
+};
+
+// End to end latency of the packets from the node (or graph input stream,
+// source -1) where their data entered the graph to a node putting them out.
+struct PathLatency {
+    int source;
+    int node;
+    int64_t count;
+    int64_t p50_ns;
+    int64_t p99_ns;
+    int64_t p999_ns;
+};
+
+// Metrics of a graph. Owners keep the hot path counters as atomics in their
+// own objects and register readers for them once, the registry mutex is only
+// taken to register, remove or export.
+class MetricsRegistry {
+  public:
+    typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+    ~MetricsRegistry();
+
+    void add_counter(std::string const &name, std::string const &help,
+                     Labels const &labels, std::function<double()> read,
+                     const void *owner = nullptr);
+
+    void add_gauge(std::string const &name, std::string const &help,
+                   Labels const &labels, std::function<double()> read,
+                   const void *owner = nullptr);
+
+    void add_histogram(std::string const &name, std::string const &help,
+                       Labels const &labels, const MetricHistogram *histogram,
+                       const void *owner = nullptr);
+
+    // exported as a summary with the 0.5, 0.99 and 0.999 quantiles
+    void add_summary(std::string const &name, std::string const &help,
+                     Labels const &labels, const LatencyHistogram *histogram,
+                     const void *owner = nullptr);
+
+    // drop every metric registered with owner, e.g. a removed node
+    void remove(const void *owner);
+
+    // drop every metric, once the owners of the counters are gone
+    void clear();
+
+    // Prometheus text exposition format
+    std::string export_text();
+
+    // serve export_text() to any request on "host:port" or "unix:/path"
+    int listen(std::string const &address);
+
+    void stop_listen();
+
+  private:
+    struct Sample {
+        Labels labels;
+        std::function<double()> read;
+        const MetricHistogram *histogram;
+        const LatencyHistogram *summary;
+        const void *owner;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        std::string type;
+        std::vector<Sample> samples;
+    };
+
+    void add(std::string const &name, std::string const &help,
+             std::string const &type, Sample sample);
+
+    void serve();
+
+    std::mutex mutex_;
+    std::vector<Family> families_;
+    int listen_fd_ = -1;
+    std::string unix_path_;
+    std::atomic<bool> listening_{false};
+    std::thread listen_thread_;
+};
+
+END_BMF_ENGINE_NS
+#endif // BMF_ENGINE_METRICS_H
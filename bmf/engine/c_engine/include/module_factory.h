@@ -33,7 +33,8 @@ class ModuleFactory {
                                     JsonParam &option, std::string module_type,
                                     std::string module_path,
                                     std::string module_entry,
-                                    std::shared_ptr<Module> &module);
+                                    std::shared_ptr<Module> &module,
+                                    bool query_info = false);
 
     static JsonParam
     get_subgraph_config(std::shared_ptr<Module> module_instance);
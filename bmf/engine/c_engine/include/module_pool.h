@@ -0,0 +1,77 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_MODULE_POOL_H
+#define BMF_MODULE_POOL_H
+
+#include "graph_config.h"
+
+#include <bmf/sdk/module.h>
+#include <bmf/sdk/module_manager.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+// Initialised module instances kept across graphs. Nodes with the
+// "module_pool" meta take their module from here and give it back once the
+// graph is gone, so the next graph with the same node skips loading and
+// init(). A module is only kept if its ModuleInfo declares module_reusable
+// and its reset() returns 0, which must bring it back to the state right
+// after init(). Modules which are not kept are closed, as is every pooled
+// module by clear(), call it before exit if they are Python modules.
+class ModulePool {
+  public:
+    static ModulePool &instance();
+
+    // a free module made for the same module and option, nullptr if none
+    std::shared_ptr<Module> acquire(NodeConfig &node_config,
+                                    ModuleInfo &module_info);
+
+    // keep a module which was reset by its node, up to max_free per key,
+    // or close it
+    void release(NodeConfig &node_config, std::shared_ptr<Module> module,
+                 ModuleInfo const &module_info);
+
+    // create and initialise modules for the node ahead of its first graph
+    void prepare(NodeConfig &node_config, int count = 1);
+
+    void set_max_free(size_t max_free);
+
+    size_t size();
+
+    void clear();
+
+  private:
+    struct Entry {
+        std::shared_ptr<Module> module;
+        ModuleInfo module_info;
+    };
+
+    static std::string key(NodeConfig &node_config);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<Entry>> free_;
+    size_t max_free_ = 4;
+};
+
+END_BMF_ENGINE_NS
+#endif // BMF_MODULE_POOL_H
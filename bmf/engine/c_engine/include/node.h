@@ -17,6 +17,9 @@
 #ifndef BMF_NODE_H
 #define BMF_NODE_H
 
+#include <atomic>
+#include <deque>
+
 #include <bmf/sdk/common.h>
 #include <bmf/sdk/task.h>
 #include <bmf/sdk/module.h>
@@ -28,6 +31,7 @@
 #include "input_stream_manager.h"
 #include "output_stream_manager.h"
 #include "callback_layer.h"
+#include "metrics.h"
 
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
@@ -48,6 +52,11 @@ class NodeCallBack {
     std::function<void(int, bool)> throttled_cb;
     std::function<void(int, bool)> sched_required;
     std::function<int(int, std::shared_ptr<Node> &)> get_node;
+    // only set with event driven backpressure, re-arm direct upstream nodes
+    std::function<void(int)> release_upstream;
+    // only set with latency tracking, a node saw data from a new source
+    std::function<void(int, int, const LatencyHistogram *)>
+        latency_path_added;
 };
 
 class Node {
@@ -56,6 +65,8 @@ class Node {
          std::shared_ptr<Module> pre_allocated_modules, BmfMode mode,
          std::shared_ptr<ModuleCallbackLayer> callbacks);
 
+    ~Node();
+
     int process_node(Task &task);
 
     bool schedule_node();
@@ -111,6 +122,14 @@ class Node {
 
     int get_scheduler_queue_id();
 
+    int get_priority();
+
+    bool drop_expired_task(Task &task);
+
+    void finish_task();
+
+    void recycle_task(Task &task);
+
     int get_output_streams(
         std::map<int, std::shared_ptr<OutputStream>> &output_streams);
 
@@ -143,6 +162,34 @@ class Node {
 
     std::mutex sched_mutex_;
 
+    // set while a scheduler queue is processing a task of this node, only
+    // used by the work-stealing scheduler to keep process_node serialized
+    std::atomic<bool> in_process_{false};
+
+    // deadline mode only, tasks which finished or were shed after their
+    // deadline, and the shed ones among them
+    std::atomic<int64_t> deadline_miss_cnt_{0};
+    std::atomic<int64_t> deadline_drop_cnt_{0};
+
+    // time spent in module process per task
+    MetricHistogram process_time_;
+    // steady clock nanoseconds of the whole tasks, process plus the engine
+    // work around it like passing the outputs on
+    std::atomic<int64_t> task_ns_{0};
+
+    // steady clock nanoseconds the tasks of the node waited in scheduler
+    // queues and the node could not be scheduled because a downstream queue
+    // was full, blocked_since_ is 0 unless it is blocked right now
+    std::atomic<int64_t> queued_ns_{0};
+    std::atomic<int64_t> backpressure_ns_{0};
+    std::atomic<int64_t> blocked_since_{0};
+
+    // latency tracking only, the time since their data entered the graph of
+    // the packets put out by the node, or consumed by it for a sink
+    LatencyHistogram *latency_path(int source);
+
+    std::vector<PathLatency> get_latency();
+
     BmfMode mode_;
 
   private:
@@ -152,7 +199,13 @@ class Node {
     int id_;
     std::string node_name_;
     std::string module_name_;
+    // TraceNames id of node_name_, trace events of the node only carry it
+    uint32_t trace_name_ = 0;
     int scheduler_queue_id_;
+    int priority_ = 0;
+    bool drop_expired_ = false;
+    bool pooled_ = false;
+    bool reusable_ = false;
     long long task_processed_cnt_;
     bool is_premodule_;
     NodeConfig node_config_;
@@ -182,6 +235,27 @@ class Node {
     std::condition_variable pause_event_;
     NodeCallBack callback_;
     std::map<int, std::vector<std::function<bool()>>> hungry_check_func_;
+
+    PacketTraceContext oldest_input_context(Task &task);
+    bool stamp_latency(int stream_id, Packet &packet,
+                       PacketTraceContext const &upstream, int64_t now);
+    LatencyHistogram *latency_slot(int stream_id, int source);
+
+    struct LatencyPath {
+        explicit LatencyPath(int source) : source(source) {}
+        int source;
+        LatencyHistogram latency;
+    };
+    bool latency_tracking_ = false;
+    std::mutex latency_mutex_;
+    std::deque<LatencyPath> latency_paths_;
+    struct LatencySlot {
+        int source = -1;
+        LatencyHistogram *latency = nullptr;
+    };
+    // the path the packets of an output stream took last, -1 for the data
+    // ending in the node, only used by process_node
+    std::map<int, LatencySlot> latency_slots_;
 };
 END_BMF_ENGINE_NS
 
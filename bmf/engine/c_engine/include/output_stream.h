@@ -43,6 +43,10 @@ class OutputStream {
 
     int propagate_packets(std::shared_ptr<SafeQueue<Packet>> packets);
 
+    int propagate_packets(PacketBatch const &packets);
+
+    void propagate_time_bounding(int64_t timestamp);
+
     int add_upstream_nodes(int node_id);
 
     int stream_id_;
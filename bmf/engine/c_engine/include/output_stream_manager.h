@@ -20,6 +20,7 @@
 #include "../include/graph_config.h"
 #include "../include/output_stream.h"
 
+#include <functional>
 #include <string>
 
 BEGIN_BMF_ENGINE_NS
@@ -36,11 +37,18 @@ class OutputStreamManager {
 
     std::vector<int> get_stream_id_list();
 
-    int post_process(Task &task);
+    // stamp is called with the stream id on each packet before it is
+    // propagated, with latency tracking only
+    int post_process(
+        Task &task,
+        std::function<void(int, Packet &)> const &stamp = nullptr);
 
     int propagate_packets(int stream_id,
                           std::shared_ptr<SafeQueue<Packet>> packets);
 
+    // no packet up to timestamp will be sent on any output stream
+    void propagate_time_bounding(int64_t timestamp);
+
     bool any_of_downstream_full();
 
     void probe_eof();
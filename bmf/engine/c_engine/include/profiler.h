@@ -0,0 +1,81 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_ENGINE_PROFILER_H
+#define BMF_ENGINE_PROFILER_H
+
+#include <bmf/sdk/common.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BEGIN_BMF_ENGINE_NS
+
+// Totals of one node over a run, all times in nanoseconds
+struct NodeProfile {
+    int id;
+    std::string module;
+    int scheduler_queue;
+    bool is_source;
+    int64_t tasks;
+    int64_t process_ns; // in module process only
+    int64_t task_ns;    // process_node in total
+    int64_t queued_ns;
+    int64_t backpressure_ns;
+    std::vector<int> downstream;
+};
+
+struct QueueProfile {
+    int id;
+    int64_t busy_ns;
+    int64_t wait_ns;
+};
+
+// Where the time of a graph run went, written on Graph::close when BMF_PROFILE
+// is set to 1.
+//
+// The critical path is the source to sink path with the largest mean time a
+// task spends queued and processed per node, the bottleneck is the node which
+// was busy in process the longest, as it bounds the throughput of the graph.
+class ProfileReport {
+  public:
+    ProfileReport(std::vector<NodeProfile> nodes,
+                  std::vector<QueueProfile> queues, int64_t wall_ns);
+
+    std::string dump() const;
+
+    std::vector<NodeProfile> nodes_;
+    std::vector<QueueProfile> queues_;
+    int64_t wall_ns_;
+
+    std::vector<int> critical_path_;
+    int64_t critical_path_ns_ = 0;
+    // node id, -1 if no node processed anything
+    int bottleneck_ = -1;
+    // graph config changes worth a try, e.g. dist_nums of the bottleneck
+    std::vector<std::string> suggestions_;
+
+  private:
+    void find_critical_path();
+
+    void suggest();
+
+    NodeProfile const *node(int id) const;
+};
+
+END_BMF_ENGINE_NS
+#endif // BMF_ENGINE_PROFILER_H
@@ -18,6 +18,9 @@
 #define BMF_SAFE_QUEUE_H
 
 #include <queue>
+#include <vector>
+#include <algorithm>
+#include <atomic>
 #include <list>
 #include <mutex>
 #include <thread>
@@ -206,7 +209,8 @@ template <class T> class SafePriorityQueue {
         if (m_max_num_items > 0 && m_queue.size() > m_max_num_items)
             return false;
 
-        m_queue.push(item);
+        m_queue.push_back(item);
+        std::push_heap(m_queue.begin(), m_queue.end());
         return true;
     }
 
@@ -215,13 +219,14 @@ template <class T> class SafePriorityQueue {
      * \param[in] item An item.
      * \return true if an item was pushed into the queue
      */
-    bool push(const T &&item) {
+    bool push(T &&item) {
         std::lock_guard<std::mutex> lock(m_mutex);
 
         if (m_max_num_items > 0 && m_queue.size() > m_max_num_items)
             return false;
 
-        m_queue.push(item);
+        m_queue.push_back(std::move(item));
+        std::push_heap(m_queue.begin(), m_queue.end());
         return true;
     }
 
@@ -236,8 +241,10 @@ template <class T> class SafePriorityQueue {
         if (m_queue.empty())
             return false;
 
-        item = m_queue.top();
-        m_queue.pop();
+        // pop_heap moves the top to the back, out of the heap
+        std::pop_heap(m_queue.begin(), m_queue.end());
+        item = std::move(m_queue.back());
+        m_queue.pop_back();
         return true;
     }
 
@@ -264,8 +271,7 @@ template <class T> class SafePriorityQueue {
         if (this != &sq) {
             std::lock_guard<std::mutex> lock1(m_mutex);
             std::lock_guard<std::mutex> lock2(sq.m_mutex);
-            std::queue<T> temp{sq.m_queue};
-            m_queue.swap(temp);
+            m_queue = sq.m_queue;
         }
 
         return *this;
@@ -280,9 +286,85 @@ template <class T> class SafePriorityQueue {
     }
 
   private:
-    std::priority_queue<T, std::vector<T>> m_queue;
+    // a max-heap kept with the std heap algorithms, unlike
+    // std::priority_queue it lets pop move the top out
+    std::vector<T> m_queue;
     mutable std::mutex m_mutex;
     unsigned int m_max_num_items = 0;
 };
+
+/** A lock-free multi-producer queue, consumers take all pending items at
+ * once with a single atomic exchange, so it is also safe for several
+ * consumers draining concurrently. */
+template <class T> class MpscQueue {
+    struct Node {
+        T value;
+        Node *next;
+    };
+
+  public:
+    MpscQueue() = default;
+
+    MpscQueue(const MpscQueue &) = delete;
+
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    ~MpscQueue() {
+        Node *node = m_head.exchange(nullptr);
+        while (node) {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    /**
+     *  Pushes the item into the queue without taking any lock.
+     * \param[in] item An item.
+     */
+    void push(T item) {
+        Node *node = new Node{std::move(item), nullptr};
+        node->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(node->next, node,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed))
+            ;
+    }
+
+    /**
+     *  Takes every pending item in push order.
+     * \param[in] func Called once for each item.
+     * \return Number of items taken.
+     */
+    template <class F> size_t pop_all(F &&func) {
+        if (m_head.load(std::memory_order_relaxed) == nullptr)
+            return 0;
+        Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+        // the list is built newest first
+        Node *prev = nullptr;
+        while (node) {
+            Node *next = node->next;
+            node->next = prev;
+            prev = node;
+            node = next;
+        }
+        size_t cnt = 0;
+        while (prev) {
+            Node *next = prev->next;
+            func(std::move(prev->value));
+            delete prev;
+            prev = next;
+            cnt++;
+        }
+        return cnt;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_seq_cst) == nullptr;
+    }
+
+  private:
+    std::atomic<Node *> m_head{nullptr};
+};
 END_BMF_ENGINE_NS
 #endif // BMF_SAFE_QUEUE_H
@@ -21,6 +21,9 @@
 #include "scheduler_queue.h"
 #include "node.h"
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
 
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
@@ -44,7 +47,7 @@ class SchedulerCallBack {
 class Scheduler {
   public:
     Scheduler(SchedulerCallBack callback, int scheduler_cnt = 1,
-              double time_out = 0);
+              double time_out = 0, bool work_stealing = false);
 
     int add_scheduler_queue();
 
@@ -60,8 +63,13 @@ class Scheduler {
 
     int sched_required(int node_id, bool is_closed);
 
+    void release_upstream(int node_id);
+
     bool choose_node_schedule(int64_t start_time, std::shared_ptr<Node> &node);
 
+    void rearm_node(int node_id);
+
+    // hands the task to the queue of its node, leaving it moved-from
     int schedule_node(Task &task);
 
     int clear_task(int node_id, int scheduler_queue_id);
@@ -70,9 +78,34 @@ class Scheduler {
 
     int alive_watch();
 
+    bool steal_task(int thief_id, Item &item);
+
+    void release_node(int node_id);
+
+    void wake_idle_queue(int except_id);
+
+    void set_queue_affinity(std::vector<std::string> const &cpu_lists,
+                            bool numa_bind);
+
+    void set_priority_aging(int64_t aging_ms);
+
+    void set_latency_budget(int64_t budget_ms, double time_base);
+
+    int64_t task_deadline(Task &task);
+
     bool paused_ = false;
     std::vector<std::shared_ptr<SchedulerQueue>> scheduler_queues_;
     std::map<int, NodeItem> nodes_to_schedule_;
+    // nodes_to_schedule_ ordered by (last_scheduled_time_, node id), the
+    // least recently scheduled node comes first
+    std::set<std::pair<int64_t, int>> schedule_order_;
+    // nodes found unable to make progress are taken out of schedule_order_
+    // until rearm_node() reports a change of their state
+    std::set<int> blocked_nodes_;
+    // rearm_node() only records the node here under a leaf lock, so it can
+    // be called with node locks held, choose_node_schedule() applies it
+    std::set<int> rearmed_nodes_;
+    std::mutex rearm_mutex_;
     std::thread exec_thread_;
     bool thread_quit_ = 0;
     int64_t cond_wait_num_ = 0;
@@ -85,8 +118,26 @@ class Scheduler {
     SchedulerCallBack callback_;
     SafeQueue<std::shared_ptr<Node>> sched_nodes_;
 
+    // idle queues take ready tasks of busy queues instead of each node being
+    // pinned to its own queue thread
+    bool work_stealing_ = false;
+    // upstream nodes are re-armed by their direct downstream when its input
+    // leaves the full state, instead of walking up to the sources each time
+    bool event_backpressure_ = false;
+    // deadline mode: a task is due latency_budget_ after the wall clock time
+    // its oldest input packet maps to, 0 disables it. The first packet seen
+    // anchors the timestamps, time_base_ns_ is the length of one tick.
+    int64_t latency_budget_ = 0;
+    double time_base_ns_ = 1000;
+    std::once_flag deadline_anchor_flag_;
+    int64_t anchor_timestamp_ = 0;
+    int64_t anchor_time_ = 0;
+
     double time_out_; // task schedule requirement time out hang check
     std::thread guard_thread_;
+    // guard thread sleeps until the time out may expire or close() is called
+    std::condition_variable guard_var_;
+    std::mutex guard_mutex_;
 };
 
 END_BMF_ENGINE_NS
@@ -20,10 +20,14 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include "node.h"
+#include "safe_queue.h"
 #include <bmf/sdk/task.h>
 #include <exception>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
@@ -37,7 +41,14 @@ enum class State {
 
 class Item {
   public:
+    // effective priority, base_priority raised by aging while it waits
     int priority;
+    int base_priority;
+    // steady clock time the task was queued, in nanoseconds
+    int64_t enqueue_time;
+    // steady clock time the task should be done by in deadline mode, in
+    // nanoseconds, INT64_MAX if the task has none
+    int64_t deadline;
     Task task;
 
     //        Item(int priority = 0, Task task = Task()) {
@@ -47,26 +58,41 @@ class Item {
 
     Item() {
         this->priority = 0;
+        this->base_priority = 0;
+        this->enqueue_time = 0;
+        this->deadline = INT64_MAX;
         this->task = Task();
     }
 
     Item(Item const &rhs) {
         this->priority = rhs.priority;
+        this->base_priority = rhs.base_priority;
+        this->enqueue_time = rhs.enqueue_time;
+        this->deadline = rhs.deadline;
         this->task = rhs.task;
     }
 
     Item(Item &&rhs) noexcept {
         this->priority = rhs.priority;
+        this->base_priority = rhs.base_priority;
+        this->enqueue_time = rhs.enqueue_time;
+        this->deadline = rhs.deadline;
         this->task = std::move(rhs.task);
     }
 
     Item(int priority, Task &&task) {
         this->priority = priority;
+        this->base_priority = priority;
+        this->enqueue_time = 0;
+        this->deadline = INT64_MAX;
         this->task = std::move(task);
     }
 
     Item(int priority, Task const &task) {
         this->priority = priority;
+        this->base_priority = priority;
+        this->enqueue_time = 0;
+        this->deadline = INT64_MAX;
         this->task = task;
     }
 
@@ -74,6 +100,9 @@ class Item {
         using std::swap;
 
         swap(target.priority, source.priority);
+        swap(target.base_priority, source.base_priority);
+        swap(target.enqueue_time, source.enqueue_time);
+        swap(target.deadline, source.deadline);
         swap(target.task, source.task);
     }
 
@@ -87,38 +116,111 @@ class SchedulerQueueCallBack {
   public:
     std::function<int(int, std::shared_ptr<Node> &)> get_node_;
     std::function<int(int)> exception_;
+    // work-stealing mode only: take a runnable task from a sibling queue
+    std::function<bool(int, Item &)> steal_;
+    // work-stealing mode only: a node finished its task on this queue
+    std::function<void(int)> release_;
 };
 
 class SchedulerQueue {
   public:
-    bool paused_ = false;
+    std::atomic<bool> paused_{false};
     int id_;
     State paused_state_;
     std::thread exec_thread_;
     State state_;
     bool exception_catch_flag_ = false;
     std::exception_ptr eptr_;
-    int64_t start_time_; // TODO: unused
+    // steady clock time the queue thread started, in nanoseconds
+    std::atomic<int64_t> start_time_{0};
     int64_t wait_duration_ = 0;
     int64_t wait_cnt_ = 0;
+    // TraceNames ids of the wait events, registered once instead of
+    // building the names on every wait
+    uint32_t trace_wait_name_ = 0;
+    uint32_t trace_wait_src_ = 0;
+    // steady clock time spent processing tasks and parked, in nanoseconds
+    std::atomic<int64_t> busy_ns_{0};
+    std::atomic<int64_t> wait_ns_{0};
     SchedulerQueueCallBack callback_;
-    // TODO:
+    // producers push into the lock-free inbox, the queue thread drains it
+    // into the timestamp ordered queue_
+    MpscQueue<Item> inbox_;
     SafePriorityQueue<Item> queue_;
+    // tasks in inbox_ and queue_, size() reads it so other threads never
+    // drain the inbox
+    std::atomic<int64_t> count_{0};
     //    SafeQueue<Item> queue_;
+    // only taken to park or unpark the queue thread
     std::condition_variable con_var_;
     std::mutex con_var_mutex_;
+    std::atomic<bool> parked_;
+    std::atomic<bool> signal_;
+    // pause() waits here for the queue thread to stop, which then waits
+    // here for resume()
+    std::condition_variable pause_var_;
+    std::mutex pause_mutex_;
+    // bumped by every resume(), a quick pause() after resume() must not keep
+    // the queue thread waiting on the old pause
+    int64_t resume_cnt_ = 0;
+    // opt-in work stealing, see Scheduler
+    bool work_stealing_ = false;
+    std::atomic<bool> idle_;
+    int64_t steal_cnt_ = 0;
+    // cpus the queue thread is pinned to, empty lets the os place it
+    std::vector<int> cpu_set_;
+    // numa node preferred by the allocations of the queue thread, -1 for none
+    int numa_node_ = -1;
+    // cpu which ran the last task and how often it changed, numa_migrations_
+    // only counts the moves to a cpu of another numa node
+    std::atomic<int> last_cpu_;
+    std::atomic<int64_t> cpu_migrations_;
+    std::atomic<int64_t> numa_migrations_;
+    // waiting tasks gain one priority level per aging period, so low
+    // priority nodes are delayed but never starved, 0 disables aging
+    int64_t aging_period_;
+    int64_t next_aging_ = 0;
+    // set once a task with a non default priority is queued, aging is
+    // skipped until then
+    std::atomic<bool> prioritized_;
+
+    SchedulerQueue(int id, SchedulerQueueCallBack callback,
+                   bool work_stealing = false);
+
+    // queue thread only, it drains the inbox
+    Item pop_task();
 
-    SchedulerQueue(int id, SchedulerQueueCallBack callback);
+    // copy of the drained tasks in pop order, safe from any thread
+    std::vector<Item> snapshot();
 
-    Item pop_task();
+    bool take_task(Item &item);
+
+    void drain_inbox();
+
+    void age_tasks();
+
+    bool empty();
+
+    size_t size();
+
+    void wake();
+
+    void park();
 
-    int add_task(Task &task, int priority);
+    int add_task(Task &&task, int priority, int64_t deadline = INT64_MAX);
 
     int remove_node_task(int node_id);
 
     int exec_loop();
 
-    int exec(Task &task);
+    int steal_exec_loop();
+
+    int exec(Task &task, int64_t deadline = INT64_MAX,
+             int64_t enqueue_time = 0);
+
+    void apply_affinity();
+
+    void track_cpu();
 
     void internal_pause();
 
@@ -130,6 +232,18 @@ class SchedulerQueue {
 
     int close();
 };
+
+// steady clock time in nanoseconds, the time base of task deadlines
+int64_t steady_time_ns();
+
+// parse a linux style cpu list such as "0-3,8,10-11"
+std::vector<int> parse_cpu_list(std::string const &cpu_list);
+
+// cpu ids valid for affinity are below it
+int cpu_count();
+
+// numa node owning the cpu, -1 if unknown
+int numa_node_of_cpu(int cpu);
 END_BMF_ENGINE_NS
 
 #endif // BMF_SCHEDULER_QUEUE_H
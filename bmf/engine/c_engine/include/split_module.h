@@ -18,7 +18,27 @@
 #include <bmf/sdk/module.h>
 #include <bmf/sdk/module_registry.h>
 
+#include <functional>
+
 USE_BMF_SDK_NS
+
+// how packets are spread over the replicas of a distributed node, set with
+// the "dist_strategy" option of the node
+enum class SplitStrategy {
+    // replicas in turn
+    ROUND_ROBIN = 0,
+    // replica with the fewest packets queued at its input
+    QUEUE_DEPTH = 1,
+    // replica with the fewest queued packets plus scheduled tasks
+    PENDING_TASKS = 2
+};
+
+// backlog of the replica behind one output stream of the split node
+struct ReplicaLoad {
+    int64_t queued = 0;
+    int64_t pending_tasks = 0;
+};
+
 class SplitModule : public Module {
   public:
     SplitModule(int node_id, JsonParam json_param);
@@ -29,6 +49,8 @@ class SplitModule : public Module {
 
     int close();
 
+    int select_stream(Packet &pkt, int output_num);
+
     bool in_eof_;
 
     int last_input_num_;
@@ -36,8 +58,20 @@ class SplitModule : public Module {
     int last_output_num_;
 
     int stream_index_;
-};
 
-REGISTER_MODULE_CLASS(SplitModule)
+    SplitStrategy strategy_ = SplitStrategy::ROUND_ROBIN;
+
+    // if set, packets whose attached json carries this field go to the
+    // replica chosen by the hash of its value, e.g. a scene id
+    std::string key_;
+
+    // set by the engine node, without it the load aware strategies fall
+    // back to round robin
+    std::function<ReplicaLoad(int)> load_probe_;
+
+    // packets dispatched to each output in the running task, they are
+    // not visible to load_probe_ before the task is post processed
+    std::vector<int64_t> dispatched_;
+};
 
 #endif // BMF_PASS_THROUGH_MODULE_H
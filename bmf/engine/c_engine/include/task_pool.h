@@ -0,0 +1,53 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_TASK_POOL_H
+#define BMF_TASK_POOL_H
+
+#include <bmf/sdk/common.h>
+#include <bmf/sdk/task.h>
+
+#include <mutex>
+#include <vector>
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+// Processed tasks of one node, kept so the next task reuses their packet
+// queues and map nodes instead of allocating new ones.
+class TaskPool {
+  public:
+    TaskPool(size_t max_free = 8);
+
+    // a task of the node with a queue for each stream, recycled if a free one
+    // has the same streams
+    Task acquire(int node_id, std::vector<int> const &input_stream_ids,
+                 std::vector<int> const &output_stream_ids);
+
+    // take a processed task back, its queues are emptied, a task whose
+    // queues are still referenced elsewhere is left alone
+    void release(Task &task);
+
+    size_t size();
+
+  private:
+    std::mutex mutex_;
+    std::vector<Task> free_;
+    size_t max_free_;
+};
+
+END_BMF_ENGINE_NS
+#endif // BMF_TASK_POOL_H
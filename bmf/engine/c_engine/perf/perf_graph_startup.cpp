@@ -0,0 +1,145 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/graph.h"
+#include "../include/graph_template.h"
+#include "../include/module_pool.h"
+#include "../include/optimizer.h"
+#include "../test/test_graph_modules.h"
+
+#include <bmf/sdk/log.h>
+#include <bmf/sdk/module_registry.h>
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+// a stage with some setup in init(), like loading a lookup table or model
+class StartupStage : public Module {
+  public:
+    StartupStage(int node_id, JsonParam option) : Module(node_id, option) {}
+
+    int32_t init() override {
+        table_.resize(1 << 18);
+        for (size_t i = 0; i < table_.size(); i++)
+            table_[i] = float(i % 255) / 255.f;
+        return 0;
+    }
+
+    int32_t reset() override {
+        sent_ = 0;
+        return 0;
+    }
+
+    int32_t process(Task &task) override {
+        if (task.get_inputs().empty()) {
+            if (sent_++ == 0) {
+                Packet pkt(std::string("clip"));
+                pkt.set_timestamp(0);
+                task.fill_output_packet(0, pkt);
+            } else {
+                task.fill_output_packet(0, Packet::generate_eof_packet());
+                task.set_timestamp(DONE);
+            }
+            return 0;
+        }
+        Packet pkt;
+        while (task.pop_packet_from_input_queue(0, pkt)) {
+            if (task.get_outputs().size())
+                task.fill_output_packet(0, pkt);
+            if (pkt.timestamp() == BMF_EOF)
+                task.set_timestamp(DONE);
+        }
+        return 0;
+    }
+
+    std::vector<float> table_;
+    int sent_ = 0;
+};
+
+REGISTER_MODULE_CLASS(StartupStage)
+
+std::string startup_graph(bool pooled) {
+    nlohmann::json graph_json = {{"nodes", nlohmann::json::array()}};
+    const int stages = 4;
+    for (int i = 0; i < stages; i++) {
+        std::vector<int> inputs, outputs;
+        if (i > 0)
+            inputs.push_back(i - 1);
+        if (i < stages - 1)
+            outputs.push_back(i);
+        auto node = test_node_json(i, "StartupStage", inputs, outputs);
+        node["module_info"]["type"] = "c++";
+        node["option"] = {{"stage", i}};
+        node["meta_info"] = {{"module_pool", pooled}};
+        graph_json["nodes"].push_back(node);
+    }
+    return graph_json.dump();
+}
+
+// setup and run of a graph carrying a single packet, arg(0) selects the
+// setup: 0 parses and optimizes the config and loads every module like
+// BMFGraph does, 1 instantiates a cached GraphTemplate, 2 also takes the
+// modules from the ModulePool
+void BM_graph_startup(benchmark::State &state) {
+    BMFLOG_SET_LEVEL(BMF_ERROR);
+    const int mode = state.range(0);
+    auto text = startup_graph(mode == 2);
+    ModulePool::instance().clear();
+    GraphTemplate::clear_cache();
+    double setup_ns = 0;
+
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        GraphConfig graph_config;
+        std::map<int, std::shared_ptr<Module>> pre_modules;
+        if (mode == 0) {
+            auto graph_json = nlohmann::json::parse(text);
+            graph_config = GraphConfig(graph_json);
+            Optimizer::subgraph_preprocess(graph_config, pre_modules);
+            Optimizer::process_distributed_node(graph_config.nodes);
+            Optimizer::convert_filter_para_for_graph(graph_config.nodes);
+            Optimizer::optimize(graph_config.nodes);
+            Optimizer::replace_stream_name_for_graph(graph_config.nodes);
+        } else {
+            graph_config = GraphTemplate::get(text)->instantiate();
+        }
+        std::map<int, std::shared_ptr<ModuleCallbackLayer>> callback_bindings;
+        auto graph = std::make_shared<Graph>(graph_config, pre_modules,
+                                             callback_bindings);
+        setup_ns += std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        graph->start();
+        graph->close();
+    }
+    state.counters["setup_us"] = setup_ns / 1e3 / state.iterations();
+    ModulePool::instance().clear();
+    GraphTemplate::clear_cache();
+}
+
+BENCHMARK(BM_graph_startup)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/output_stream_manager.h"
+#include "alloc_counter.h"
+
+#include <bmf/sdk/log.h>
+#include <benchmark/benchmark.h>
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+// one output stream feeding arg(0) mirrors, e.g. a decoder feeding an
+// encoding ladder, a frame is propagated per iteration and consumed at once
+void BM_fan_out(benchmark::State &state) {
+    BMFLOG_SET_LEVEL(BMF_ERROR);
+    const int mirrors = state.range(0);
+
+    StreamConfig out_config;
+    out_config.identifier = "video";
+    OutputStreamManager output_manager({out_config});
+    std::shared_ptr<OutputStream> output_stream;
+    output_manager.get_stream(0, output_stream);
+
+    std::vector<std::shared_ptr<InputStream>> inputs;
+    for (int i = 0; i < mirrors; i++) {
+        std::vector<StreamConfig> in_configs = {out_config};
+        std::vector<int> output_ids;
+        InputStreamManagerCallBack callback;
+        auto input_manager = std::make_shared<ImmediateInputStreamManager>(
+            i, in_configs, output_ids, 5, callback);
+        output_stream->add_mirror_stream(input_manager, 0);
+        inputs.push_back(input_manager->input_streams_[0]);
+    }
+
+    Packet frame(std::string(64, 'x'));
+    int64_t ts = 0;
+    int64_t allocs = 0;
+    for (auto _ : state) {
+        Task task(0, {}, {0});
+        frame.set_timestamp(ts++);
+        task.fill_output_packet(0, frame);
+
+        int64_t start = perf_alloc_count();
+        output_manager.post_process(task);
+        allocs += perf_alloc_count() - start;
+
+        for (auto &input : inputs)
+            input->pop_next_packet(false);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["allocs_per_frame"] =
+        double(allocs) / std::max<int64_t>(state.iterations(), 1);
+}
+
+BENCHMARK(BM_fan_out)->Arg(1)->Arg(4)->Arg(16);
+
+} // namespace
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/graph.h"
+#include "../test/test_graph_modules.h"
+
+#include <bmf/sdk/log.h>
+#include <benchmark/benchmark.h>
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+// source -> N pass-through stages -> sink, arg(0) selects the backpressure
+// release mode, arg(1) the number of stages
+void BM_linear_pipeline(benchmark::State &state) {
+    BMFLOG_SET_LEVEL(BMF_ERROR);
+    const bool event_backpressure = state.range(0);
+    const int stages = state.range(1);
+    const int total = 1000;
+
+    for (auto _ : state) {
+        nlohmann::json graph_json = {
+            {"option",
+             {{"scheduler_count", 2},
+              {"event_backpressure", event_backpressure}}},
+            {"nodes", nlohmann::json::array()}};
+        graph_json["nodes"].push_back(test_node_json(0, "source", {}, {0}));
+        std::map<int, std::shared_ptr<Module>> pre_modules;
+        pre_modules[0] = std::make_shared<TestSource>(0, total);
+        for (int i = 1; i <= stages; i++) {
+            graph_json["nodes"].push_back(
+                test_node_json(i, "pass_through", {i - 1}, {i}, i % 2));
+            pre_modules[i] = std::make_shared<TestPassThrough>(i);
+        }
+        graph_json["nodes"].push_back(test_node_json(
+            stages + 1, "sink", {stages}, {}, (stages + 1) % 2));
+        pre_modules[stages + 1] = std::make_shared<TestSink>(stages + 1);
+
+        auto graph = make_test_graph(graph_json, pre_modules);
+        graph->start();
+        graph->close();
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+BENCHMARK(BM_linear_pipeline)
+    ->Args({0, 20})
+    ->Args({1, 20})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
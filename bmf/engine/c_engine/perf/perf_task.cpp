@@ -0,0 +1,91 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/output_stream_manager.h"
+#include "../include/scheduler_queue.h"
+#include "alloc_counter.h"
+
+#include <bmf/sdk/log.h>
+#include <benchmark/benchmark.h>
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+// the life of one task of a node with an input and an output stream, from
+// being filled by the input stream manager through the scheduler queue to
+// its outputs reaching the downstream, arg(0) selects if processed tasks go
+// back to the task pool
+void BM_task_cycle(benchmark::State &state) {
+    BMFLOG_SET_LEVEL(BMF_ERROR);
+    const bool recycle = state.range(0);
+    SchedulerQueueCallBack queue_callback;
+    SchedulerQueue queue(0, queue_callback);
+
+    StreamConfig in_config;
+    in_config.identifier = "in";
+    std::vector<StreamConfig> in_configs = {in_config};
+    std::vector<int> output_ids = {0};
+    InputStreamManagerCallBack callback;
+    callback.scheduler_cb = [&queue](Task &task) {
+        queue.add_task(std::move(task), 0);
+    };
+    DefaultInputManager input_manager(0, in_configs, output_ids, 5, callback);
+
+    StreamConfig out_config;
+    out_config.identifier = "out";
+    OutputStreamManager output_manager({out_config});
+    std::shared_ptr<OutputStream> output_stream;
+    output_manager.get_stream(0, output_stream);
+    std::vector<StreamConfig> down_configs = {out_config};
+    std::vector<int> down_output_ids;
+    InputStreamManagerCallBack down_callback;
+    auto downstream = std::make_shared<ImmediateInputStreamManager>(
+        1, down_configs, down_output_ids, 5, down_callback);
+    output_stream->add_mirror_stream(downstream, 0);
+
+    auto input = input_manager.input_streams_[0];
+    auto output = downstream->input_streams_[0];
+    Packet frame(std::string(64, 'x'));
+    int64_t ts = 0;
+    int64_t allocs = 0;
+    for (auto _ : state) {
+        frame.set_timestamp(ts++);
+        input->add_packets(
+            PacketBatch(std::make_shared<std::vector<Packet>>(1, frame)));
+
+        int64_t start = perf_alloc_count();
+        input_manager.schedule_node();
+        Item item = queue.pop_task();
+        Packet pkt;
+        item.task.pop_packet_from_input_queue(0, pkt);
+        item.task.fill_output_packet(0, pkt);
+        output_manager.post_process(item.task);
+        if (recycle)
+            input_manager.task_pool_.release(item.task);
+        allocs += perf_alloc_count() - start;
+
+        output->pop_next_packet(false);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["allocs_per_task"] =
+        double(allocs) / std::max<int64_t>(state.iterations(), 1);
+}
+
+BENCHMARK(BM_task_cycle)->Arg(0)->Arg(1);
+
+} // namespace
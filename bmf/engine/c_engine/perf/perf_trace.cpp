@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "alloc_counter.h"
+
+#include <bmf/sdk/trace.h>
+#include <benchmark/benchmark.h>
+
+USE_BMF_SDK_NS
+
+namespace {
+
+#ifndef NO_TRACE
+
+// one trace event from naming it to the logging thread taking it out of the
+// thread buffer, arg(0) selects the name: 0 builds it per event like the
+// scheduler queue wait events used to, 1 looks up a stable name pointer, 2
+// uses an id registered beforehand
+void BM_trace_event(benchmark::State &state) {
+    const int mode = state.range(0);
+    TraceBuffer buffer;
+    std::string node_name = "Node_1_c_ffmpeg_decoder";
+    uint32_t name_id = TraceNames::intern(node_name.c_str());
+    uint32_t src_id = TraceNames::intern("process_node");
+    int64_t cnt = 0;
+    int64_t allocs = 0;
+    for (auto _ : state) {
+        int64_t start = perf_alloc_count();
+        TraceEvent event;
+        event.timestamp = BMF_TRACE_CLOCK() - BMF_TRACE_CLOCK_START;
+        if (mode == 0) {
+            std::string name =
+                "THREAD_1_WAIT_" + std::to_string(cnt++ % 64);
+            event.name = TraceNames::id(name.c_str());
+        } else if (mode == 1) {
+            event.name = TraceNames::id(node_name.c_str());
+        } else {
+            event.name = name_id;
+        }
+        event.subname = src_id;
+        event.category = PROCESSING;
+        event.phase = START;
+        event.info_size = 0;
+        buffer.push_event(event);
+        allocs += perf_alloc_count() - start;
+        benchmark::DoNotOptimize(buffer.pop_event());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["allocs_per_event"] =
+        double(allocs) / std::max<int64_t>(state.iterations(), 1);
+}
+
+BENCHMARK(BM_trace_event)->Arg(0)->Arg(1)->Arg(2);
+
+#endif
+
+} // namespace
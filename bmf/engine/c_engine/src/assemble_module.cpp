@@ -20,10 +20,22 @@ AssembleModule::AssembleModule(int node_id, JsonParam json_param)
     BMFLOG_NODE(BMF_INFO, node_id_) << "assemble module";
     last_input_num_ = 0;
     last_output_num_ = 0;
-    queue_index_ = 0;
+    if (json_param.json_value_.count("max_skew"))
+        max_skew_ = json_param.json_value_.at("max_skew").get<int64_t>();
     return;
 }
 
+bool AssembleModule::ready_to_emit() {
+    if (heads_.empty())
+        return false;
+    if (buffered_ > max_skew_)
+        return true;
+    for (auto &it : queue_map_)
+        if (it.second->empty() && !in_eof_[it.first])
+            return false;
+    return true;
+}
+
 int AssembleModule::process(Task &task) {
     if (task.get_inputs().size() != last_input_num_) {
         BMFLOG_NODE(BMF_DEBUG, node_id_)
@@ -31,12 +43,10 @@ int AssembleModule::process(Task &task) {
             << task.get_inputs().size();
         last_input_num_ = task.get_inputs().size();
         // init queue_map_ 
-        for (int i = 0; i < last_input_num_; i++) {
-            std::shared_ptr<std::queue<Packet>> tmp_queue = 
-                std::make_shared<std::queue<Packet>>();
-            queue_map_.insert(
-                std::pair<int, std::shared_ptr<std::queue<Packet>>>(
-                    i, tmp_queue));
+        for (auto &input_queue : task.get_inputs()) {
+            if (!queue_map_.count(input_queue.first))
+                queue_map_[input_queue.first] =
+                    std::make_shared<std::queue<Packet>>();
         }
     }
     if (task.get_outputs().size() != last_output_num_) {
@@ -51,39 +61,24 @@ int AssembleModule::process(Task &task) {
         for (auto input_queue : task.get_inputs())
             in_eof_[input_queue.first] = false;
     }
-    // assemble data from multi input queue 
-    auto tem_queue = task.get_inputs();
     // cache pkts into queue_map_ 
-    for (size_t i = 0; i < tem_queue.size(); i++) {
-        while (!tem_queue[i]->empty()) {
-            auto q = tem_queue[i];
-            Packet pkt = q->front();
-            q->pop();
-            queue_map_[i]->push(pkt);
-        }
-    }
-    
-    while (!queue_map_[queue_index_]->empty()) {
-        // pass through pkts 
-        Packet packet;
-        auto queue = queue_map_.find(queue_index_);
-        
-        if (in_eof_[queue_index_] == true)
-            continue;
-        
-        packet = queue->second->front();
-        queue->second->pop();
-
-        task.fill_output_packet(0, packet);
-        if (packet.timestamp() == BMF_EOF) {
-            in_eof_[queue_index_] = true;
+    for (auto &input_queue : task.get_inputs()) {
+        int index = input_queue.first;
+        auto &q = input_queue.second;
+        auto &buffer = queue_map_[index];
+        for (; !q->empty(); q->pop()) {
+            Packet &pkt = q->front();
+            if (in_eof_[index])
+                continue;
+            if (pkt.timestamp() == BMF_EOF) {
+                in_eof_[index] = true;
+                continue;
+            }
+            if (buffer->empty())
+                heads_.push(std::make_pair(pkt.timestamp(), index));
+            buffer->push(pkt);
+            buffered_++;
         }
-        BMFLOG_NODE(BMF_DEBUG, node_id_)
-            << "get packet :" << packet.timestamp()
-            << " data:" << packet.type_info().name
-            << " in queue:" << queue_index_;
-
-        queue_index_ = (queue_index_ + 1) % queue_map_.size();   
     }
 
     bool all_eof = true;
@@ -93,15 +88,48 @@ int AssembleModule::process(Task &task) {
             break;
         }
     }
-    if (all_eof)
+
+    // pass through pkts in timestamp order
+    while (all_eof ? !heads_.empty() : ready_to_emit()) {
+        int index = heads_.top().second;
+        heads_.pop();
+        auto &buffer = queue_map_[index];
+        Packet packet = buffer->front();
+        buffer->pop();
+        buffered_--;
+        if (!buffer->empty())
+            heads_.push(std::make_pair(buffer->front().timestamp(), index));
+
+        if (packet.timestamp() < last_timestamp_ && late_cnt_++ == 0)
+            BMFLOG_NODE(BMF_WARNING, node_id_)
+                << "packet " << packet.timestamp()
+                << " arrived after max_skew was exceeded, sent out of order";
+        last_timestamp_ = std::max(last_timestamp_, packet.timestamp());
+        task.fill_output_packet(0, packet);
+        BMFLOG_NODE(BMF_DEBUG, node_id_)
+            << "get packet :" << packet.timestamp()
+            << " data:" << packet.type_info().name
+            << " in queue:" << index;
+    }
+
+    if (all_eof) {
+        task.fill_output_packet(0, Packet::generate_eof_packet());
         task.set_timestamp(DONE);
+    }
 
     return 0;
 }
 
 int AssembleModule::reset() {
     in_eof_.clear();
+    for (auto &it : queue_map_)
+        *it.second = std::queue<Packet>();
+    heads_ = decltype(heads_)();
+    buffered_ = 0;
+    last_timestamp_ = INT64_MIN;
     return 0;
 }
 
 int AssembleModule::close() { return 0; }
+
+REGISTER_MODULE_CLASS(AssembleModule)
@@ -24,6 +24,9 @@
 #include <bmf/sdk/trace.h>
 
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 
@@ -122,8 +125,55 @@ void Graph::init(
         BMFLOG(BMF_INFO) << "scheduler time out: " << time_out << " seconds";
     }
 
-    scheduler_ = std::make_shared<Scheduler>(scheduler_callback,
-                                             scheduler_count_, time_out);
+    bool work_stealing = false;
+    if (graph_config.get_option().json_value_.count("work_stealing"))
+        work_stealing = graph_config.get_option()
+                            .json_value_.at("work_stealing")
+                            .get<bool>();
+
+    scheduler_ = std::make_shared<Scheduler>(
+        scheduler_callback, scheduler_count_, time_out, work_stealing);
+    if (graph_config.get_option().json_value_.count("event_backpressure"))
+        scheduler_->event_backpressure_ =
+            graph_config.get_option()
+                .json_value_.at("event_backpressure")
+                .get<bool>();
+    if (graph_config.get_option().json_value_.count("scheduler_affinity")) {
+        // one cpu list for every queue, or one per queue
+        auto affinity =
+            graph_config.get_option().json_value_.at("scheduler_affinity");
+        std::vector<std::string> cpu_lists;
+        if (affinity.is_string())
+            cpu_lists.push_back(affinity.get<std::string>());
+        else
+            cpu_lists = affinity.get<std::vector<std::string>>();
+        bool numa_bind = false;
+        if (graph_config.get_option().json_value_.count("numa_bind"))
+            numa_bind = graph_config.get_option()
+                            .json_value_.at("numa_bind")
+                            .get<bool>();
+        scheduler_->set_queue_affinity(cpu_lists, numa_bind);
+    }
+    if (graph_config.get_option().json_value_.count("priority_aging_ms"))
+        scheduler_->set_priority_aging(graph_config.get_option()
+                                           .json_value_.at("priority_aging_ms")
+                                           .get<int64_t>());
+    if (graph_config.get_option().json_value_.count("latency_budget_ms")) {
+        // timestamps are taken as microseconds unless told otherwise
+        double time_base = 0.000001;
+        if (graph_config.get_option().json_value_.count("deadline_time_base"))
+            time_base = graph_config.get_option()
+                            .json_value_.at("deadline_time_base")
+                            .get<double>();
+        scheduler_->set_latency_budget(graph_config.get_option()
+                                           .json_value_.at("latency_budget_ms")
+                                           .get<int64_t>(),
+                                       time_base);
+    }
+    if (graph_config.get_option().json_value_.count("latency_tracking"))
+        latency_tracking_ = graph_config.get_option()
+                                .json_value_.at("latency_tracking")
+                                .get<bool>();
     BMFLOG(BMF_INFO) << "scheduler count" << scheduler_count_;
 
     // create all nodes and output streams
@@ -144,6 +194,94 @@ void Graph::init(
 
     for (auto &node : source_nodes_)
         scheduler_->add_or_remove_node(node->get_id(), true);
+
+    metrics_ = std::make_shared<MetricsRegistry>();
+    for (auto &node : nodes_)
+        register_node_metrics(node.second);
+    for (auto &queue : scheduler_->scheduler_queues_) {
+        MetricsRegistry::Labels labels = {
+            {"queue", std::to_string(queue->id_)}};
+        auto q = queue.get();
+        metrics_->add_counter(
+            "bmf_scheduler_queue_busy_seconds_total",
+            "Time the scheduler queue thread spent processing tasks.", labels,
+            [q] { return q->busy_ns_.load() / 1e9; }, q);
+        metrics_->add_counter(
+            "bmf_scheduler_queue_wait_seconds_total",
+            "Time the scheduler queue thread was parked without tasks.",
+            labels, [q] { return q->wait_ns_.load() / 1e9; }, q);
+        metrics_->add_gauge(
+            "bmf_scheduler_queue_utilisation",
+            "Share of the time since start the queue thread was busy.",
+            labels,
+            [q] {
+                int64_t start = q->start_time_;
+                int64_t elapsed = steady_time_ns() - start;
+                return start > 0 && elapsed > 0
+                           ? double(q->busy_ns_.load()) / elapsed
+                           : 0.;
+            },
+            q);
+    }
+    const char *profile = getenv("BMF_PROFILE");
+    profile_ = profile && std::strcmp(profile, "1") == 0;
+    if (graph_config.get_option().json_value_.count("metrics_listen"))
+        metrics_->listen(graph_config.get_option()
+                             .json_value_.at("metrics_listen")
+                             .get<std::string>());
+}
+
+void Graph::register_node_metrics(std::shared_ptr<Node> const &node) {
+    MetricsRegistry::Labels labels = {{"node", std::to_string(node->get_id())},
+                                      {"module", node->get_type()}};
+    auto n = node.get();
+    metrics_->add_histogram("bmf_node_process_seconds",
+                            "Time spent in module process per task.", labels,
+                            &n->process_time_, n);
+    metrics_->add_counter("bmf_node_deadline_dropped_tasks_total",
+                          "Tasks shed because they missed their deadline.",
+                          labels,
+                          [n] { return double(n->deadline_drop_cnt_.load()); },
+                          n);
+
+    std::map<int, std::shared_ptr<InputStream>> input_streams;
+    node->get_input_streams(input_streams);
+    for (auto &it : input_streams) {
+        auto stream_labels = labels;
+        stream_labels.push_back({"stream", it.second->get_identifier()});
+        auto s = it.second;
+        metrics_->add_gauge("bmf_stream_queue_depth",
+                            "Packets waiting in the input stream.",
+                            stream_labels,
+                            [s] { return double(s->queue_->size()); }, n);
+        if (s->max_queue_bytes_ > 0)
+            metrics_->add_gauge(
+                "bmf_stream_queue_bytes",
+                "Payload bytes waiting in the input stream.", stream_labels,
+                [s] { return double(s->queue_bytes_.load()); }, n);
+        metrics_->add_counter(
+            "bmf_stream_dropped_packets_total",
+            "Packets of the input stream discarded without processing.",
+            stream_labels, [s] { return double(s->drop_cnt_.load()); }, n);
+    }
+    for (auto &path : node->get_latency())
+        register_latency_path(path.node, path.source,
+                              node->latency_path(path.source));
+}
+
+void Graph::register_latency_path(int node_id, int source,
+                                  const LatencyHistogram *latency) {
+    std::shared_ptr<Node> node;
+    if (!metrics_ || get_node(node_id, node) != 0)
+        return;
+    MetricsRegistry::Labels labels = {
+        {"source", source < 0 ? "input" : std::to_string(source)},
+        {"node", std::to_string(node_id)},
+        {"module", node->get_type()}};
+    metrics_->add_summary(
+        "bmf_packet_latency_seconds",
+        "Time since the data of the packets entered the graph.", labels,
+        latency, node.get());
 }
 
 int Graph::get_hungry_check_func(std::shared_ptr<Node> &root_node,
@@ -192,12 +330,21 @@ int Graph::init_nodes() {
     callback.sched_required = [this](int node_id, bool is_add) -> int {
         return this->scheduler_->sched_required(node_id, is_add);
     };
+    if (scheduler_->event_backpressure_)
+        callback.release_upstream = [this](int node_id) {
+            this->scheduler_->release_upstream(node_id);
+        };
     callback.scheduler_cb = [this](Task &task) -> int {
         return this->scheduler_->schedule_node(task);
     };
     callback.clear_cb = [this](int node_id, int scheduler_queue_id) -> int {
         return this->scheduler_->clear_task(node_id, scheduler_queue_id);
     };
+    if (latency_tracking_)
+        callback.latency_path_added = [this](int node_id, int source,
+                                             const LatencyHistogram *latency) {
+            this->register_latency_path(node_id, source, latency);
+        };
     // init node
     for (auto &node_config : graph_config_.get_nodes()) {
         std::shared_ptr<Module> module_pre_allocated;
@@ -361,6 +508,7 @@ int Graph::delete_orphan_output_streams() {
 }
 
 int Graph::start() {
+    profile_start_ = steady_time_ns();
     // start scheduler and it will start to schedule source nodes
     scheduler_->start();
 
@@ -429,6 +577,15 @@ int Graph::update(GraphConfig update_config) {
             callback.sched_required =
                 std::bind(&Scheduler::sched_required, scheduler_,
                           std::placeholders::_1, std::placeholders::_2);
+            if (scheduler_->event_backpressure_)
+                callback.release_upstream =
+                    std::bind(&Scheduler::release_upstream, scheduler_,
+                              std::placeholders::_1);
+            if (latency_tracking_)
+                callback.latency_path_added =
+                    std::bind(&Graph::register_latency_path, this,
+                              std::placeholders::_1, std::placeholders::_2,
+                              std::placeholders::_3);
 
             if (!callback_bindings_.count(node_id))
                 callback_bindings_[node_id] =
@@ -765,6 +922,7 @@ int Graph::update(GraphConfig update_config) {
 
             rm_node->close();
             nodes_.erase(rm_node->get_id());
+            metrics_->remove(rm_node.get());
             BMFLOG(BMF_INFO) << "remove node: " << rm_node->get_id()
                              << " alias: " << rm_node->get_alias();
 
@@ -805,6 +963,11 @@ int Graph::update(GraphConfig update_config) {
             reset_node->need_opt_reset(node_config.get_option());
         }
     }
+    // streams of the remaining nodes may have changed as well
+    for (auto &node : nodes_) {
+        metrics_->remove(node.second.get());
+        register_node_metrics(node.second);
+    }
     BMFLOG(BMF_INFO) << "dynamic update done";
 
     return 0;
@@ -826,6 +989,7 @@ int Graph::close() {
             cond_close_.wait(lk);
     }
 
+    stop_resume_timer();
     if (not exception_from_scheduler_)
         scheduler_->close();
     else
@@ -835,6 +999,19 @@ int Graph::close() {
                   << std::endl;
 
     g_ptr.clear();
+    if (profile_)
+        report_profile();
+    if (latency_tracking_) {
+        for (auto &path : get_latency())
+            BMFLOG(BMF_INFO)
+                << "latency from "
+                << (path.source < 0 ? "graph input"
+                                    : "node " + std::to_string(path.source))
+                << " to node " << path.node << ": p50 " << path.p50_ns / 1e6
+                << " ms, p99 " << path.p99_ns / 1e6 << " ms, p999 "
+                << path.p999_ns / 1e6 << " ms over " << path.count
+                << " packets";
+    }
     if (scheduler_->eptr_) {
         auto graph_info = status();
         std::cerr << "Graph status when exception occured: "
@@ -853,6 +1030,7 @@ int Graph::get_node(int node_id, std::shared_ptr<Node> &node) {
 }
 
 int Graph::force_close() {
+    stop_resume_timer();
     for (auto &node : nodes_) {
         node.second->close();
     }
@@ -873,6 +1051,9 @@ int Graph::add_input_stream_packet(std::string const &stream_name,
                 }
             }
         }
+        if (latency_tracking_ && packet &&
+            !packet.trace_context().ingest_time)
+            packet.set_trace_context({steady_time_ns(), -1, 0});
         input_streams_[stream_name]->add_packet(packet);
     }
     return 0;
@@ -893,6 +1074,7 @@ Packet Graph::poll_output_stream_packet(std::string const &stream_name,
 // TODO manually insert a eos packet to indicate the graph input stream is done
 int Graph::add_eos_packet(std::string const &stream_name) {
     if (input_streams_.count(stream_name) > 0) {
+        // the eos carries no data, it is not stamped for latency tracking
         Packet packet = Packet::generate_eos_packet();
         input_streams_[stream_name]->add_packet(packet);
     }
@@ -902,17 +1084,35 @@ int Graph::add_eos_packet(std::string const &stream_name) {
 void Graph::pause_running(double_t timeout) {
     if (paused_)
         return;
+    // a timer left from an earlier pause must not end this one
+    stop_resume_timer();
     scheduler_->pause();
     paused_ = true;
     if (timeout > 0) {
-        auto f = [](Graph *g, int timout) {
-            usleep(timout);
-            g->resume_running();
-        };
-        std::thread(f, this, timeout * 1000);
+        resume_timer_cancel_ = false;
+        resume_timer_ = std::thread([this, timeout] {
+            std::unique_lock<std::mutex> lk(resume_timer_mutex_);
+            if (resume_timer_var_.wait_for(
+                    lk, std::chrono::duration<double, std::milli>(timeout),
+                    [this] { return resume_timer_cancel_; }))
+                return;
+            lk.unlock();
+            resume_running();
+        });
     }
 }
 
+void Graph::stop_resume_timer() {
+    if (!resume_timer_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lk(resume_timer_mutex_);
+        resume_timer_cancel_ = true;
+    }
+    resume_timer_var_.notify_all();
+    resume_timer_.join();
+}
+
 void Graph::resume_running() {
     if (!paused_)
         return;
@@ -948,6 +1148,11 @@ void Graph::quit_gracefully() {
 }
 
 Graph::~Graph() {
+    stop_resume_timer();
+    if (metrics_) {
+        metrics_->stop_listen();
+        metrics_->clear();
+    }
     if (not exception_from_scheduler_)
         scheduler_->close();
 }
@@ -956,6 +1161,62 @@ bmf::GraphRunningInfo Graph::status() {
     return RunningInfoCollector().collect_graph_info(this);
 }
 
+std::shared_ptr<MetricsRegistry> Graph::get_metrics() { return metrics_; }
+
+std::vector<PathLatency> Graph::get_latency() {
+    std::vector<PathLatency> paths;
+    for (auto &node : nodes_) {
+        auto node_paths = node.second->get_latency();
+        paths.insert(paths.end(), node_paths.begin(), node_paths.end());
+    }
+    return paths;
+}
+
+void Graph::report_profile() {
+    int64_t now = steady_time_ns();
+    std::vector<NodeProfile> nodes;
+    for (auto &it : nodes_) {
+        auto &node = it.second;
+        NodeProfile profile;
+        profile.id = node->get_id();
+        profile.module = node->get_type();
+        profile.scheduler_queue = node->get_scheduler_queue_id();
+        // is_source() also holds for nodes which got their eof
+        std::map<int, std::shared_ptr<InputStream>> input_streams;
+        node->get_input_streams(input_streams);
+        profile.is_source = input_streams.empty();
+        profile.tasks = node->process_time_.count_.load();
+        profile.process_ns = node->process_time_.sum_ns_.load();
+        profile.task_ns = node->task_ns_.load();
+        profile.queued_ns = node->queued_ns_.load();
+        // a node still blocked at the end counts until now
+        int64_t blocked_since = node->blocked_since_.load();
+        profile.backpressure_ns = node->backpressure_ns_.load() +
+                                  (blocked_since ? now - blocked_since : 0);
+        std::map<int, std::shared_ptr<OutputStream>> output_streams;
+        node->get_output_streams(output_streams);
+        for (auto &stream : output_streams)
+            for (auto &mirror : stream.second->mirror_streams_)
+                if (nodes_.count(mirror.input_stream_manager_->node_id_))
+                    profile.downstream.push_back(
+                        mirror.input_stream_manager_->node_id_);
+        nodes.push_back(std::move(profile));
+    }
+    std::vector<QueueProfile> queues;
+    for (auto &queue : scheduler_->scheduler_queues_)
+        queues.push_back(
+            {queue->id_, queue->busy_ns_.load(), queue->wait_ns_.load()});
+
+    auto report = ProfileReport(std::move(nodes), std::move(queues),
+                                now - profile_start_)
+                      .dump();
+    BMFLOG(BMF_INFO) << "\n" << report;
+    if (const char *path = getenv("BMF_PROFILE_OUTPUT")) {
+        std::ofstream out(path);
+        out << report;
+    }
+}
+
 void GraphInputStream::set_manager(
     std::shared_ptr<OutputStreamManager> &manager) {
     manager_ = manager;
@@ -20,6 +20,7 @@
 
 #include <nlohmann/json_fwd.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <list>
@@ -125,7 +126,11 @@ NodeMetaInfo::NodeMetaInfo(const NodeMetaInfo &other)
     : premodule_id(other.premodule_id),
       bundle(other.bundle),
       queue_size_limit(other.queue_size_limit),
-      callback_binding(other.callback_binding) {}
+      queue_bytes_limit(other.queue_bytes_limit),
+      queue_length_min(other.queue_length_min),
+      queue_length_max(other.queue_length_max), max_batch(other.max_batch),
+      priority(other.priority), drop_expired(other.drop_expired),
+      module_pool(other.module_pool), callback_binding(other.callback_binding) {}
 
 void NodeMetaInfo::init(nlohmann::json &node_meta) {
     if (node_meta.count("bundle_id"))
@@ -143,6 +148,20 @@ void NodeMetaInfo::init(nlohmann::json &node_meta) {
         }
     if (node_meta.count("queue_length_limit"))
         queue_size_limit = node_meta.at("queue_length_limit").get<uint32_t>();
+    if (node_meta.count("queue_bytes_limit"))
+        queue_bytes_limit = node_meta.at("queue_bytes_limit").get<int64_t>();
+    if (node_meta.count("queue_length_min"))
+        queue_length_min = node_meta.at("queue_length_min").get<uint32_t>();
+    if (node_meta.count("queue_length_max"))
+        queue_length_max = node_meta.at("queue_length_max").get<uint32_t>();
+    if (node_meta.count("max_batch"))
+        max_batch = std::max(node_meta.at("max_batch").get<uint32_t>(), 1u);
+    if (node_meta.count("priority"))
+        priority = node_meta.at("priority").get<int32_t>();
+    if (node_meta.count("drop_expired"))
+        drop_expired = node_meta.at("drop_expired").get<bool>();
+    if (node_meta.count("module_pool"))
+        module_pool = node_meta.at("module_pool").get<bool>();
 }
 
 int32_t NodeMetaInfo::get_premodule_id() { return premodule_id; }
@@ -151,6 +170,20 @@ int32_t NodeMetaInfo::get_bundle() { return bundle; }
 
 uint32_t NodeMetaInfo::get_queue_size_limit() { return queue_size_limit; }
 
+int64_t NodeMetaInfo::get_queue_bytes_limit() { return queue_bytes_limit; }
+
+uint32_t NodeMetaInfo::get_queue_length_min() { return queue_length_min; }
+
+uint32_t NodeMetaInfo::get_queue_length_max() { return queue_length_max; }
+
+uint32_t NodeMetaInfo::get_max_batch() { return max_batch; }
+
+int32_t NodeMetaInfo::get_priority() { return priority; }
+
+bool NodeMetaInfo::get_drop_expired() { return drop_expired; }
+
+bool NodeMetaInfo::get_module_pool() { return module_pool; }
+
 std::map<int64_t, uint32_t> NodeMetaInfo::get_callback_binding() {
     return callback_binding;
 }
@@ -158,6 +191,20 @@ std::map<int64_t, uint32_t> NodeMetaInfo::get_callback_binding() {
 nlohmann::json NodeMetaInfo::to_json() {
     nlohmann::json json_meta_info;
     json_meta_info["premodule_id"] = premodule_id;
+    if (queue_bytes_limit > 0)
+        json_meta_info["queue_bytes_limit"] = queue_bytes_limit;
+    if (queue_length_max > queue_length_min) {
+        json_meta_info["queue_length_min"] = queue_length_min;
+        json_meta_info["queue_length_max"] = queue_length_max;
+    }
+    if (max_batch > 1)
+        json_meta_info["max_batch"] = max_batch;
+    if (priority != 0)
+        json_meta_info["priority"] = priority;
+    if (drop_expired)
+        json_meta_info["drop_expired"] = drop_expired;
+    if (module_pool)
+        json_meta_info["module_pool"] = module_pool;
     json_meta_info["callback_binding"] =
         nlohmann::json(std::vector<std::string>());
     for (auto &it : callback_binding) {
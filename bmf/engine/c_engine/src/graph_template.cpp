@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/graph_template.h"
+#include "../include/optimizer.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+std::mutex cache_mutex;
+std::unordered_map<std::string, std::shared_ptr<GraphTemplate>> cache;
+
+} // namespace
+
+GraphTemplate::GraphTemplate(GraphConfig graph_config, bool need_merge)
+    : graph_config_(std::move(graph_config)) {
+    // the modules made to tell subgraphs apart are not kept, the nodes of an
+    // instance create theirs or take them from the ModulePool
+    std::map<int, std::shared_ptr<Module>> created_modules;
+    Optimizer::subgraph_preprocess(graph_config_, created_modules);
+    created_modules.clear();
+    Optimizer::process_distributed_node(graph_config_.nodes);
+    Optimizer::convert_filter_para_for_graph(graph_config_.nodes);
+    if (need_merge)
+        Optimizer::optimize(graph_config_.nodes);
+    Optimizer::replace_stream_name_for_graph(graph_config_.nodes);
+}
+
+GraphConfig
+GraphTemplate::instantiate(std::map<int, JsonParam> const &node_options) const {
+    GraphConfig graph_config = graph_config_;
+    for (auto &it : node_options) {
+        auto node = std::find_if(
+            graph_config.nodes.begin(), graph_config.nodes.end(),
+            [&it](NodeConfig &node) { return node.get_id() == it.first; });
+        if (node == graph_config.nodes.end())
+            throw std::logic_error("node " + std::to_string(it.first) +
+                                   " is not in the graph template");
+        node->set_option(it.second);
+    }
+    return graph_config;
+}
+
+std::shared_ptr<GraphTemplate>
+GraphTemplate::get(std::string const &graph_config, bool need_merge) {
+    std::string key = (need_merge ? "1" : "0") + graph_config;
+    {
+        std::lock_guard<std::mutex> guard(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return it->second;
+    }
+    // prepared outside of the lock, it may load modules, the first of two
+    // racing callers wins
+    auto graph_json = nlohmann::json::parse(graph_config);
+    auto graph_template =
+        std::make_shared<GraphTemplate>(GraphConfig(graph_json), need_merge);
+    std::lock_guard<std::mutex> guard(cache_mutex);
+    return cache.emplace(key, graph_template).first->second;
+}
+
+void GraphTemplate::clear_cache() {
+    std::lock_guard<std::mutex> guard(cache_mutex);
+    cache.clear();
+}
+
+END_BMF_ENGINE_NS
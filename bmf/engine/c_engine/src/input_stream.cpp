@@ -16,12 +16,55 @@
 #include "../include/input_stream.h"
 
 #include <bmf/sdk/log.h>
+#include <bmf/sdk/audio_frame.h>
+#include <bmf/sdk/bmf_av_packet.h>
+#include <bmf/sdk/video_frame.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
 
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t packet_nbytes(Packet const &pkt) {
+    if (!pkt)
+        return 0;
+    if (pkt.is<VideoFrame>()) {
+        auto &vf = pkt.get<VideoFrame>();
+        if (!vf)
+            return 0;
+        int64_t nbytes = 0;
+        for (int64_t p = 0; p < vf.frame().nplanes(); p++)
+            nbytes += vf.frame().plane(p).nbytes();
+        return nbytes;
+    }
+    if (pkt.is<AudioFrame>()) {
+        auto &af = pkt.get<AudioFrame>();
+        if (!af)
+            return 0;
+        int64_t nbytes = 0;
+        for (auto &plane : af.planes())
+            nbytes += plane.nbytes();
+        return nbytes;
+    }
+    if (pkt.is<BMFAVPacket>())
+        return pkt.get<BMFAVPacket>().nbytes();
+    if (pkt.is<hmp::Tensor>()) {
+        auto &tensor = pkt.get<hmp::Tensor>();
+        return tensor.defined() ? tensor.nbytes() : 0;
+    }
+    if (pkt.is<std::string>())
+        return pkt.get<std::string>().size();
+    return 0;
+}
+
 InputStream::InputStream(int stream_id, std::string const &identifier,
                          std::string const &alias, std::string const &notify,
                          int node_id,
@@ -66,28 +109,94 @@ InputStream::InputStream(int stream_id, StreamConfig &stream_config,
 
 int InputStream::add_packets(std::shared_ptr<SafeQueue<Packet>> &packets) {
     Packet pkt;
-    while (packets->pop(pkt)) {
-        queue_->push(pkt);
-        // advance time bounding
-        next_time_bounding_ = pkt.timestamp() + 1;
-        // if received EOS, set stream done
-        // here we can't use pkt.get_timestamp() + 1 since
-        // Timestamp.DONE = Timestamp.EOS + 2
-        if (pkt.timestamp() == EOS or pkt.timestamp() == BMF_EOF) {
-            next_time_bounding_ = DONE;
-            BMFLOG_NODE(BMF_INFO, node_id_) << "eof received";
-            // add node to scheduler thread until this EOS is processed
-            // graph_output_stream may not have attribute node
-            // if (node_id_ >= 0) {
-            //    throttled_cb_(node_id_, true);
-            //}
-        }
-        // wake up event
-        fill_packet_event_.notify_all();
-    }
+    while (packets->pop(pkt))
+        add_packet(pkt);
+    if (min_queue_size_ < max_queue_size_limit_ && is_full())
+        full_hit_ = true;
+    return 0;
+}
+
+int InputStream::add_packets(PacketBatch const &packets) {
+    for (auto &pkt : *packets)
+        add_packet(pkt);
+    if (min_queue_size_ < max_queue_size_limit_ && is_full())
+        full_hit_ = true;
     return 0;
 }
 
+void InputStream::add_packet(Packet const &pkt) {
+    if (max_queue_bytes_ > 0)
+        queue_bytes_ += packet_nbytes(pkt);
+    queue_->push(pkt);
+    // advance time bounding
+    next_time_bounding_ = pkt.timestamp() + 1;
+    // if received EOS, set stream done
+    // here we can't use pkt.get_timestamp() + 1 since
+    // Timestamp.DONE = Timestamp.EOS + 2
+    if (pkt.timestamp() == EOS or pkt.timestamp() == BMF_EOF) {
+        next_time_bounding_ = DONE;
+        BMFLOG_NODE(BMF_INFO, node_id_) << "eof received";
+        // add node to scheduler thread until this EOS is processed
+        // graph_output_stream may not have attribute node
+        // if (node_id_ >= 0) {
+        //    throttled_cb_(node_id_, true);
+        //}
+    }
+    // wake up event
+    fill_packet_event_.notify_all();
+}
+
+void InputStream::account_pop(Packet const &pkt) {
+    if (max_queue_bytes_ > 0)
+        queue_bytes_ -= packet_nbytes(pkt);
+    if (min_queue_size_ < max_queue_size_limit_) {
+        if (queue_->empty())
+            empty_hit_ = true;
+        adapt_queue_size();
+    }
+}
+
+void InputStream::set_queue_limit(int64_t max_bytes, int min_size,
+                                  int max_size) {
+    max_queue_bytes_ = max_bytes;
+    min_queue_size_ = std::max(min_size, 1);
+    max_queue_size_limit_ = std::max(max_size, min_queue_size_);
+    if (min_queue_size_ < max_queue_size_limit_) {
+        max_queue_size_ = std::min(
+            std::max(max_queue_size_.load(), min_queue_size_),
+            max_queue_size_limit_);
+        next_adapt_ = now_ns() + adapt_period_;
+    }
+}
+
+// Called on the consumer side, at most once per adapt_period_. A queue which
+// got full and was also drained sees bursts the consumer can keep up with,
+// it doubles so the producer can run ahead. A queue which got full but never
+// drained has a producer outpacing its consumer, extra depth would only add
+// latency and memory, so it shrinks by one.
+void InputStream::adapt_queue_size() {
+    int64_t now = now_ns();
+    int64_t next_adapt = next_adapt_;
+    if (now < next_adapt ||
+        !next_adapt_.compare_exchange_strong(next_adapt, now + adapt_period_))
+        return;
+    bool full = full_hit_.exchange(false);
+    bool empty = empty_hit_.exchange(false);
+    if (!full)
+        return;
+    int size = max_queue_size_;
+    if (empty)
+        size = std::min(size * 2, max_queue_size_limit_);
+    else
+        size = std::max(size - 1, min_queue_size_);
+    if (size != max_queue_size_) {
+        BMFLOG_NODE(BMF_DEBUG, node_id_)
+            << "stream " << identifier_ << " queue limit "
+            << max_queue_size_.load() << " -> " << size;
+        max_queue_size_ = size;
+    }
+}
+
 Packet InputStream::pop_packet_at_timestamp(int64_t timestamp) {
     // TODO return the exactly same timestamp or the most closest one
     Packet pkt;
@@ -96,11 +205,12 @@ Packet InputStream::pop_packet_at_timestamp(int64_t timestamp) {
         int64_t queue_front_timestamp = temp_pkt.timestamp();
         if (queue_front_timestamp <= timestamp) {
             queue_->pop(pkt);
+            account_pop(pkt);
         } else {
             break;
         }
     }
-    if (pkt.timestamp() == EOS or pkt.timestamp() == BMF_EOF) {
+    if (pkt && (pkt.timestamp() == EOS or pkt.timestamp() == BMF_EOF)) {
         // EOS is popped, remove node from scheduler thread
         BMFLOG_NODE(BMF_INFO, node_id_)
             << "eof processed, remove node from scheduler";
@@ -127,11 +237,17 @@ void InputStream::wait_on_empty() {
 
 int64_t InputStream::get_time_bounding() { return next_time_bounding_; }
 
+void InputStream::advance_time_bounding(int64_t timestamp) {
+    if (next_time_bounding_ != DONE && timestamp + 1 > next_time_bounding_)
+        next_time_bounding_ = timestamp + 1;
+}
+
 int InputStream::get_id() { return stream_id_; }
 
 Packet InputStream::pop_next_packet(bool block) {
     Packet pkt;
     if (queue_->pop(pkt)) {
+        account_pop(pkt);
         if (pkt.timestamp() == EOS or pkt.timestamp() == BMF_EOF) {
             // EOS is popped, remove node from scheduler thread
             BMFLOG_NODE(BMF_INFO, node_id_)
@@ -151,12 +267,16 @@ Packet InputStream::pop_next_packet(bool block) {
                 fill_packet_event_.wait_for(lk, std::chrono::milliseconds(5));
             }
         }
-        queue_->pop(pkt);
+        if (queue_->pop(pkt))
+            account_pop(pkt);
     }
     return pkt;
 }
 
-bool InputStream::is_full() { return queue_->size() >= max_queue_size_; }
+bool InputStream::is_full() {
+    return queue_->size() >= max_queue_size_ ||
+           (max_queue_bytes_ > 0 && queue_bytes_ >= max_queue_bytes_);
+}
 
 void InputStream::set_connected(bool connected) { connected_ = connected; }
 
@@ -172,7 +292,9 @@ void InputStream::clear_queue() {
     Packet pkt;
     while (not queue_->empty()) {
         queue_->pop(pkt);
+        drop_cnt_++;
     }
+    queue_bytes_ = 0;
 }
 
 bool InputStream::get_min_timestamp(int64_t &min_timestamp) {
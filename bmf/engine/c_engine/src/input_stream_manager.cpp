@@ -33,7 +33,8 @@ InputStreamManager::InputStreamManager(int node_id,
                                        uint32_t max_queue_size,
                                        InputStreamManagerCallBack &callback)
     : node_id_(node_id), callback_(callback),
-      output_stream_id_list_(output_stream_id_list) {
+      output_stream_id_list_(output_stream_id_list),
+      max_queue_size_(max_queue_size) {
     std::function<void(int, bool)>
         empt; // no need to send callback to input streamer now
     for (auto i = 0; i < input_streams.size(); ++i) {
@@ -60,15 +61,28 @@ int InputStreamManager::add_stream(std::string name, int id) {
     max_id_ += 1;
     stream_id = max_id_;
 
-    int max_queue_size = 5;
     input_streams_[stream_id] = std::make_shared<InputStream>(
-        stream_id, name, "", "", id, callback_.sched_required, max_queue_size);
+        stream_id, name, "", "", id, callback_.sched_required, max_queue_size_);
+    if (max_queue_bytes_ > 0 || min_queue_size_ < max_queue_size_limit_)
+        input_streams_[stream_id]->set_queue_limit(
+            max_queue_bytes_, min_queue_size_, max_queue_size_limit_);
     // list add to ensure the queue can be picked up into the task
     stream_id_list_.push_back(stream_id);
 
     return stream_id;
 }
 
+// byte budget and adaptive length bounds of every input stream, equal
+// bounds keep the length limit fixed
+void InputStreamManager::set_queue_limit(int64_t max_bytes, int min_size,
+                                         int max_size) {
+    max_queue_bytes_ = max_bytes;
+    min_queue_size_ = min_size;
+    max_queue_size_limit_ = max_size;
+    for (auto &input_stream : input_streams_)
+        input_stream.second->set_queue_limit(max_bytes, min_size, max_size);
+}
+
 int InputStreamManager::remove_stream(int stream_id) {
     std::lock_guard<std::mutex> _(mtx_);
 
@@ -101,10 +115,20 @@ bool InputStreamManager::schedule_node() {
     NodeReadiness node_readiness = get_node_readiness(min_timestamp);
     if (node_readiness == NodeReadiness::READY_FOR_PROCESS) {
 
-        Task task = Task(node_id_, stream_id_list_, output_stream_id_list_);
+        Task task = task_pool_.acquire(node_id_, stream_id_list_,
+                                       output_stream_id_list_);
         task.set_timestamp(min_timestamp);
 
+        std::vector<std::shared_ptr<InputStream>> full_streams;
+        if (track_backpressure_)
+            for (auto &input_stream : input_streams_)
+                if (input_stream.second->is_full())
+                    full_streams.push_back(input_stream.second);
+
         bool result = fill_task_input(task);
+        for (auto &input_stream : full_streams)
+            if (!input_stream->is_full())
+                backpressure_released_ = true;
         if (not result) {
             BMFLOG_NODE(BMF_INFO, node_id_) << "Failed to fill packet to task";
             return false;
@@ -140,6 +164,33 @@ void InputStreamManager::add_packets(
     }
 }
 
+void InputStreamManager::add_packets(int stream_id,
+                                     PacketBatch const &packets) {
+    if (callback_.node_is_closed_cb != NULL && callback_.node_is_closed_cb())
+        return;
+    if (packets->empty())
+        return;
+    auto it = input_streams_.find(stream_id);
+    if (it != input_streams_.end()) {
+        it->second->add_packets(packets);
+        if (callback_.sched_required != NULL)
+            callback_.sched_required(node_id_, false);
+    }
+}
+
+// lets a synced node go on with the timestamps up to it on its other streams
+void InputStreamManager::advance_time_bounding(int stream_id,
+                                               int64_t timestamp) {
+    if (callback_.node_is_closed_cb != NULL && callback_.node_is_closed_cb())
+        return;
+    auto it = input_streams_.find(stream_id);
+    if (it != input_streams_.end()) {
+        it->second->advance_time_bounding(timestamp);
+        if (callback_.sched_required != NULL)
+            callback_.sched_required(node_id_, false);
+    }
+}
+
 Packet InputStreamManager::pop_next_packet(int stream_id, bool block) {
     if (input_streams_.count(stream_id)) {
         auto stream = input_streams_[stream_id];
@@ -246,14 +297,27 @@ NodeReadiness DefaultInputManager::get_node_readiness(int64_t &min_timestamp) {
 }
 
 bool DefaultInputManager::fill_task_input(Task &task) {
-    for (auto &input_stream : input_streams_) {
-        auto pkt =
-            input_stream.second->pop_packet_at_timestamp(task.timestamp());
-        if (pkt.timestamp() == UNSET) {
-            continue;
+    for (uint32_t batch = 0; batch < max_batch_; batch++) {
+        if (batch > 0) {
+            // keep packing while the next timestamp is already complete,
+            // eof and other control timestamps are left to their own task
+            int64_t next_timestamp;
+            if (get_node_readiness(next_timestamp) !=
+                    NodeReadiness::READY_FOR_PROCESS ||
+                next_timestamp >= BMF_PAUSE)
+                break;
+            task.set_timestamp(next_timestamp);
+        }
+        for (auto &input_stream : input_streams_) {
+            auto pkt =
+                input_stream.second->pop_packet_at_timestamp(task.timestamp());
+            // a stream may have no packet at a timestamp its upstream dropped
+            if (!pkt || pkt.timestamp() == UNSET) {
+                continue;
+            }
+            if (not task.fill_input_packet(input_stream.second->get_id(), pkt))
+                return false;
         }
-        if (not task.fill_input_packet(input_stream.second->get_id(), pkt))
-            return false;
     }
     return true;
 }
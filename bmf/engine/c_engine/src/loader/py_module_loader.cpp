@@ -192,11 +192,11 @@ class PyModuleFactory : public ModuleFactoryI {
     }
 
     const bool module_info(ModuleInfo &info) const override {
+        py::gil_scoped_acquire gil;
         auto [_, module_register] = factory_();
         if (module_register.is_none())
             return false;
 
-        py::gil_scoped_acquire gil;
         module_register(&info);
         return true;
     }
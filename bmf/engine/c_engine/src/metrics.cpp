@@ -0,0 +1,378 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/metrics.h"
+
+#include <bmf/sdk/log.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+BEGIN_BMF_ENGINE_NS
+
+constexpr int MetricHistogram::BUCKET_NUM;
+
+const int64_t MetricHistogram::bounds_ns[BUCKET_NUM] = {
+    10000,     25000,     50000,      100000,     250000,
+    500000,    1000000,   2500000,    5000000,    10000000,
+    25000000,  50000000,  100000000,  250000000,  500000000,
+    1000000000, 2500000000, 5000000000, 10000000000};
+
+void MetricHistogram::observe(int64_t ns) {
+    int bucket = std::lower_bound(bounds_ns, bounds_ns + BUCKET_NUM, ns) -
+                 bounds_ns;
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+constexpr int LatencyHistogram::BUCKET_NUM;
+
+int LatencyHistogram::bucket(int64_t ns) {
+    if (ns < (2 << SUB_BITS))
+        return ns < 0 ? 0 : int(ns);
+    int exp = 63 - __builtin_clzll(uint64_t(ns));
+    return ((exp - SUB_BITS + 1) << SUB_BITS) +
+           int((ns >> (exp - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+}
+
+void LatencyHistogram::observe(int64_t ns) {
+    buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double q) const {
+    int64_t counts[BUCKET_NUM];
+    int64_t total = 0;
+    for (int i = 0; i < BUCKET_NUM; i++)
+        total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    if (total == 0)
+        return 0;
+    int64_t rank = std::max<int64_t>(1, int64_t(std::ceil(q * total)));
+    int i = 0;
+    for (int64_t seen = counts[0]; seen < rank; seen += counts[++i])
+        ;
+    if (i < (2 << SUB_BITS))
+        return i;
+    int shift = (i >> SUB_BITS) - 1;
+    int64_t lower = int64_t((1 << SUB_BITS) + (i & ((1 << SUB_BITS) - 1)))
+                    << shift;
+    return lower + (int64_t(1) << shift) / 2;
+}
+
+MetricsRegistry::~MetricsRegistry() { stop_listen(); }
+
+void MetricsRegistry::add(std::string const &name, std::string const &help,
+                          std::string const &type, Sample sample) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto &family : families_) {
+        if (family.name != name)
+            continue;
+        // registering the same series again replaces it
+        for (auto &it : family.samples) {
+            if (it.owner == sample.owner && it.labels == sample.labels) {
+                it = std::move(sample);
+                return;
+            }
+        }
+        family.samples.push_back(std::move(sample));
+        return;
+    }
+    families_.push_back({name, help, type, {std::move(sample)}});
+}
+
+void MetricsRegistry::add_counter(std::string const &name,
+                                  std::string const &help,
+                                  Labels const &labels,
+                                  std::function<double()> read,
+                                  const void *owner) {
+    add(name, help, "counter", {labels, std::move(read), nullptr, nullptr, owner});
+}
+
+void MetricsRegistry::add_gauge(std::string const &name,
+                                std::string const &help, Labels const &labels,
+                                std::function<double()> read,
+                                const void *owner) {
+    add(name, help, "gauge", {labels, std::move(read), nullptr, nullptr, owner});
+}
+
+void MetricsRegistry::add_histogram(std::string const &name,
+                                    std::string const &help,
+                                    Labels const &labels,
+                                    const MetricHistogram *histogram,
+                                    const void *owner) {
+    add(name, help, "histogram",
+        {labels, nullptr, histogram, nullptr, owner});
+}
+
+void MetricsRegistry::add_summary(std::string const &name,
+                                  std::string const &help,
+                                  Labels const &labels,
+                                  const LatencyHistogram *histogram,
+                                  const void *owner) {
+    add(name, help, "summary", {labels, nullptr, nullptr, histogram, owner});
+}
+
+void MetricsRegistry::remove(const void *owner) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto &family : families_) {
+        auto &samples = family.samples;
+        samples.erase(std::remove_if(samples.begin(), samples.end(),
+                                     [owner](Sample const &sample) {
+                                         return sample.owner == owner;
+                                     }),
+                      samples.end());
+    }
+}
+
+void MetricsRegistry::clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    families_.clear();
+}
+
+static void write_labels(std::ostringstream &out,
+                         MetricsRegistry::Labels const &labels,
+                         std::string const &le = "",
+                         const char *le_name = "le") {
+    if (labels.empty() && le.empty())
+        return;
+    out << '{';
+    bool first = true;
+    for (auto &label : labels) {
+        if (!first)
+            out << ',';
+        first = false;
+        out << label.first << "=\"";
+        for (char c : label.second) {
+            if (c == '\\' || c == '"')
+                out << '\\' << c;
+            else if (c == '\n')
+                out << "\\n";
+            else
+                out << c;
+        }
+        out << '"';
+    }
+    if (!le.empty())
+        out << (first ? "" : ",") << le_name << "=\"" << le << '"';
+    out << '}';
+}
+
+static void write_value(std::ostringstream &out, double value) {
+    if (std::isnan(value))
+        out << "NaN";
+    else if (value == std::floor(value) && std::fabs(value) < 1e15)
+        out << int64_t(value);
+    else
+        out << value;
+}
+
+std::string MetricsRegistry::export_text() {
+    std::ostringstream out;
+    out.precision(9);
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto &family : families_) {
+        if (family.samples.empty())
+            continue;
+        out << "# HELP " << family.name << ' ' << family.help << '\n';
+        out << "# TYPE " << family.name << ' ' << family.type << '\n';
+        for (auto &sample : family.samples) {
+            if (sample.summary) {
+                auto summary = sample.summary;
+                for (auto q : {"0.5", "0.99", "0.999"}) {
+                    out << family.name;
+                    write_labels(out, sample.labels, q, "quantile");
+                    out << ' ' << summary->percentile(std::stod(q)) / 1e9
+                        << '\n';
+                }
+                out << family.name << "_sum";
+                write_labels(out, sample.labels);
+                out << ' '
+                    << summary->sum_ns_.load(std::memory_order_relaxed) / 1e9
+                    << '\n';
+                out << family.name << "_count";
+                write_labels(out, sample.labels);
+                out << ' ' << summary->count_.load(std::memory_order_relaxed)
+                    << '\n';
+                continue;
+            }
+            if (!sample.histogram) {
+                out << family.name;
+                write_labels(out, sample.labels);
+                out << ' ';
+                write_value(out, sample.read());
+                out << '\n';
+                continue;
+            }
+            // buckets are cumulative, the count is read last so it is never
+            // below the +Inf bucket of the same export
+            auto histogram = sample.histogram;
+            int64_t cumulative = 0;
+            for (int i = 0; i <= MetricHistogram::BUCKET_NUM; i++) {
+                cumulative +=
+                    histogram->buckets_[i].load(std::memory_order_relaxed);
+                std::ostringstream le;
+                if (i < MetricHistogram::BUCKET_NUM)
+                    le << MetricHistogram::bounds_ns[i] / 1e9;
+                else
+                    le << "+Inf";
+                out << family.name << "_bucket";
+                write_labels(out, sample.labels, le.str());
+                out << ' ' << cumulative << '\n';
+            }
+            out << family.name << "_sum";
+            write_labels(out, sample.labels);
+            out << ' '
+                << histogram->sum_ns_.load(std::memory_order_relaxed) / 1e9
+                << '\n';
+            out << family.name << "_count";
+            write_labels(out, sample.labels);
+            out << ' ' << cumulative << '\n';
+        }
+    }
+    return out.str();
+}
+
+int MetricsRegistry::listen(std::string const &address) {
+#ifndef _WIN32
+    stop_listen();
+    int fd = -1;
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::string path = address.substr(5);
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            BMFLOG(BMF_ERROR) << "invalid metrics socket path: " << path;
+            return -1;
+        }
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+            BMFLOG(BMF_ERROR) << "failed to bind metrics socket " << path
+                              << ": " << std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            return -1;
+        }
+        unix_path_ = path;
+    } else {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        auto colon = address.rfind(':');
+        std::string host = "127.0.0.1";
+        if (colon != std::string::npos && colon > 0)
+            host = address.substr(0, colon);
+        int port = std::atoi(address.substr(colon + 1).c_str());
+        if (port <= 0 || port > 65535 ||
+            inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            BMFLOG(BMF_ERROR) << "invalid metrics address: " << address;
+            return -1;
+        }
+        addr.sin_port = htons(port);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+            BMFLOG(BMF_ERROR) << "failed to bind metrics address " << address
+                              << ": " << std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            return -1;
+        }
+    }
+    if (::listen(fd, 8) != 0) {
+        BMFLOG(BMF_ERROR) << "failed to listen on " << address;
+        ::close(fd);
+        return -1;
+    }
+    listen_fd_ = fd;
+    listening_ = true;
+    listen_thread_ = std::thread(&MetricsRegistry::serve, this);
+    BMFLOG(BMF_INFO) << "metrics served on " << address;
+    return 0;
+#else
+    BMFLOG(BMF_WARNING) << "metrics listener is not supported on windows";
+    return -1;
+#endif
+}
+
+void MetricsRegistry::serve() {
+#ifndef _WIN32
+    while (listening_) {
+        // wake up now and then to see if the listener was stopped
+        pollfd pfd = {listen_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        int conn = accept(listen_fd_, nullptr, nullptr);
+        if (conn < 0)
+            continue;
+        // the request is not looked at, every path gets the metrics
+        char buf[1024];
+        pollfd cfd = {conn, POLLIN, 0};
+        if (poll(&cfd, 1, 100) > 0)
+            recv(conn, buf, sizeof(buf), 0);
+        std::string body = export_text();
+        std::string response =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: " +
+            std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            auto n = send(conn, response.data() + sent,
+                          response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+        ::close(conn);
+    }
+#endif
+}
+
+void MetricsRegistry::stop_listen() {
+#ifndef _WIN32
+    if (!listening_.exchange(false))
+        return;
+    if (listen_thread_.joinable())
+        listen_thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    if (!unix_path_.empty())
+        unlink(unix_path_.c_str());
+    unix_path_.clear();
+#endif
+}
+
+END_BMF_ENGINE_NS
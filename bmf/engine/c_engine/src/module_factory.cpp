@@ -34,7 +34,8 @@ ModuleInfo ModuleFactory::create_module(std::string module_name, int node_id,
                                         std::string module_type,
                                         std::string module_path,
                                         std::string module_entry,
-                                        std::shared_ptr<Module> &module) {
+                                        std::shared_ptr<Module> &module,
+                                        bool query_info) {
     auto &M = bmf_sdk::ModuleManager::instance();
 
     ModuleInfo module_info;
@@ -45,6 +46,10 @@ ModuleInfo ModuleFactory::create_module(std::string module_name, int node_id,
             fmt::format("create module {} failed", module_name));
     }
     module = factory->make(node_id, option);
+    // registered info (description, tag, batching) is only looked up when
+    // the caller needs it, as it may import the module again
+    if (query_info)
+        factory->module_info(module_info);
     return module_info;
 }
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/module_pool.h"
+#include "../include/module_factory.h"
+
+#include <bmf/sdk/log.h>
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+ModulePool &ModulePool::instance() {
+    static ModulePool pool;
+    return pool;
+}
+
+// batching nodes also look up the registered module info
+std::string ModulePool::key(NodeConfig &node_config) {
+    return node_config.get_module_info().to_json().dump() + '\n' +
+           node_config.get_option().dump() +
+           (node_config.get_node_meta().get_max_batch() > 1 ? "\nbatch" : "");
+}
+
+std::shared_ptr<Module> ModulePool::acquire(NodeConfig &node_config,
+                                            ModuleInfo &module_info) {
+    auto k = key(node_config);
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = free_.find(k);
+    if (it == free_.end() || it->second.empty())
+        return nullptr;
+    auto entry = std::move(it->second.back());
+    it->second.pop_back();
+    module_info = entry.module_info;
+    return entry.module;
+}
+
+void ModulePool::release(NodeConfig &node_config,
+                         std::shared_ptr<Module> module,
+                         ModuleInfo const &module_info) {
+    if (!module)
+        return;
+    // not kept if still held elsewhere, e.g. by a callback of the old graph
+    if (module.use_count() == 1) {
+        auto k = key(node_config);
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto &entries = free_[k];
+        if (entries.size() < max_free_) {
+            entries.push_back({std::move(module), module_info});
+            return;
+        }
+    }
+    // was reset instead of closed by its node
+    module->close();
+}
+
+void ModulePool::prepare(NodeConfig &node_config, int count) {
+    auto k = key(node_config);
+    auto config = node_config.get_module_info();
+    auto option = node_config.get_option();
+    for (int i = 0; i < count; i++) {
+        Entry entry;
+        entry.module_info = ModuleFactory::create_module(
+            config.module_name, node_config.get_id(), option,
+            config.module_type, config.module_path, config.module_entry,
+            entry.module, true);
+        if (!entry.module_info.module_reusable) {
+            BMFLOG(BMF_WARNING) << config.module_name
+                                << " does not declare module_reusable, "
+                                   "not pooled";
+            return;
+        }
+        entry.module->init();
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            auto &entries = free_[k];
+            if (entries.size() < max_free_) {
+                entries.push_back(std::move(entry));
+                continue;
+            }
+        }
+        entry.module->close();
+        return;
+    }
+    BMFLOG(BMF_INFO) << "module pool prepared " << count << " "
+                     << config.module_name;
+}
+
+void ModulePool::set_max_free(size_t max_free) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    max_free_ = max_free;
+}
+
+size_t ModulePool::size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    size_t n = 0;
+    for (auto &it : free_)
+        n += it.second.size();
+    return n;
+}
+
+void ModulePool::clear() {
+    std::unordered_map<std::string, std::vector<Entry>> free;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        free.swap(free_);
+    }
+    // pooled modules were reset, not closed
+    for (auto &it : free)
+        for (auto &entry : it.second)
+            entry.module->close();
+}
+
+END_BMF_ENGINE_NS
@@ -17,10 +17,14 @@
 #include "../include/node.h"
 #include "../include/input_stream_manager.h"
 #include "../include/module_factory.h"
+#include "../include/module_pool.h"
 #include "../include/callback_layer.h"
+#include "../include/split_module.h"
+#include "../include/scheduler_queue.h"
 
 #include <bmf/sdk/log.h>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -39,12 +43,16 @@ Node::Node(int node_id, NodeConfig &node_config, NodeCallBack &node_callback,
     node_name_ = "Node_" + std::to_string(id_) + "_" + module_name_;
 
 #ifndef NO_TRACE
+    trace_name_ = TraceNames::intern(node_name_.c_str());
     TraceProcessEmitter trace_emitter =
-        TraceProcessEmitter(PROCESSING, node_name_);
+        TraceProcessEmitter(PROCESSING, trace_name_);
 #endif
 
     is_source_ = node_config.input_streams.empty();
     queue_size_limit_ = node_config_.get_node_meta().get_queue_size_limit();
+    priority_ = node_config_.get_node_meta().get_priority();
+    drop_expired_ = node_config_.get_node_meta().get_drop_expired();
+    latency_tracking_ = bool(callback_.latency_path_added);
     // pending task means the task has been added to scheduler queue
     // but haven't been executed, for source node, we need use this
     // value to control task filling speed
@@ -55,14 +63,21 @@ Node::Node(int node_id, NodeConfig &node_config, NodeCallBack &node_callback,
            queue_size_limit_);
     task_processed_cnt_ = 0;
     is_premodule_ = false;
+    uint32_t max_batch = node_config_.get_node_meta().get_max_batch();
 
-    if (pre_allocated_module == nullptr) {
+    pooled_ = node_config_.get_node_meta().get_module_pool();
+    if (pre_allocated_module == nullptr && pooled_)
+        module_ = ModulePool::instance().acquire(node_config_, module_info_);
+    if (module_) {
+        // initialised by an earlier graph and reset since
+        module_->node_id_ = node_id;
+    } else if (pre_allocated_module == nullptr) {
         is_premodule_ = false;
         JsonParam node_option_param = node_config_.get_option();
         module_info_ = ModuleFactory::create_module(
             type_, id_, node_option_param, node_config_.module.module_type,
             node_config_.module.module_path, node_config_.module.module_entry,
-            module_);
+            module_, max_batch > 1 || pooled_);
 
         BMF_TRACE_PROCESS(module_name_.c_str(), "init", START);
         module_->init();
@@ -104,6 +119,48 @@ Node::Node(int node_id, NodeConfig &node_config, NodeCallBack &node_callback,
                                 output_stream_manager_->get_stream_id_list(),
                                 callback, queue_size_limit_,
                                 input_stream_manager_);
+    input_stream_manager_->track_backpressure_ =
+        callback_.release_upstream != nullptr;
+    auto node_meta = node_config_.get_node_meta();
+    if (node_meta.get_queue_bytes_limit() > 0 ||
+        node_meta.get_queue_length_max() > node_meta.get_queue_length_min())
+        input_stream_manager_->set_queue_limit(
+            node_meta.get_queue_bytes_limit(),
+            node_meta.get_queue_length_min(),
+            node_meta.get_queue_length_max());
+    // batching is only allowed if the module declares it can take several
+    // timestamps per task, pre-allocated modules have no registered info
+    if (max_batch > 1) {
+        input_stream_manager_->max_batch_ = std::min<uint32_t>(
+            max_batch, std::max(module_info_.module_max_batch, 1));
+        BMFLOG_NODE(BMF_INFO, id_)
+            << "max batch " << input_stream_manager_->max_batch_;
+    }
+
+    // split node of a distributed node, the replicas are the only mirrors
+    // of its output streams
+    if (auto split = std::dynamic_pointer_cast<SplitModule>(module_)) {
+        split->load_probe_ = [this](int stream_id) {
+            ReplicaLoad load;
+            auto &streams = this->output_stream_manager_->output_streams_;
+            auto it = streams.find(stream_id);
+            if (it == streams.end())
+                return load;
+            for (auto &mirror : it->second->mirror_streams_) {
+                auto &manager = mirror.input_stream_manager_;
+                auto input = manager->input_streams_.find(mirror.stream_id_);
+                if (input != manager->input_streams_.end())
+                    load.queued += input->second->queue_->size();
+                std::shared_ptr<Node> node;
+                if (this->callback_.get_node(manager->node_id_, node) == 0 &&
+                    node) {
+                    std::lock_guard<std::recursive_mutex> guard(node->mutex_);
+                    load.pending_tasks += node->pending_tasks_;
+                }
+            }
+            return load;
+        };
+    }
 
     // register hungry_check
     for (auto stream_id : input_stream_manager_->stream_id_list_) {
@@ -154,13 +211,25 @@ std::string Node::get_action() { return node_config_.get_action(); }
 
 void Node::set_source(bool flag) { is_source_ = flag; }
 
+Node::~Node() {
+    if (pooled_ && reusable_)
+        ModulePool::instance().release(node_config_, std::move(module_),
+                                       module_info_);
+}
+
 int Node::close() {
     mutex_.lock();
     // callback_.throttled_cb(id_, false);
     for (auto &input_stream : input_stream_manager_->input_streams_)
         if (input_stream.second->is_full())
             input_stream.second->clear_queue();
-    if (!is_premodule_) {
+    if (pooled_ && !is_premodule_ && state_ != NodeState::CLOSED) {
+        // handed to the next graph when this one is gone, see ~Node(), if
+        // the module declares it can be reset and the reset works
+        reusable_ = module_info_.module_reusable && module_->reset() == 0;
+        if (!reusable_)
+            module_->close();
+    } else if (!pooled_ && !is_premodule_) {
         module_->close();
     }
     state_ = NodeState::CLOSED;
@@ -231,9 +300,23 @@ int64_t Node::get_source_timestamp() {
     return source_timestamp_;
 }
 
+// Every scheduling attempt looks here, so the time from the first attempt
+// which found a downstream queue full to the first one which did not is
+// counted as blocked on backpressure.
 bool Node::any_of_downstream_full() {
-
-    return output_stream_manager_->any_of_downstream_full();
+    bool full = output_stream_manager_->any_of_downstream_full();
+    if (full) {
+        int64_t unblocked = 0;
+        if (blocked_since_.load(std::memory_order_relaxed) == 0)
+            blocked_since_.compare_exchange_strong(unblocked,
+                                                   steady_time_ns());
+    } else if (blocked_since_.load(std::memory_order_relaxed) != 0) {
+        int64_t since = blocked_since_.exchange(0);
+        if (since != 0)
+            backpressure_ns_.fetch_add(steady_time_ns() - since,
+                                       std::memory_order_relaxed);
+    }
+    return full;
 }
 
 bool Node::any_of_input_queue_full() {
@@ -286,7 +369,8 @@ int Node::need_opt_reset(JsonParam reset_opt) {
 }
 
 // In current design, this function will not be called in parallel
-// since one node is only scheduled by one scheduler queue
+// since one node is only scheduled by one scheduler queue, or guarded by
+// in_process_ when work stealing is enabled
 int Node::process_node(Task &task) {
     if (state_ == NodeState::CLOSED || state_ == NodeState::PAUSE_DONE) {
         dec_pending_task();
@@ -295,7 +379,7 @@ int Node::process_node(Task &task) {
 
 #ifndef NO_TRACE
     TraceProcessEmitter trace_emitter =
-        TraceProcessEmitter(PROCESSING, node_name_);
+        TraceProcessEmitter(PROCESSING, trace_name_);
 #endif
 
     // TODO check the task is valid
@@ -334,6 +418,11 @@ int Node::process_node(Task &task) {
         BMFLOG_NODE(BMF_ERROR, this->id_) << "Process node failed, will exit.";
     };
 
+    // the module pops its inputs, the trace context is taken before
+    PacketTraceContext upstream;
+    if (latency_tracking_)
+        upstream = oldest_input_context(task);
+
     int result = 0;
     try {
         opt_reset_mutex_.lock();
@@ -345,7 +434,9 @@ int Node::process_node(Task &task) {
 
         BMF_TRACE_PROCESS(module_name_.c_str(), "process", START);
         state_ = NodeState::RUNNING;
+        int64_t start = steady_time_ns();
         result = module_->process(task);
+        process_time_.observe(steady_time_ns() - start);
         state_ = NodeState::PENDING;
         BMF_TRACE_PROCESS(module_name_.c_str(), "process", END);
         if (result != 0)
@@ -376,14 +467,33 @@ int Node::process_node(Task &task) {
     }
 
     // call post process, propagate packets to downstream node
-    output_stream_manager_->post_process(task);
+    if (latency_tracking_) {
+        int64_t now = steady_time_ns();
+        bool stamped = false;
+        output_stream_manager_->post_process(
+            task, [&](int stream_id, Packet &packet) {
+                stamped |= stamp_latency(stream_id, packet, upstream, now);
+            });
+        // the data ends here, e.g. in an encoder
+        if (!stamped && upstream.ingest_time)
+            latency_slot(-1, upstream.source)
+                ->observe(now - upstream.ingest_time);
+    } else
+        output_stream_manager_->post_process(task);
+
+    finish_task();
+    return 0;
+}
 
+// the bookkeeping once a task is processed or dropped, a pause waiting for
+// it completes, otherwise the node is scheduled again
+void Node::finish_task() {
     dec_pending_task();
 
     if ((wait_pause_ == true && pending_tasks_ == 0)) {
         state_ = NodeState::PAUSE_DONE;
         pause_event_.notify_all();
-        return 0;
+        return;
     }
 
     bool is_blocked = false;
@@ -401,8 +511,6 @@ int Node::process_node(Task &task) {
     if (!is_blocked)
         if (state_ != NodeState::CLOSED)
             callback_.sched_required(id_, false);
-
-    return 0;
 }
 
 /*
@@ -415,7 +523,7 @@ scheduler
 bool Node::schedule_node() {
 #ifndef NO_TRACE
     TraceProcessEmitter trace_emitter =
-        TraceProcessEmitter(SCHEDULE, node_name_);
+        TraceProcessEmitter(SCHEDULE, trace_name_);
 #endif
     mutex_.lock();
     //        BMFLOG_NODE(BMF_INFO, id_) << "scheduling...";
@@ -445,8 +553,9 @@ bool Node::schedule_node() {
 
     bool result = false;
     if (is_source()) {
-        Task task = Task(id_, input_stream_manager_->stream_id_list_,
-                         output_stream_manager_->get_stream_id_list());
+        Task task = input_stream_manager_->task_pool_.acquire(
+            id_, input_stream_manager_->stream_id_list_,
+            output_stream_manager_->get_stream_id_list());
         if (infinity_node_) {
             task.set_timestamp(INF_SRC);
         } else {
@@ -466,6 +575,10 @@ bool Node::schedule_node() {
             schedule_node_success_cnt_++;
     }
     mutex_.unlock();
+    // outside of mutex_, upstream scheduling takes the upstream node locks
+    if (input_stream_manager_->backpressure_released_ &&
+        input_stream_manager_->backpressure_released_.exchange(false))
+        callback_.release_upstream(id_);
     return result;
 }
 
@@ -489,6 +602,121 @@ void Node::set_scheduler_queue_id(int scheduler_queue_id) {
 
 int Node::get_scheduler_queue_id() { return scheduler_queue_id_; }
 
+int Node::get_priority() { return priority_; }
+
+// Skip a task which missed its deadline, its input packets are discarded
+// without reaching the module. Tasks carrying eof or other control packets
+// are always processed. The downstream nodes are told that nothing comes
+// up to the dropped timestamps, so the ones syncing several inputs do not
+// wait for them.
+bool Node::drop_expired_task(Task &task) {
+    if (!drop_expired_ || task.timestamp() >= BMF_PAUSE)
+        return false;
+    int64_t last_timestamp = task.timestamp();
+    for (auto &it : task.get_inputs()) {
+        if (it.second->empty())
+            continue;
+        if (it.second->back().timestamp() >= BMF_PAUSE)
+            return false;
+        last_timestamp =
+            std::max(last_timestamp, it.second->back().timestamp());
+    }
+    if (state_ == NodeState::CLOSED || state_ == NodeState::PAUSE_DONE) {
+        dec_pending_task();
+        return true;
+    }
+    deadline_miss_cnt_++;
+    deadline_drop_cnt_++;
+    for (auto &it : task.get_inputs()) {
+        auto stream = input_stream_manager_->input_streams_.find(it.first);
+        if (stream != input_stream_manager_->input_streams_.end())
+            stream->second->drop_cnt_ += it.second->size();
+    }
+    output_stream_manager_->propagate_time_bounding(last_timestamp);
+    finish_task();
+    return true;
+}
+
+// the context of the data which entered the graph first among the inputs,
+// inputs are in arrival order so the front packets are enough
+PacketTraceContext Node::oldest_input_context(Task &task) {
+    PacketTraceContext oldest;
+    for (auto &it : task.get_inputs()) {
+        if (it.second->empty() || !it.second->front())
+            continue;
+        auto &context = it.second->front().trace_context();
+        if (context.ingest_time &&
+            (!oldest.ingest_time || context.ingest_time < oldest.ingest_time))
+            oldest = context;
+    }
+    return oldest;
+}
+
+// Packets made by the node carry on the context of its inputs, or start one
+// if the node is where the data enters the graph. Packets passed through
+// keep theirs, they may be shared with other downstream nodes already.
+bool Node::stamp_latency(int stream_id, Packet &packet,
+                         PacketTraceContext const &upstream, int64_t now) {
+    if (!packet || packet.timestamp() >= BMF_PAUSE)
+        return false;
+    auto context = packet.trace_context();
+    if (!context.ingest_time) {
+        if (upstream.ingest_time)
+            context = {upstream.ingest_time, upstream.source,
+                       upstream.hops + 1};
+        else
+            context = {now, id_, 1};
+        packet.set_trace_context(context);
+    }
+    if (context.ingest_time != now)
+        latency_slot(stream_id, context.source)
+            ->observe(now - context.ingest_time);
+    return true;
+}
+
+// the packets of a stream mostly come from one source, the path they took
+// last is looked up without a lock
+LatencyHistogram *Node::latency_slot(int stream_id, int source) {
+    auto &slot = latency_slots_[stream_id];
+    if (!slot.latency || slot.source != source) {
+        slot.latency = latency_path(source);
+        slot.source = source;
+    }
+    return slot.latency;
+}
+
+LatencyHistogram *Node::latency_path(int source) {
+    LatencyHistogram *latency;
+    {
+        std::lock_guard<std::mutex> guard(latency_mutex_);
+        for (auto &path : latency_paths_)
+            if (path.source == source)
+                return &path.latency;
+        latency_paths_.emplace_back(source);
+        latency = &latency_paths_.back().latency;
+    }
+    // the registry takes its own lock
+    callback_.latency_path_added(id_, source, latency);
+    return latency;
+}
+
+std::vector<PathLatency> Node::get_latency() {
+    std::vector<PathLatency> paths;
+    std::lock_guard<std::mutex> guard(latency_mutex_);
+    for (auto &path : latency_paths_) {
+        auto &latency = path.latency;
+        paths.push_back({path.source, id_, latency.count_.load(),
+                         latency.percentile(0.5), latency.percentile(0.99),
+                         latency.percentile(0.999)});
+    }
+    return paths;
+}
+
+// hand a processed task back, the next task of the node reuses its queues
+void Node::recycle_task(Task &task) {
+    input_stream_manager_->task_pool_.release(task);
+}
+
 int Node::get_input_stream_manager(
     std::shared_ptr<InputStreamManager> &input_stream_manager) {
     input_stream_manager = input_stream_manager_;
@@ -392,6 +392,14 @@ void process_distributed_node(std::vector<bmf_engine::NodeConfig> &nodes) {
                                                 node->get_input_streams()[0],
                                                 nodes.size(), dist_nums);
             // split_node.set_output_manager("split");
+            // how packets are dispatched to the replicas
+            auto dist_option = node->get_option().json_value_;
+            nlohmann::json split_option = nlohmann::json::object();
+            if (dist_option.count("dist_strategy"))
+                split_option["strategy"] = dist_option.at("dist_strategy");
+            if (dist_option.count("dist_key"))
+                split_option["key"] = dist_option.at("dist_key");
+            split_node.set_option(JsonParam(split_option));
             nodes.push_back(split_node);
 
             node->change_input_stream_identifier(split_node.output_streams[0].
@@ -418,6 +426,10 @@ void process_distributed_node(std::vector<bmf_engine::NodeConfig> &nodes) {
             auto assemble_node = create_assemble_node(nodes.size(), 
                                                       assemble_input_streams,
                                                       nodes.size(), 1);
+            // how long the reassembly waits for a lagging replica
+            if (dist_option.count("dist_max_skew"))
+                assemble_node.set_option(JsonParam(nlohmann::json{
+                    {"max_skew", dist_option.at("dist_max_skew")}}));
             nodes.push_back(assemble_node);
             
             // link downstream node's inputstream and assemble node's outputstream
@@ -38,13 +38,27 @@ int OutputStream::add_mirror_stream(
 
 int OutputStream::propagate_packets(
     std::shared_ptr<SafeQueue<Packet>> packets) {
-    for (auto &s : mirror_streams_) {
-        auto copy_queue = std::make_shared<SafeQueue<Packet>>(*packets.get());
-        copy_queue->set_identifier(identifier_);
-        s.input_stream_manager_->add_packets(s.stream_id_, copy_queue);
-    }
+    auto batch = std::make_shared<std::vector<Packet>>();
+    batch->reserve(packets->size());
+    Packet pkt;
+    while (packets->pop(pkt))
+        batch->push_back(std::move(pkt));
+    return propagate_packets(PacketBatch(std::move(batch)));
+}
+
+// all mirrors share the same batch, each one only takes its own references
+// to the packets
+int OutputStream::propagate_packets(PacketBatch const &packets) {
+    for (auto &s : mirror_streams_)
+        s.input_stream_manager_->add_packets(s.stream_id_, packets);
     return 0;
 }
+void OutputStream::propagate_time_bounding(int64_t timestamp) {
+    for (auto &s : mirror_streams_)
+        s.input_stream_manager_->advance_time_bounding(s.stream_id_,
+                                                       timestamp);
+}
+
 int OutputStream::add_upstream_nodes(int node_id) {
     for (auto &s : mirror_streams_) {
         s.input_stream_manager_->add_upstream_nodes(node_id);
@@ -54,14 +54,32 @@ OutputStreamManager::OutputStreamManager(
     }
 }
 
-int OutputStreamManager::post_process(Task &task) {
+int OutputStreamManager::post_process(
+    Task &task, std::function<void(int, Packet &)> const &stamp) {
     for (auto &t : task.outputs_queue_) {
-        auto q = std::make_shared<SafeQueue<Packet>>(t.second);
-        output_streams_[t.first]->propagate_packets(q);
+        // the task is done, its packets move into the shared batch
+        auto &queue = *t.second;
+        if (queue.empty())
+            continue;
+        auto batch = std::make_shared<std::vector<Packet>>();
+        batch->reserve(queue.size());
+        while (!queue.empty()) {
+            batch->push_back(std::move(queue.front()));
+            queue.pop();
+            if (stamp)
+                stamp(t.first, batch->back());
+        }
+        output_streams_[t.first]->propagate_packets(
+            PacketBatch(std::move(batch)));
     }
     return 0;
 }
 
+void OutputStreamManager::propagate_time_bounding(int64_t timestamp) {
+    for (auto &out_s : output_streams_)
+        out_s.second->propagate_time_bounding(timestamp);
+}
+
 bool OutputStreamManager::get_stream(
     int stream_id, std::shared_ptr<OutputStream> &output_stream) {
     if (output_streams_.count(stream_id) > 0) {
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../include/profiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+BEGIN_BMF_ENGINE_NS
+
+ProfileReport::ProfileReport(std::vector<NodeProfile> nodes,
+                             std::vector<QueueProfile> queues,
+                             int64_t wall_ns)
+    : nodes_(std::move(nodes)), queues_(std::move(queues)),
+      wall_ns_(wall_ns) {
+    find_critical_path();
+    suggest();
+}
+
+NodeProfile const *ProfileReport::node(int id) const {
+    for (auto &n : nodes_)
+        if (n.id == id)
+            return &n;
+    return nullptr;
+}
+
+void ProfileReport::find_critical_path() {
+    std::set<int> has_upstream;
+    for (auto &n : nodes_)
+        for (auto id : n.downstream)
+            has_upstream.insert(id);
+
+    std::map<int, int64_t> longest;
+    std::map<int, int> next;
+    std::set<int> visiting;
+    // longest path to a sink starting at the node, an edge back to a node
+    // on the current walk closes a cycle and is not followed, so next only
+    // points at nodes already finished and the path can not loop
+    std::function<int64_t(int)> walk = [&](int id) -> int64_t {
+        if (longest.count(id))
+            return longest[id];
+        auto n = node(id);
+        if (!n)
+            return 0;
+        visiting.insert(id);
+        int64_t tail = 0;
+        int tail_id = -1;
+        for (auto down : n->downstream) {
+            if (!node(down) || visiting.count(down))
+                continue;
+            int64_t t = walk(down);
+            if (tail_id < 0 || t > tail) {
+                tail = t;
+                tail_id = down;
+            }
+        }
+        visiting.erase(id);
+        int64_t per_task =
+            n->tasks > 0 ? (n->process_ns + n->queued_ns) / n->tasks : 0;
+        next[id] = tail_id;
+        return longest[id] = per_task + tail;
+    };
+
+    int head = -1;
+    for (auto &n : nodes_) {
+        if (has_upstream.count(n.id))
+            continue;
+        int64_t length = walk(n.id);
+        if (head < 0 || length > critical_path_ns_) {
+            head = n.id;
+            critical_path_ns_ = length;
+        }
+    }
+    for (int id = head; id >= 0; id = next[id])
+        critical_path_.push_back(id);
+
+    int64_t busiest = 0;
+    for (auto &n : nodes_) {
+        if (n.process_ns > busiest) {
+            busiest = n.process_ns;
+            bottleneck_ = n.id;
+        }
+    }
+}
+
+void ProfileReport::suggest() {
+    auto bottleneck = node(bottleneck_);
+    if (!bottleneck)
+        return;
+
+    // replicas enough to bring the bottleneck down to the next busiest node
+    if (bottleneck->is_source) {
+        suggestions_.push_back("node " + std::to_string(bottleneck->id) +
+                               " is a source and can not be distributed, "
+                               "consider a faster decoder or input");
+    } else if (wall_ns_ > 0 && bottleneck->process_ns * 2 >= wall_ns_) {
+        int64_t runner_up = 0;
+        for (auto &n : nodes_)
+            if (n.id != bottleneck->id)
+                runner_up = std::max(runner_up, n.process_ns);
+        int64_t dist_nums =
+            runner_up > 0
+                ? (bottleneck->process_ns + runner_up - 1) / runner_up
+                : 2;
+        int64_t max_dist =
+            std::max<int64_t>(2, std::thread::hardware_concurrency());
+        dist_nums = std::min(std::max<int64_t>(dist_nums, 2), max_dist);
+        suggestions_.push_back(
+            "node " + std::to_string(bottleneck->id) + " (" +
+            bottleneck->module + ") was busy " +
+            std::to_string(bottleneck->process_ns * 100 / wall_ns_) +
+            "% of the run, try \"dist_nums\": " + std::to_string(dist_nums) +
+            " in its option");
+    }
+
+    // the nodes sharing a queue with the bottleneck take turns with it, move
+    // the heaviest of them to the least loaded queue, or to a new one
+    std::map<int, int64_t> queue_load;
+    for (auto &q : queues_)
+        queue_load[q.id] = 0;
+    for (auto &n : nodes_)
+        queue_load[n.scheduler_queue] += n.process_ns;
+    NodeProfile const *neighbour = nullptr;
+    for (auto &n : nodes_)
+        if (n.id != bottleneck->id &&
+            n.scheduler_queue == bottleneck->scheduler_queue &&
+            n.process_ns > 0 &&
+            (!neighbour || n.process_ns > neighbour->process_ns))
+            neighbour = &n;
+    if (!neighbour)
+        return;
+    int target = -1;
+    for (auto &it : queue_load)
+        if (it.first != bottleneck->scheduler_queue &&
+            (target < 0 || it.second < queue_load[target]))
+            target = it.first;
+    bool new_queue = target < 0;
+    if (new_queue)
+        target = queue_load.rbegin()->first + 1;
+    int64_t target_load = new_queue ? 0 : queue_load[target];
+    if (target_load + neighbour->process_ns >=
+        queue_load[bottleneck->scheduler_queue])
+        return;
+    suggestions_.push_back(
+        "node " + std::to_string(neighbour->id) + " (" + neighbour->module +
+        ") shares scheduler queue " +
+        std::to_string(bottleneck->scheduler_queue) +
+        " with the bottleneck, try \"scheduler\": " + std::to_string(target) +
+        (new_queue ? " and \"scheduler_count\": " + std::to_string(target + 1)
+                   : ""));
+}
+
+std::string ProfileReport::dump() const {
+#define LEFTW(width) std::setiosflags(std::ios::left) << std::setw(width)
+    auto ms = [](int64_t ns) { return ns / 1e6; };
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "BMF profile, wall time " << ms(wall_ns_) << " ms\n";
+    out << LEFTW(8) << "NODE" << LEFTW(24) << "MODULE" << LEFTW(8) << "QUEUE"
+        << LEFTW(10) << "TASKS" << LEFTW(14) << "PROCESS(ms)" << LEFTW(14)
+        << "TASK(ms)" << LEFTW(14) << "QUEUED(ms)" << LEFTW(18)
+        << "BACKPRESSURE(ms)" << "BUSY(%)\n";
+    for (auto &n : nodes_) {
+        out << LEFTW(8) << n.id << LEFTW(24) << n.module << LEFTW(8)
+            << n.scheduler_queue << LEFTW(10) << n.tasks << LEFTW(14)
+            << ms(n.process_ns) << LEFTW(14) << ms(n.task_ns) << LEFTW(14)
+            << ms(n.queued_ns) << LEFTW(18)
+            << ms(n.backpressure_ns)
+            << (wall_ns_ > 0 ? 100. * n.process_ns / wall_ns_ : 0.) << '\n';
+    }
+    out << LEFTW(8) << "QUEUE" << LEFTW(14) << "BUSY(ms)" << LEFTW(14)
+        << "WAIT(ms)" << "BUSY(%)\n";
+    for (auto &q : queues_) {
+        out << LEFTW(8) << q.id << LEFTW(14) << ms(q.busy_ns) << LEFTW(14)
+            << ms(q.wait_ns)
+            << (wall_ns_ > 0 ? 100. * q.busy_ns / wall_ns_ : 0.) << '\n';
+    }
+    out << "critical path:";
+    for (size_t i = 0; i < critical_path_.size(); i++)
+        out << (i ? " -> " : " ") << critical_path_[i];
+    out << ", " << critical_path_ns_ / 1e3 << " us per task\n";
+    if (auto n = node(bottleneck_))
+        out << "bottleneck: node " << n->id << " (" << n->module << ")\n";
+    for (auto &s : suggestions_)
+        out << "suggestion: " << s << '\n';
+    return out.str();
+#undef LEFTW
+}
+
+END_BMF_ENGINE_NS
@@ -91,7 +91,12 @@ bmf::SchedulerQueueInfo RunningInfoCollector::collect_scheduler_queue_info(
     SchedulerQueue *scheduler_q) {
     bmf::SchedulerQueueInfo sq_info;
     sq_info.id = scheduler_q->id_;
-    sq_info.queue_size = scheduler_q->queue_.size();
+    sq_info.queue_size = scheduler_q->size();
+    sq_info.cpu_affinity = scheduler_q->cpu_set_;
+    sq_info.numa_node = scheduler_q->numa_node_;
+    sq_info.last_cpu = scheduler_q->last_cpu_;
+    sq_info.cpu_migrations = scheduler_q->cpu_migrations_;
+    sq_info.numa_migrations = scheduler_q->numa_migrations_;
     // TODO: Not implemented.
     sq_info.started_at = scheduler_q->start_time_;
 
@@ -115,20 +120,11 @@ bmf::SchedulerQueueInfo RunningInfoCollector::collect_scheduler_queue_info(
         sq_info.state =
             std::to_string(int64_t(scheduler_q->paused_state_)) + " -> UNKNOWN";
     }
-    // PriorityQueue need buffer to store and push back later.
-    auto siz = scheduler_q->queue_.size();
-    std::queue<Item> buf;
-    while (siz--) {
-        auto t = scheduler_q->pop_task();
+    for (auto &t : scheduler_q->snapshot()) {
         auto tmp = collect_task_info(&t.task);
         tmp.priority = t.priority;
-        buf.push(t);
         sq_info.tasks.push_back(tmp);
     }
-    while (!buf.empty()) {
-        scheduler_q->add_task(buf.front().task, buf.front().priority);
-        buf.pop();
-    }
 
     return sq_info;
 }
@@ -155,6 +151,8 @@ bmf::NodeRunningInfo RunningInfoCollector::collect_node_info(Node *node,
     node_info.schedule_count = uint64_t(node->schedule_node_cnt_);
     node_info.schedule_success_count =
         uint64_t(node->schedule_node_success_cnt_);
+    node_info.deadline_miss_count = uint64_t(node->deadline_miss_cnt_);
+    node_info.deadline_drop_count = uint64_t(node->deadline_drop_cnt_);
 
     switch (node->state_) {
     case NodeState::NOT_INITED:
@@ -210,6 +208,8 @@ RunningInfoCollector::collect_input_stream_info(InputStream *stream) {
     s_info.name = stream->identifier_;
     s_info.max_size = uint64_t(stream->max_queue_size_);
     s_info.size = uint64_t(stream->queue_->size());
+    s_info.max_bytes = uint64_t(stream->max_queue_bytes_);
+    s_info.bytes = uint64_t(stream->queue_bytes_);
 
     auto siz = stream->queue_->size();
     while (siz--) {
@@ -32,8 +32,9 @@ NodeItem::NodeItem(std::shared_ptr<Node> node) : node_(node) {
 }
 
 Scheduler::Scheduler(SchedulerCallBack callback, int scheduler_cnt,
-                     double time_out) {
+                     double time_out, bool work_stealing) {
     thread_quit_ = false;
+    work_stealing_ = work_stealing && scheduler_cnt > 1;
     callback_ = callback;
     SchedulerQueueCallBack scheduler_queue_callback;
     scheduler_queue_callback.get_node_ = callback.get_node_;
@@ -52,26 +53,155 @@ Scheduler::Scheduler(SchedulerCallBack callback, int scheduler_cnt,
             exception_flag_ = true;
             eptr_ = scheduler_queue->eptr_;
         }
+        // a stolen task throws on the thief queue instead of the node's own
+        if (!eptr_ && work_stealing_) {
+            for (auto &q : this->scheduler_queues_) {
+                if (q->exception_catch_flag_ && q->eptr_) {
+                    exception_flag_ = true;
+                    eptr_ = q->eptr_;
+                    break;
+                }
+            }
+        }
         for (int i = 0; i < this->scheduler_queues_.size(); i++)
             this->scheduler_queues_[i]->exception_catch_flag_ = true;
 
         this->callback_.close_report_(node_id, true);
         return 0;
     };
+    if (work_stealing_) {
+        scheduler_queue_callback.steal_ = [this](int thief_id,
+                                                 Item &item) -> bool {
+            return this->steal_task(thief_id, item);
+        };
+        scheduler_queue_callback.release_ = [this](int node_id) {
+            this->release_node(node_id);
+        };
+        BMFLOG(BMF_INFO) << "scheduler work stealing enabled";
+    }
     for (int i = 0; i < scheduler_cnt; i++) {
         std::shared_ptr<SchedulerQueue> scheduler_queue =
-            std::make_shared<SchedulerQueue>(i, scheduler_queue_callback);
+            std::make_shared<SchedulerQueue>(i, scheduler_queue_callback,
+                                             work_stealing_);
         scheduler_queues_.push_back(scheduler_queue);
     }
     time_out_ = time_out;
 }
 
+void Scheduler::release_upstream(int node_id) {
+    std::shared_ptr<Node> node;
+    callback_.get_node_(node_id, node);
+    if (!node)
+        return;
+    std::shared_ptr<InputStreamManager> input_stream_manager;
+    node->get_input_stream_manager(input_stream_manager);
+    for (auto &upstream_id : input_stream_manager->upstream_nodes_)
+        sched_required(upstream_id, false);
+}
+
+bool Scheduler::steal_task(int thief_id, Item &item) {
+    int cnt = scheduler_queues_.size();
+    for (int i = 1; i < cnt; i++) {
+        auto &victim = scheduler_queues_[(thief_id + i) % cnt];
+        if (!victim->empty() && victim->take_task(item))
+            return true;
+    }
+    return false;
+}
+
+void Scheduler::release_node(int node_id) {
+    std::shared_ptr<Node> node;
+    callback_.get_node_(node_id, node);
+    if (!node)
+        return;
+    node->in_process_ = false;
+    // tasks of this node skipped while it was busy are runnable again
+    int home_id = node->get_scheduler_queue_id();
+    if (!scheduler_queues_[home_id]->empty()) {
+        scheduler_queues_[home_id]->wake();
+        wake_idle_queue(home_id);
+    }
+}
+
+void Scheduler::wake_idle_queue(int except_id) {
+    for (auto &q : scheduler_queues_) {
+        if (q->id_ != except_id && q->idle_) {
+            q->wake();
+            return;
+        }
+    }
+}
+
+void Scheduler::set_queue_affinity(std::vector<std::string> const &cpu_lists,
+                                   bool numa_bind) {
+    if (cpu_lists.empty()) {
+        if (numa_bind)
+            BMFLOG(BMF_WARNING)
+                << "numa_bind is ignored without scheduler_affinity";
+        return;
+    }
+    // queues beyond the given lists reuse them round robin
+    int cpus = cpu_count();
+    for (auto &q : scheduler_queues_) {
+        auto &cpu_list = cpu_lists[q->id_ % cpu_lists.size()];
+        q->cpu_set_ = parse_cpu_list(cpu_list);
+        for (auto cpu : q->cpu_set_)
+            if (cpu >= cpus)
+                throw std::invalid_argument(
+                    "scheduler_affinity: cpu " + std::to_string(cpu) +
+                    " out of range in " + cpu_list + ", only " +
+                    std::to_string(cpus) + " cpus");
+        if (numa_bind && !q->cpu_set_.empty())
+            q->numa_node_ = numa_node_of_cpu(q->cpu_set_.front());
+        BMFLOG(BMF_INFO) << "schedule queue " << q->id_ << " cpus "
+                         << cpu_list << " numa node " << q->numa_node_;
+    }
+}
+
+void Scheduler::set_priority_aging(int64_t aging_ms) {
+    for (auto &q : scheduler_queues_)
+        q->aging_period_ = aging_ms * 1000000;
+}
+
+void Scheduler::set_latency_budget(int64_t budget_ms, double time_base) {
+    latency_budget_ = budget_ms * 1000000;
+    time_base_ns_ = time_base * 1e9;
+}
+
+// Deadline of a task in steady clock nanoseconds, derived from the earliest
+// regular timestamp among its input packets. Source and control tasks have
+// none.
+int64_t Scheduler::task_deadline(Task &task) {
+    int64_t timestamp = UNSET;
+    for (auto &it : task.get_inputs()) {
+        if (it.second->empty())
+            continue;
+        int64_t ts = it.second->front().timestamp();
+        if (ts == UNSET || ts >= BMF_PAUSE)
+            continue;
+        if (timestamp == UNSET || ts < timestamp)
+            timestamp = ts;
+    }
+    if (timestamp == UNSET)
+        return INT64_MAX;
+    std::call_once(deadline_anchor_flag_, [this, timestamp] {
+        anchor_timestamp_ = timestamp;
+        anchor_time_ = steady_time_ns();
+    });
+    return anchor_time_ +
+           int64_t((timestamp - anchor_timestamp_) * time_base_ns_) +
+           latency_budget_;
+}
+
 int Scheduler::start() {
     for (int i = 0; i < scheduler_queues_.size(); i++) {
         scheduler_queues_[i]->start();
     }
-    if (time_out_ > 0)
+    if (time_out_ > 0) {
+        if (last_schedule_clk_ == std::chrono::steady_clock::time_point())
+            last_schedule_clk_ = std::chrono::steady_clock::now();
         guard_thread_ = std::thread(&Scheduler::alive_watch, this);
+    }
 
     return 0;
 }
@@ -81,7 +211,11 @@ int Scheduler::close() {
         scheduler_queues_[i]->close();
     }
     if (time_out_ > 0) {
-        thread_quit_ = true;
+        {
+            std::lock_guard<std::mutex> guard(guard_mutex_);
+            thread_quit_ = true;
+        }
+        guard_var_.notify_all();
         guard_thread_.join();
     }
 
@@ -114,9 +248,13 @@ int Scheduler::add_or_remove_node(int node_id, bool is_add) {
         if (is_add) {
             if (nodes_to_schedule_.count(node_id) > 0) {
                 nodes_to_schedule_[node_id].nodes_ref_cnt_++;
+                rearm_node(node_id);
             } else {
                 nodes_to_schedule_[node_id] = NodeItem(node);
                 nodes_to_schedule_[node_id].nodes_ref_cnt_++;
+                schedule_order_.insert(
+                    {nodes_to_schedule_[node_id].last_scheduled_time_,
+                     node_id});
             }
             // printf("DEBUG, node %d refcnt is: %d\n", node_id,
             // nodes_to_schedule_[node_id].nodes_ref_cnt_);
@@ -128,6 +266,10 @@ int Scheduler::add_or_remove_node(int node_id, bool is_add) {
                 // printf("DEBUG, node %d refcnt is: %d\n", node_id,
                 // nodes_to_schedule_[node_id].nodes_ref_cnt_);
                 if (nodes_to_schedule_[node_id].nodes_ref_cnt_ == 0) {
+                    schedule_order_.erase(
+                        {nodes_to_schedule_[node_id].last_scheduled_time_,
+                         node_id});
+                    blocked_nodes_.erase(node_id);
                     nodes_to_schedule_.erase(node_id);
                 }
             }
@@ -137,7 +279,8 @@ int Scheduler::add_or_remove_node(int node_id, bool is_add) {
     // nodes_to_schedule_.size());
 
     if (is_add) {
-        int64_t start_time = clock();
+        int64_t start_time =
+            std::chrono::steady_clock::now().time_since_epoch().count();
         std::shared_ptr<Node> sched_node = NULL;
         choose_node_schedule(start_time, sched_node);
         if (sched_node && ((sched_node->is_source() &&
@@ -173,6 +316,7 @@ int Scheduler::sched_required(int node_id, bool is_closed) {
     }
     if (exception_flag_)
         return 0;
+    rearm_node(node_id);
 
     std::shared_ptr<InputStreamManager> input_stream_manager;
     node->get_input_stream_manager(input_stream_manager);
@@ -184,8 +328,9 @@ int Scheduler::sched_required(int node_id, bool is_closed) {
             to_schedule_queue(node_upst);
         }
     } else {
-        for (auto &node_id:input_stream_manager->upstream_nodes_)
-            sched_required(node_id, false);
+        if (!event_backpressure_)
+            for (auto &node_id : input_stream_manager->upstream_nodes_)
+                sched_required(node_id, false);
 
         std::lock_guard<std::mutex> lk(node->sched_mutex_);
         if ((!node->too_many_tasks_pending() &&
@@ -197,63 +342,55 @@ int Scheduler::sched_required(int node_id, bool is_closed) {
     return 0;
 }
 
+// A node that cannot make progress is moved out of the order when it is met
+// and comes back once rearm_node() sees a change, so each pick is O(log n)
+// amortized however many nodes are blocked. The chosen node is moved to the
+// back of the order.
 bool Scheduler::choose_node_schedule(int64_t start_time,
                                      std::shared_ptr<Node> &node) {
-    node_mutex_.lock();
-    NodeItem final_node_item = NodeItem();
-    int node_id = -1;
-    for (auto node_item : nodes_to_schedule_) {
-        // if (node_item.second.node_->pre_sched_num_ <= 4) {
-        if (node_item.second.node_->is_source() &&
-            node_item.second.node_->any_of_downstream_full() &&
-            node_item.second.node_->too_many_tasks_pending()) {
-            if (node_item.second.node_->any_of_downstream_full())
-                printf("DEBUG, node %d, choose the source node which is "
-                       "downstream full\n",
-                       node_item.first);
-            if (node_item.second.node_->too_many_tasks_pending())
-                printf("DEBUG, node %d, choose the source node which is "
-                       "pending full\n",
-                       node_item.first);
-            node_id = -1;
-            continue;
-        }
-        if (!node_item.second.node_->is_source() &&
-            node_item.second.node_->too_many_tasks_pending() &&
-            node_item.second.node_->all_input_queue_empty()) {
-            node_id = -1;
+    std::lock_guard<std::recursive_mutex> guard(node_mutex_);
+    std::set<int> rearmed;
+    {
+        std::lock_guard<std::mutex> lk(rearm_mutex_);
+        rearmed.swap(rearmed_nodes_);
+    }
+    for (auto node_id : rearmed) {
+        if (blocked_nodes_.erase(node_id))
+            schedule_order_.insert(
+                {nodes_to_schedule_[node_id].last_scheduled_time_, node_id});
+    }
+
+    auto it = schedule_order_.begin();
+    while (it != schedule_order_.end() && it->first <= start_time) {
+        int node_id = it->second;
+        NodeItem &node_item = nodes_to_schedule_[node_id];
+        auto &candidate = node_item.node_;
+        if ((candidate->is_source() && candidate->any_of_downstream_full() &&
+             candidate->too_many_tasks_pending()) ||
+            (!candidate->is_source() && candidate->too_many_tasks_pending() &&
+             candidate->all_input_queue_empty())) {
+            it = schedule_order_.erase(it);
+            blocked_nodes_.insert(node_id);
             continue;
         }
-        //} else {
-        //    printf("DEBUG, node %d pre sched number is full\n",
-        //    node_item.first);
-        //    continue;
-        //}
-        if (node_item.second.last_scheduled_time_ <= start_time) {
-            if (final_node_item.node_ == NULL) {
-                final_node_item = node_item.second;
-                node_id = node_item.second.node_->get_id();
-            } else {
-                if (node_item.second.last_scheduled_time_ <
-                    final_node_item.last_scheduled_time_) {
-                    final_node_item = node_item.second;
-                    node_id = node_item.second.node_->get_id();
-                }
-            }
-        }
-    }
 
-    if (node_id != -1) {
-        nodes_to_schedule_[node_id].last_scheduled_time_ = clock();
-        final_node_item.last_scheduled_time_ = clock();
-        node = final_node_item.node_;
-        node_mutex_.unlock();
+        schedule_order_.erase(it);
+        node_item.last_scheduled_time_ =
+            std::chrono::steady_clock::now().time_since_epoch().count();
+        schedule_order_.insert({node_item.last_scheduled_time_, node_id});
+        node = candidate;
         return true;
     }
-    node_mutex_.unlock();
     return false;
 }
 
+// Every change which can unblock a node ends in sched_required() for it:
+// a finished task, new input or a downstream queue leaving the full state.
+void Scheduler::rearm_node(int node_id) {
+    std::lock_guard<std::mutex> lk(rearm_mutex_);
+    rearmed_nodes_.insert(node_id);
+}
+
 int Scheduler::to_schedule_queue(std::shared_ptr<Node> node) {
 
     if (node && node->wait_pause_) {
@@ -278,8 +415,11 @@ int Scheduler::schedule_node(Task &task) {
     std::shared_ptr<SchedulerQueue> scheduler_queue;
     int scheduler_queue_id = node->get_scheduler_queue_id();
     scheduler_queue = scheduler_queues_[scheduler_queue_id];
-    // TODO: ??? Useless priority
-    scheduler_queue->add_task(task, 1);
+    int64_t deadline = latency_budget_ > 0 ? task_deadline(task) : INT64_MAX;
+    scheduler_queue->add_task(std::move(task), node->get_priority(),
+                              deadline);
+    if (work_stealing_ && !scheduler_queue->idle_)
+        wake_idle_queue(scheduler_queue_id);
     return 0;
 }
 
@@ -291,27 +431,28 @@ int Scheduler::clear_task(int node_id, int scheduler_queue_id) {
 }
 
 int Scheduler::alive_watch() {
-    std::chrono::duration<double> time_span;
-    while (1) {
-        if (!thread_quit_) {
-            time_span =
-                std::chrono::duration_cast<std::chrono::duration<double>>(
-                    std::chrono::steady_clock::now() - last_schedule_clk_);
-            if (time_span.count() >= time_out_) {
-                try {
-                    BMF_Error(BMF_StsTimeOut,
-                              "No more task to be scheduled during 5 seconds");
-                } catch (...) {
-                    eptr_ = std::current_exception();
-                    for (int i = 0; i < scheduler_queues_.size(); i++)
-                        scheduler_queues_[i]->exception_catch_flag_ = true;
-                    callback_.close_report_(-1, true);
-                    break;
-                }
-            }
-            usleep(100000);
-        } else
+    auto time_out =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(time_out_));
+    std::unique_lock<std::mutex> lk(guard_mutex_);
+    while (!thread_quit_) {
+        // no need to look before the last scheduling plus the time out,
+        // a later scheduling just moves the deadline
+        auto deadline = last_schedule_clk_ + time_out;
+        if (std::chrono::steady_clock::now() < deadline) {
+            guard_var_.wait_until(lk, deadline);
+            continue;
+        }
+        try {
+            BMF_Error(BMF_StsTimeOut,
+                      "No more task to be scheduled during 5 seconds");
+        } catch (...) {
+            eptr_ = std::current_exception();
+            for (int i = 0; i < scheduler_queues_.size(); i++)
+                scheduler_queues_[i]->exception_catch_flag_ = true;
+            callback_.close_report_(-1, true);
             break;
+        }
     }
     return 0;
 }
@@ -20,8 +20,15 @@
 #include <bmf/sdk/trace.h>
 #include <bmf/sdk/log.h>
 
+#include <chrono>
+#include <fstream>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -30,8 +37,19 @@
 BEGIN_BMF_ENGINE_NS
 USE_BMF_SDK_NS
 
-// TODO: Unused Item.priority
+int64_t steady_time_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// higher priority first, then the earlier deadline, the earlier timestamp
+// and the lower node id
 bool operator<(const Item &lhs, const Item &rhs) {
+    if (lhs.priority != rhs.priority)
+        return lhs.priority < rhs.priority;
+    if (lhs.deadline != rhs.deadline)
+        return lhs.deadline > rhs.deadline;
     if (lhs.task.timestamp() > rhs.task.timestamp()) {
         return true;
     } else if (lhs.task.timestamp() == rhs.task.timestamp()) {
@@ -41,81 +59,202 @@ bool operator<(const Item &lhs, const Item &rhs) {
     return false;
 }
 
-SchedulerQueue::SchedulerQueue(int id, SchedulerQueueCallBack callback)
-    : id_(id), callback_(callback), start_time_(0), state_(State::INITED) {}
+SchedulerQueue::SchedulerQueue(int id, SchedulerQueueCallBack callback,
+                               bool work_stealing)
+    : id_(id), callback_(callback), start_time_(0), state_(State::INITED),
+      parked_(false), signal_(false), work_stealing_(work_stealing),
+      idle_(false), last_cpu_(-1), cpu_migrations_(0), numa_migrations_(0),
+      aging_period_(100000000), prioritized_(false) {
+    std::string wait_name = "THREAD_" + std::to_string(id_) + "_WAIT";
+    trace_wait_name_ = TraceNames::intern(wait_name.c_str());
+    trace_wait_src_ = TraceNames::intern("park");
+}
 
 Item SchedulerQueue::pop_task() {
     Item item;
-    queue_.pop(item);
+    drain_inbox();
+    if (queue_.pop(item))
+        count_--;
     return item;
 }
 
-int SchedulerQueue::add_task(Task &task, int priority) {
+std::vector<Item> SchedulerQueue::snapshot() {
+    SafePriorityQueue<Item> copy(queue_);
+    std::vector<Item> items;
+    Item item;
+    while (copy.pop(item))
+        items.push_back(std::move(item));
+    return items;
+}
+
+int SchedulerQueue::add_task(Task &&task, int priority, int64_t deadline) {
     if (state_ == State::TERMINATED)
         return false;
     if (task.timestamp_ != UNSET) {
-        std::lock_guard<std::mutex> guard(con_var_mutex_);
-        Item item = Item(priority, task);
-        queue_.push(item);
-        con_var_.notify_one();
+        Item item(priority, std::move(task));
+        item.enqueue_time = steady_time_ns();
+        item.deadline = deadline;
+        if (priority != 0 && !prioritized_)
+            prioritized_ = true;
+        count_++;
+        inbox_.push(std::move(item));
+        wake();
         return true;
     }
     return false;
 }
 
+void SchedulerQueue::drain_inbox() {
+    inbox_.pop_all([this](Item &&item) { queue_.push(std::move(item)); });
+}
+
+// Raise the priority of waiting tasks by one level per aging period, only
+// the consuming thread calls it. The queue order is fixed at push time, so
+// it is rebuilt once per period.
+void SchedulerQueue::age_tasks() {
+    if (!prioritized_ || aging_period_ <= 0)
+        return;
+    int64_t now = steady_time_ns();
+    if (now < next_aging_)
+        return;
+    next_aging_ = now + aging_period_;
+    std::vector<Item> items;
+    Item item;
+    while (queue_.pop(item))
+        items.push_back(std::move(item));
+    for (auto &it : items) {
+        it.priority =
+            it.base_priority + (now - it.enqueue_time) / aging_period_;
+        queue_.push(std::move(it));
+    }
+}
+
+bool SchedulerQueue::empty() { return inbox_.empty() && queue_.empty(); }
+
+size_t SchedulerQueue::size() { return count_; }
+
+// Wakers publish signal_ before looking at parked_ and the parking thread
+// publishes parked_ before looking at signal_, so one of them always sees
+// the other and the mutex is only touched when the thread really sleeps.
+void SchedulerQueue::wake() {
+    signal_ = true;
+    if (parked_ && parked_.exchange(false)) {
+        std::lock_guard<std::mutex> guard(con_var_mutex_);
+        con_var_.notify_one();
+    }
+}
+
+void SchedulerQueue::park() {
+    std::unique_lock<std::mutex> lk(con_var_mutex_);
+    parked_ = true;
+    auto ready = [this] {
+        return !this->parked_ || this->signal_ || this->paused_ ||
+               this->exception_catch_flag_ ||
+               (this->state_ == State::TERMINATING && this->empty());
+    };
+    if (!ready()) {
+        wait_cnt_++;
+        int64_t startts = clock();
+        int64_t start = steady_time_ns();
+        BMF_TRACE_ID(SCHEDULE, trace_wait_name_, trace_wait_src_, START);
+        con_var_.wait(lk, ready);
+        wait_duration_ += (clock() - startts);
+        wait_ns_.fetch_add(steady_time_ns() - start,
+                           std::memory_order_relaxed);
+        BMF_TRACE_ID(SCHEDULE, trace_wait_name_, trace_wait_src_, END);
+    }
+    parked_ = false;
+    signal_ = false;
+}
+
+// Pop the earliest task whose node is not being processed by another queue,
+// tasks of a busy node are kept in order for a later take.
+bool SchedulerQueue::take_task(Item &item) {
+    bool found = false;
+    bool released = false;
+    {
+        std::lock_guard<std::mutex> guard(con_var_mutex_);
+        drain_inbox();
+        age_tasks();
+        std::vector<Item> skipped;
+        // a busy node may be released during the scan, its later tasks must
+        // still wait behind the ones already skipped
+        std::map<int, std::shared_ptr<Node>> busy_nodes;
+        Item candidate;
+        while (queue_.pop(candidate)) {
+            int node_id = candidate.task.node_id_;
+            std::shared_ptr<Node> node;
+            callback_.get_node_(node_id, node);
+            if (!node || (!busy_nodes.count(node_id) &&
+                          !node->in_process_.exchange(true))) {
+                item = std::move(candidate);
+                found = true;
+                count_--;
+                break;
+            }
+            busy_nodes[node_id] = node;
+            skipped.push_back(std::move(candidate));
+        }
+        for (auto &it : skipped)
+            queue_.push(std::move(it));
+        // the releasing thread may have seen this queue empty while the
+        // skipped tasks were out of it, so nobody else will wake us for them
+        for (auto &it : busy_nodes)
+            if (!it.second->in_process_)
+                released = true;
+    }
+    if (released)
+        wake();
+    return found;
+}
+
 int SchedulerQueue::remove_node_task(int node_id) {
     std::lock_guard<std::mutex> guard(con_var_mutex_);
+    drain_inbox();
     SafePriorityQueue<Item> temp_queue;
     while (!queue_.empty()) {
         Item item;
         queue_.pop(item);
         if (item.task.node_id_ != node_id) {
-            temp_queue.push(item);
+            temp_queue.push(std::move(item));
+        } else {
+            count_--;
         }
     }
     while (!temp_queue.empty()) {
         Item item;
         temp_queue.pop(item);
-        queue_.push(item);
+        queue_.push(std::move(item));
     }
     return 0;
 }
 
 int SchedulerQueue::exec_loop() {
+    apply_affinity();
+    if (work_stealing_)
+        return steal_exec_loop();
     while (true) {
         if (paused_)
             internal_pause();
-        if ((state_ == State::TERMINATING and queue_.empty()) ||
+        if ((state_ == State::TERMINATING and empty()) ||
             exception_catch_flag_) {
             break;
         }
-        {
-            std::unique_lock<std::mutex> lk(con_var_mutex_);
-            if (queue_.empty() and state_ != State::TERMINATING) {
-                wait_cnt_++;
-                int64_t startts;
-                BMF_TRACE(SCHEDULE,
-                          ("THREAD_" + std::to_string(id_) + "_WAIT" + "_" +
-                           std::to_string(wait_cnt_))
-                              .c_str(),
-                          START);
-                startts = clock();
-                con_var_.wait(lk, [this] {
-                    return this->state_ == State::TERMINATING ||
-                           !this->queue_.empty();
-                });
-                wait_duration_ += (clock() - startts);
-                BMF_TRACE(SCHEDULE,
-                          ("THREAD_" + std::to_string(id_) + "_WAIT" + "_" +
-                           std::to_string(wait_cnt_))
-                              .c_str(),
-                          END);
-            }
+        // consume the signal before looking at the queue, a task pushed
+        // after this point raises it again
+        signal_ = false;
+        drain_inbox();
+        if (queue_.empty()) {
+            if (state_ != State::TERMINATING)
+                park();
+            continue;
         }
+        age_tasks();
         Item item;
         while (queue_.pop(item)) {
+            count_--;
             try {
-                exec(item.task);
+                exec(item.task, item.deadline, item.enqueue_time);
             } catch (...) {
                 exception_catch_flag_ = true;
                 this->eptr_ = std::current_exception();
@@ -123,42 +262,123 @@ int SchedulerQueue::exec_loop() {
             }
             if (paused_)
                 internal_pause();
+            drain_inbox();
+            age_tasks();
         }
     }
     BMFLOG(BMF_INFO) << "schedule queue " << id_ << " thread quit";
     return 0;
 }
 
+int SchedulerQueue::steal_exec_loop() {
+    auto run = [this](Item &item) {
+        // exec hands the task back to the node's pool
+        int node_id = item.task.node_id_;
+        try {
+            exec(item.task, item.deadline, item.enqueue_time);
+        } catch (...) {
+            exception_catch_flag_ = true;
+            this->eptr_ = std::current_exception();
+            callback_.exception_(node_id);
+        }
+        callback_.release_(node_id);
+    };
+    while (true) {
+        if (paused_)
+            internal_pause();
+        if ((state_ == State::TERMINATING and empty()) ||
+            exception_catch_flag_) {
+            break;
+        }
+        signal_ = false;
+        Item item;
+        if (take_task(item)) {
+            run(item);
+            continue;
+        }
+        // announce idleness before the last look at siblings, a producer
+        // which misses the flag pushed its task early enough to be seen here
+        idle_ = true;
+        if (callback_.steal_(id_, item)) {
+            idle_ = false;
+            steal_cnt_++;
+            run(item);
+            continue;
+        }
+        // tasks left behind a busy node are not runnable yet, wait for its
+        // release even when terminating
+        park();
+        idle_ = false;
+    }
+    BMFLOG(BMF_INFO) << "schedule queue " << id_ << " thread quit, "
+                     << steal_cnt_ << " tasks stolen";
+    return 0;
+}
+
 void SchedulerQueue::internal_pause() {
+    std::unique_lock<std::mutex> lk(pause_mutex_);
+    if (!paused_)
+        return;
     paused_state_ = state_;
     state_ = State::PAUSED;
-    while (paused_)
-        usleep(1000);
+    pause_var_.notify_all();
+    // closing a paused queue lets it drain and quit
+    auto resume_cnt = resume_cnt_;
+    pause_var_.wait(lk, [this, resume_cnt] {
+        return this->resume_cnt_ != resume_cnt ||
+               this->state_ == State::TERMINATING;
+    });
 }
 
 void SchedulerQueue::pause() {
     paused_ = true;
+    // a parked queue thread has to come round to internal_pause()
+    wake();
+    std::unique_lock<std::mutex> lk(pause_mutex_);
     if (state_ == State::RUNNING)
-        while (state_ != State::PAUSED)
-            usleep(1000);
+        pause_var_.wait(lk, [this] { return this->state_ != State::RUNNING; });
 }
 
 void SchedulerQueue::resume() {
-    if (state_ == State::PAUSED)
-        state_ = paused_state_;
-    paused_ = false;
+    {
+        std::lock_guard<std::mutex> guard(pause_mutex_);
+        if (state_ == State::PAUSED)
+            state_ = paused_state_;
+        paused_ = false;
+        resume_cnt_++;
+    }
+    pause_var_.notify_all();
 }
 
-int SchedulerQueue::exec(Task &task) {
+int SchedulerQueue::exec(Task &task, int64_t deadline,
+                         int64_t enqueue_time) {
     std::shared_ptr<Node> node;
     callback_.get_node_(task.node_id_, node);
+    if (enqueue_time > 0)
+        node->queued_ns_.fetch_add(steady_time_ns() - enqueue_time,
+                                   std::memory_order_relaxed);
+    // shed a task which is already late at nodes which allow it, instead of
+    // making the following ones late as well
+    if (deadline != INT64_MAX && steady_time_ns() > deadline &&
+        node->drop_expired_task(task)) {
+        node->recycle_task(task);
+        return 0;
+    }
     //        std::cout << "Working on " << task.node_id_ << std::endl;
     //        for (const auto &it:task.get_inputs())
     //            std::cout << "input queue id=" << it.first << "  task packet
     //            count " << it.second->size() << std::endl;
     auto st = TIMENOW();
+    int64_t start = steady_time_ns();
     node->process_node(task);
+    int64_t elapsed = steady_time_ns() - start;
     node->dur += DURATION(TIMENOW() - st);
+    node->task_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+    busy_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+    if (deadline != INT64_MAX && steady_time_ns() > deadline)
+        node->deadline_miss_cnt_++;
+    node->recycle_task(task);
+    track_cpu();
     //        std::cout << "Work done for" << task.node_id_ << std::endl;
     //        for (const auto &it:task.get_outputs())
     //            std::cout << "output queue id=" << it.first << "  task packet
@@ -166,8 +386,53 @@ int SchedulerQueue::exec(Task &task) {
     return 0;
 }
 
+void SchedulerQueue::apply_affinity() {
+    if (cpu_set_.empty() && numa_node_ < 0)
+        return;
+#ifdef __linux__
+    if (!cpu_set_.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (auto cpu : cpu_set_)
+            if (cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpus);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (ret != 0)
+            BMFLOG(BMF_WARNING) << "schedule queue " << id_
+                                << " failed to set cpu affinity, error " << ret;
+    }
+    if (numa_node_ >= 0) {
+        // prefer rather than bind, allocations fall back to other nodes
+        // instead of failing once the local node is exhausted
+        const int mpol_preferred = 1;
+        const size_t bits = sizeof(unsigned long) * 8;
+        std::vector<unsigned long> mask(numa_node_ / bits + 1, 0);
+        mask[numa_node_ / bits] = 1UL << (numa_node_ % bits);
+        if (syscall(SYS_set_mempolicy, mpol_preferred, mask.data(),
+                    mask.size() * bits + 1) != 0)
+            BMFLOG(BMF_WARNING) << "schedule queue " << id_
+                                << " failed to bind numa node " << numa_node_;
+    }
+#else
+    BMFLOG(BMF_WARNING) << "scheduler affinity is only supported on linux";
+#endif
+}
+
+void SchedulerQueue::track_cpu() {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    int last_cpu = last_cpu_.exchange(cpu);
+    if (cpu < 0 || last_cpu < 0 || cpu == last_cpu)
+        return;
+    cpu_migrations_++;
+    if (numa_node_of_cpu(cpu) != numa_node_of_cpu(last_cpu))
+        numa_migrations_++;
+#endif
+}
+
 int SchedulerQueue::start() {
     state_ = State::RUNNING;
+    start_time_ = steady_time_ns();
     exec_thread_ = std::thread(&SchedulerQueue::exec_loop, this);
     auto handle = exec_thread_.native_handle();
     std::string thread_name = "schedule_queue" + std::to_string(id_);
@@ -207,6 +472,12 @@ int SchedulerQueue::close() {
             // con_var_.wait()
             con_var_.notify_one();
         }
+        {
+            // a pause() in progress stops waiting for this queue
+            std::lock_guard<std::mutex> guard(pause_mutex_);
+            pause_var_.notify_all();
+        }
+        wake();
         exec_thread_.join();
         state_ = State::TERMINATED;
     }
@@ -217,4 +488,67 @@ int SchedulerQueue::close() {
     return 0;
 }
 
+std::vector<int> parse_cpu_list(std::string const &cpu_list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    try {
+        while (pos < cpu_list.size()) {
+            size_t end = cpu_list.find(',', pos);
+            if (end == std::string::npos)
+                end = cpu_list.size();
+            auto range = cpu_list.substr(pos, end - pos);
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos
+                           ? first
+                           : std::stoi(range.substr(dash + 1));
+            if (first < 0 || last < first)
+                throw std::invalid_argument(range);
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+            pos = end + 1;
+        }
+    } catch (std::logic_error &) {
+        throw std::invalid_argument("invalid cpu list: " + cpu_list);
+    }
+    return cpus;
+}
+
+int cpu_count() {
+#ifdef __linux__
+    long cnt = sysconf(_SC_NPROCESSORS_CONF);
+    return int(std::min<long>(cnt > 0 ? cnt : CPU_SETSIZE, CPU_SETSIZE));
+#else
+    return int(std::thread::hardware_concurrency());
+#endif
+}
+
+int numa_node_of_cpu(int cpu) {
+#ifdef __linux__
+    static const std::vector<int> cpu_nodes = [] {
+        std::vector<int> nodes;
+        std::string list;
+        std::ifstream possible("/sys/devices/system/node/possible");
+        if (!(possible >> list))
+            return nodes;
+        for (auto node : parse_cpu_list(list)) {
+            std::string cpus;
+            std::ifstream node_cpus("/sys/devices/system/node/node" +
+                                    std::to_string(node) + "/cpulist");
+            if (!(node_cpus >> cpus))
+                continue;
+            for (auto c : parse_cpu_list(cpus)) {
+                if (c >= nodes.size())
+                    nodes.resize(c + 1, -1);
+                nodes[c] = node;
+            }
+        }
+        return nodes;
+    }();
+    if (cpu >= 0 && cpu < cpu_nodes.size())
+        return cpu_nodes[cpu];
+#endif
+    return -1;
+}
+
 END_BMF_ENGINE_NS
@@ -14,6 +14,11 @@
 
 #include "../include/split_module.h"
 #include <bmf/sdk/log.h>
+#include <bmf/sdk/audio_frame.h>
+#include <bmf/sdk/bmf_av_packet.h>
+#include <bmf/sdk/error_define.h>
+#include <bmf/sdk/exception_factory.h>
+#include <bmf/sdk/video_frame.h>
 
 SplitModule::SplitModule(int node_id, JsonParam json_param)
     : Module(node_id, json_param) {
@@ -22,9 +27,74 @@ SplitModule::SplitModule(int node_id, JsonParam json_param)
     last_output_num_ = 0;
     stream_index_ = 0;
     in_eof_ = false;
+
+    auto &option = json_param.json_value_;
+    if (option.count("strategy")) {
+        auto strategy = option.at("strategy").get<std::string>();
+        if (strategy == "round_robin")
+            strategy_ = SplitStrategy::ROUND_ROBIN;
+        else if (strategy == "queue_depth")
+            strategy_ = SplitStrategy::QUEUE_DEPTH;
+        else if (strategy == "pending_tasks")
+            strategy_ = SplitStrategy::PENDING_TASKS;
+        else
+            BMF_Error_(BMF_StsBadArg, "Unknown split strategy: %s\n",
+                       strategy.c_str());
+    }
+    if (option.count("key"))
+        key_ = option.at("key").get<std::string>();
     return;
 }
 
+// the value of field key in the json attached to the packet, or carried as
+// the packet itself
+static bool packet_key(Packet &pkt, std::string const &key,
+                       std::string &value) {
+    if (!pkt)
+        return false;
+    const JsonParam *attached = nullptr;
+    if (pkt.is<JsonParam>())
+        attached = &pkt.get<JsonParam>();
+    else if (pkt.is<VideoFrame>())
+        attached = pkt.get<VideoFrame>().private_get<JsonParam>();
+    else if (pkt.is<AudioFrame>())
+        attached = pkt.get<AudioFrame>().private_get<JsonParam>();
+    else if (pkt.is<BMFAVPacket>())
+        attached = pkt.get<BMFAVPacket>().private_get<JsonParam>();
+    if (attached == nullptr || !attached->json_value_.count(key))
+        return false;
+    value = attached->json_value_.at(key).dump();
+    return true;
+}
+
+int SplitModule::select_stream(Packet &pkt, int output_num) {
+    std::string value;
+    if (!key_.empty() && packet_key(pkt, key_, value))
+        return std::hash<std::string>()(value) % output_num;
+
+    int index = stream_index_;
+    stream_index_ = (stream_index_ + 1) % output_num;
+    if (strategy_ == SplitStrategy::ROUND_ROBIN || !load_probe_)
+        return index;
+
+    // least loaded replica, equal loads are taken in turn starting from
+    // the round robin one
+    int64_t min_load = INT64_MAX;
+    int selected = index;
+    for (int i = 0; i < output_num; i++) {
+        int stream = (index + i) % output_num;
+        ReplicaLoad load = load_probe_(stream);
+        int64_t total = load.queued + dispatched_[stream];
+        if (strategy_ == SplitStrategy::PENDING_TASKS)
+            total += load.pending_tasks;
+        if (total < min_load) {
+            min_load = total;
+            selected = stream;
+        }
+    }
+    return selected;
+}
+
 int SplitModule::process(Task &task) {
     if (task.get_inputs().size() != last_input_num_) {
         BMFLOG_NODE(BMF_DEBUG, node_id_)
@@ -45,6 +115,8 @@ int SplitModule::process(Task &task) {
     }
 
     auto input_queue = task.get_inputs()[0];
+    int output_num = task.get_outputs().size();
+    dispatched_.assign(output_num, 0);
 
     // Data Splitting
     Packet pkt;
@@ -53,21 +125,22 @@ int SplitModule::process(Task &task) {
         
         if (in_eof_ == true)
             continue;
-        // fill splitted pkt into multi output stream
-        task.fill_output_packet(stream_index_, pkt);
         if (pkt.timestamp() == BMF_EOF) {
-            // fill eof packet for extra distributed node
-            for (size_t i = 1; i < task.get_outputs().size(); i++) {
+            // every distributed node gets the eof
+            for (int i = 0; i < output_num; i++) {
                 task.fill_output_packet(i, Packet::generate_eof_packet());
             }
             in_eof_ = true;
+            continue;
         }
+        // fill splitted pkt into multi output stream
+        int stream = select_stream(pkt, output_num);
+        task.fill_output_packet(stream, pkt);
+        dispatched_[stream]++;
         BMFLOG_NODE(BMF_DEBUG, node_id_)
             << "get packet :" << pkt.timestamp()
             << " data:" << pkt.type_info().name
-            << " in queue:" << 0;
-
-        stream_index_ = (stream_index_ + 1) % task.get_outputs().size();
+            << " in queue:" << 0 << " to stream:" << stream;
     }
 
     if (in_eof_)
@@ -82,3 +155,5 @@ int SplitModule::reset() {
 }
 
 int SplitModule::close() { return 0; }
+
+REGISTER_MODULE_CLASS(SplitModule)
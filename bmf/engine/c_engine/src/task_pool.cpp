@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/task_pool.h"
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+static bool same_streams(PacketQueueMap const &queues,
+                         std::vector<int> const &stream_ids) {
+    if (queues.size() != stream_ids.size())
+        return false;
+    for (auto id : stream_ids)
+        if (queues.count(id) == 0)
+            return false;
+    return true;
+}
+
+TaskPool::TaskPool(size_t max_free) : max_free_(max_free) {
+    free_.reserve(max_free_);
+}
+
+Task TaskPool::acquire(int node_id, std::vector<int> const &input_stream_ids,
+                       std::vector<int> const &output_stream_ids) {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (!free_.empty()) {
+            Task task = std::move(free_.back());
+            free_.pop_back();
+            if (same_streams(task.inputs_queue_, input_stream_ids) &&
+                same_streams(task.outputs_queue_, output_stream_ids)) {
+                task.node_id_ = node_id;
+                task.timestamp_ = 0;
+                return task;
+            }
+            // the streams of the node changed, the rest is stale as well
+            free_.clear();
+        }
+    }
+    return Task(node_id, input_stream_ids, output_stream_ids);
+}
+
+void TaskPool::release(Task &task) {
+    for (auto *queues : {&task.inputs_queue_, &task.outputs_queue_})
+        for (auto &it : *queues)
+            if (it.second.use_count() != 1)
+                return;
+    for (auto *queues : {&task.inputs_queue_, &task.outputs_queue_})
+        for (auto &it : *queues)
+            while (!it.second->empty())
+                it.second->pop();
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (free_.size() < max_free_)
+        free_.push_back(std::move(task));
+}
+
+size_t TaskPool::size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return free_.size();
+}
+
+END_BMF_ENGINE_NS
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/assemble_module.h"
+
+#include "gtest/gtest.h"
+
+USE_BMF_SDK_NS
+
+namespace {
+
+// feeds one task with the given timestamps per replica, returns the
+// timestamps sent downstream
+std::vector<int64_t> assemble(AssembleModule &module,
+                              std::vector<std::vector<int64_t>> replicas,
+                              bool eof = false) {
+    std::vector<int> input_ids;
+    for (int i = 0; i < replicas.size(); i++)
+        input_ids.push_back(i);
+    Task task(0, input_ids, {0});
+    for (int i = 0; i < replicas.size(); i++) {
+        for (auto ts : replicas[i]) {
+            Packet pkt(std::to_string(ts));
+            pkt.set_timestamp(ts);
+            task.fill_input_packet(i, pkt);
+        }
+        if (eof)
+            task.fill_input_packet(i, Packet::generate_eof_packet());
+    }
+    EXPECT_EQ(module.process(task), 0);
+    EXPECT_EQ(task.timestamp() == DONE, eof);
+    std::vector<int64_t> out;
+    Packet pkt;
+    while (task.pop_packet_from_out_queue(0, pkt))
+        out.push_back(pkt.timestamp());
+    return out;
+}
+
+} // namespace
+
+TEST(assemble_module, timestamp_order) {
+    AssembleModule module(0, JsonParam());
+    // replica 1 got two frames in a row from a load aware split
+    EXPECT_EQ(assemble(module, {{0, 2, 5}, {1, 3, 4}}),
+              std::vector<int64_t>({0, 1, 2, 3, 4}));
+    // 5 waits until replica 1 is known not to have anything older
+    EXPECT_EQ(assemble(module, {{}, {6}}), std::vector<int64_t>({5}));
+    EXPECT_EQ(assemble(module, {{7}, {}}, true),
+              std::vector<int64_t>({6, 7, BMF_EOF}));
+}
+
+TEST(assemble_module, max_skew) {
+    JsonParam option;
+    option.parse("{\"max_skew\": 2}");
+    AssembleModule module(0, option);
+    // replica 1 lags, only the packets beyond the skew go out
+    EXPECT_EQ(assemble(module, {{0, 1, 2, 3}, {}}),
+              std::vector<int64_t>({0, 1}));
+    EXPECT_EQ(assemble(module, {{4}, {}}), std::vector<int64_t>({2}));
+    EXPECT_EQ(assemble(module, {{}, {}}, true),
+              std::vector<int64_t>({3, 4, BMF_EOF}));
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BMF_TEST_GRAPH_MODULES_H
+#define BMF_TEST_GRAPH_MODULES_H
+
+#include "../include/graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// In-process modules and a config builder for graph tests and benchmarks,
+// the modules are handed to Graph as pre_modules so nothing is loaded.
+
+BEGIN_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+// sends total packets with timestamps 0, 1, ... then eof
+class TestSource : public Module {
+  public:
+    TestSource(int node_id, int total, JsonParam option = JsonParam())
+        : Module(node_id, option), total_(total) {}
+
+    int32_t process(Task &task) override {
+        if (sent_ < total_) {
+            Packet pkt(std::to_string(sent_));
+            pkt.set_timestamp(sent_++);
+            task.fill_output_packet(0, pkt);
+        } else {
+            task.fill_output_packet(0, Packet::generate_eof_packet());
+            task.set_timestamp(DONE);
+        }
+        return 0;
+    }
+
+    int total_;
+    int sent_ = 0;
+};
+
+// forwards the packets of its input as they are
+class TestPassThrough : public Module {
+  public:
+    TestPassThrough(int node_id) : Module(node_id) {}
+
+    int32_t process(Task &task) override {
+        Packet pkt;
+        while (task.pop_packet_from_input_queue(0, pkt)) {
+            task.fill_output_packet(0, pkt);
+            if (pkt.timestamp() == BMF_EOF) {
+                task.set_timestamp(DONE);
+                break;
+            }
+        }
+        return 0;
+    }
+};
+
+// puts out a new packet for each input, like a filter
+class TestRelay : public Module {
+  public:
+    TestRelay(int node_id) : Module(node_id) {}
+
+    int32_t process(Task &task) override {
+        Packet pkt;
+        while (task.pop_packet_from_input_queue(0, pkt)) {
+            if (pkt.timestamp() == BMF_EOF) {
+                task.fill_output_packet(0, pkt);
+                task.set_timestamp(DONE);
+                continue;
+            }
+            Packet out(pkt.get<std::string>() + "'");
+            out.set_timestamp(pkt.timestamp());
+            task.fill_output_packet(0, out);
+        }
+        return 0;
+    }
+};
+
+// counts the packets of its input and checks they come in order from one
+// task at a time
+class TestSink : public Module {
+  public:
+    TestSink(int node_id, JsonParam option = JsonParam())
+        : Module(node_id, option) {}
+
+    int32_t process(Task &task) override {
+        if (running_.exchange(true))
+            overlapped_ = true;
+        Packet pkt;
+        while (task.pop_packet_from_input_queue(0, pkt)) {
+            if (pkt.timestamp() == BMF_EOF) {
+                task.set_timestamp(DONE);
+                break;
+            }
+            if (pkt.timestamp() <= last_ts_)
+                out_of_order_ = true;
+            last_ts_ = pkt.timestamp();
+            hops_ = std::max(hops_, pkt.trace_context().hops);
+            received_++;
+        }
+        running_ = false;
+        return 0;
+    }
+
+    std::atomic<bool> running_{false};
+    bool overlapped_ = false;
+    bool out_of_order_ = false;
+    int64_t last_ts_ = -1;
+    int hops_ = 0;
+    std::atomic<int> received_{0};
+};
+
+// stream i is named "s<i>"
+inline nlohmann::json test_node_json(int id, std::string const &name,
+                                     std::vector<int> const &inputs,
+                                     std::vector<int> const &outputs,
+                                     int scheduler = 0) {
+    auto streams = [](std::vector<int> const &ids) {
+        auto json = nlohmann::json::array();
+        for (auto idx : ids)
+            json.push_back({{"identifier", "s" + std::to_string(idx)}});
+        return json;
+    };
+    return {{"id", id},
+            {"module_info", {{"name", name}}},
+            {"input_streams", streams(inputs)},
+            {"output_streams", streams(outputs)},
+            {"scheduler", scheduler}};
+}
+
+inline std::shared_ptr<Graph>
+make_test_graph(nlohmann::json graph_json,
+                std::map<int, std::shared_ptr<Module>> const &pre_modules) {
+    GraphConfig graph_config(graph_json);
+    std::map<int, std::shared_ptr<ModuleCallbackLayer>> callback_bindings;
+    return std::make_shared<Graph>(graph_config, pre_modules,
+                                   callback_bindings);
+}
+
+END_BMF_ENGINE_NS
+#endif // BMF_TEST_GRAPH_MODULES_H
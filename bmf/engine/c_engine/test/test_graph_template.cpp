@@ -0,0 +1,210 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/graph.h"
+#include "../include/graph_template.h"
+#include "../include/module_pool.h"
+#include "test_graph_modules.h"
+
+#include <bmf/sdk/module_registry.h>
+
+#include "gtest/gtest.h"
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+namespace {
+
+int pool_source_inits = 0;
+int pool_source_resets = 0;
+int pool_closes = 0;
+
+// a test source sending "count" packets given by its option, made by the
+// module factory
+class PoolSource : public TestSource {
+  public:
+    PoolSource(int node_id, JsonParam option)
+        : TestSource(node_id, option.json_value_.at("count").get<int>(),
+                     option),
+          fail_reset_(option.json_value_.value("fail_reset", false)) {}
+
+    int32_t init() override {
+        pool_source_inits++;
+        return 0;
+    }
+
+    int32_t reset() override {
+        pool_source_resets++;
+        sent_ = 0;
+        return fail_reset_ ? -1 : 0;
+    }
+
+    int32_t close() override {
+        pool_closes++;
+        return 0;
+    }
+
+    bool fail_reset_;
+};
+
+int pool_sink_received = 0;
+
+class PoolSink : public TestSink {
+  public:
+    PoolSink(int node_id, JsonParam option) : TestSink(node_id, option) {}
+
+    int32_t process(Task &task) override {
+        int received = received_;
+        TestSink::process(task);
+        pool_sink_received += received_ - received;
+        return 0;
+    }
+
+    int32_t reset() override {
+        last_ts_ = -1;
+        return 0;
+    }
+
+    int32_t close() override {
+        pool_closes++;
+        return 0;
+    }
+};
+
+// the same sink without module_reusable
+class PlainSink : public PoolSink {
+  public:
+    using PoolSink::PoolSink;
+};
+
+REGISTER_MODULE_CLASS(PoolSource)
+REGISTER_MODULE_CLASS(PoolSink)
+REGISTER_MODULE_CLASS(PlainSink)
+
+REGISTER_MODULE_INFO(PoolSource, info) { info.module_reusable = true; }
+REGISTER_MODULE_INFO(PoolSink, info) { info.module_reusable = true; }
+
+std::string graph_text(int count, bool pooled,
+                       std::string const &sink = "PoolSink",
+                       bool fail_reset = false) {
+    nlohmann::json meta = {{"module_pool", pooled}};
+    nlohmann::json graph_json = {
+        {"nodes",
+         {test_node_json(0, "PoolSource", {}, {0}),
+          test_node_json(1, sink, {0}, {})}}};
+    graph_json["nodes"][0]["option"] = {{"count", count}};
+    if (fail_reset)
+        graph_json["nodes"][0]["option"]["fail_reset"] = true;
+    graph_json["nodes"][1]["option"] = nlohmann::json::object();
+    for (auto &node : graph_json["nodes"]) {
+        node["module_info"]["type"] = "c++";
+        node["meta_info"] = meta;
+    }
+    return graph_json.dump();
+}
+
+void run(GraphConfig graph_config) {
+    std::map<int, std::shared_ptr<Module>> pre_modules;
+    std::map<int, std::shared_ptr<ModuleCallbackLayer>> callback_bindings;
+    auto graph =
+        std::make_shared<Graph>(graph_config, pre_modules, callback_bindings);
+    graph->start();
+    graph->close();
+}
+
+} // namespace
+
+TEST(graph_template, instantiate) {
+    auto text = graph_text(3, false);
+    auto graph_template = GraphTemplate::get(text);
+    EXPECT_EQ(GraphTemplate::get(text), graph_template);
+    EXPECT_NE(GraphTemplate::get(text, false), graph_template);
+
+    JsonParam option(nlohmann::json({{"count", 5}}));
+    auto graph_config = graph_template->instantiate({{0, option}});
+    EXPECT_EQ(graph_config.nodes[0].get_option().json_value_.at("count"), 5);
+    // the template itself is left as it was
+    EXPECT_EQ(graph_template->instantiate()
+                  .nodes[0]
+                  .get_option()
+                  .json_value_.at("count"),
+              3);
+    EXPECT_THROW(graph_template->instantiate({{7, option}}),
+                 std::logic_error);
+
+    pool_sink_received = 0;
+    run(graph_config);
+    EXPECT_EQ(pool_sink_received, 5);
+    GraphTemplate::clear_cache();
+}
+
+TEST(graph_template, module_pool) {
+    ModulePool::instance().clear();
+    auto graph_template = GraphTemplate::get(graph_text(4, true));
+    pool_source_inits = 0;
+    pool_source_resets = 0;
+    pool_sink_received = 0;
+
+    run(graph_template->instantiate());
+    EXPECT_EQ(pool_source_inits, 1);
+    EXPECT_EQ(pool_source_resets, 1);
+    // the source and the sink are back in the pool
+    EXPECT_EQ(ModulePool::instance().size(), 2);
+
+    run(graph_template->instantiate());
+    EXPECT_EQ(pool_source_inits, 1);
+    EXPECT_EQ(pool_source_resets, 2);
+    EXPECT_EQ(pool_sink_received, 8);
+
+    // another option is another module
+    JsonParam option(nlohmann::json({{"count", 1}}));
+    run(graph_template->instantiate({{0, option}}));
+    EXPECT_EQ(pool_source_inits, 2);
+    EXPECT_EQ(pool_sink_received, 9);
+    EXPECT_EQ(ModulePool::instance().size(), 3);
+
+    ModulePool::instance().clear();
+    EXPECT_EQ(ModulePool::instance().size(), 0);
+    GraphTemplate::clear_cache();
+}
+
+TEST(graph_template, module_pool_close) {
+    ModulePool::instance().clear();
+    pool_closes = 0;
+
+    // a failed reset or no module_reusable closes the module
+    run(GraphTemplate::get(graph_text(2, true, "PoolSink", true))
+            ->instantiate());
+    EXPECT_EQ(pool_closes, 1);
+    EXPECT_EQ(ModulePool::instance().size(), 1);
+    ModulePool::instance().clear();
+    EXPECT_EQ(pool_closes, 2);
+
+    run(GraphTemplate::get(graph_text(2, true, "PlainSink"))->instantiate());
+    EXPECT_EQ(pool_closes, 3);
+    EXPECT_EQ(ModulePool::instance().size(), 1);
+    ModulePool::instance().clear();
+    EXPECT_EQ(pool_closes, 4);
+
+    // modules beyond max_free are closed
+    auto graph_config = GraphTemplate::get(graph_text(2, true))->instantiate();
+    ModulePool::instance().set_max_free(1);
+    ModulePool::instance().prepare(graph_config.nodes[0], 2);
+    EXPECT_EQ(ModulePool::instance().size(), 1);
+    EXPECT_EQ(pool_closes, 5);
+    ModulePool::instance().set_max_free(4);
+    ModulePool::instance().clear();
+    GraphTemplate::clear_cache();
+}
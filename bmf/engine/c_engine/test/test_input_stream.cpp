@@ -72,6 +72,75 @@ TEST(input_stream, add_normal_packets) {
 
 TEST(input_stream, pop_packet_at_timestamp) {}
 
+TEST(input_stream, queue_bytes_limit) {
+    std::function<void(int, bool)> throttled_cb;
+    InputStream input_stream(1, "video", "", "", 1, throttled_cb, 100);
+    input_stream.set_queue_limit(1000, 0, 0);
+    auto packets = std::make_shared<SafeQueue<Packet>>();
+    for (int i = 0; i < 3; i++) {
+        Packet pkt(std::string(400, 'x'));
+        pkt.set_timestamp(i);
+        packets->push(pkt);
+    }
+    input_stream.add_packets(packets);
+    // far below the length limit but over the byte budget
+    EXPECT_EQ(input_stream.queue_bytes_, 1200);
+    EXPECT_TRUE(input_stream.is_full());
+    input_stream.pop_next_packet(false);
+    EXPECT_EQ(input_stream.queue_bytes_, 800);
+    EXPECT_FALSE(input_stream.is_full());
+    input_stream.clear_queue();
+    EXPECT_EQ(input_stream.queue_bytes_, 0);
+
+    // payloads are not measured without a byte budget
+    InputStream unbudgeted(2, "audio", "", "", 1, throttled_cb, 100);
+    Packet pkt(std::string(400, 'x'));
+    pkt.set_timestamp(0);
+    unbudgeted.add_packet(pkt);
+    EXPECT_EQ(unbudgeted.queue_bytes_, 0);
+    unbudgeted.pop_next_packet(false);
+    EXPECT_EQ(unbudgeted.queue_bytes_, 0);
+}
+
+TEST(input_stream, adaptive_queue_size) {
+    std::function<void(int, bool)> throttled_cb;
+    InputStream input_stream(1, "video", "", "", 1, throttled_cb, 4);
+    input_stream.set_queue_limit(0, 2, 16);
+    int64_t ts = 0;
+    auto fill = [&] {
+        auto packets = std::make_shared<SafeQueue<Packet>>();
+        while (input_stream.queue_->size() + packets->size() <
+               input_stream.max_queue_size_) {
+            Packet pkt(0);
+            pkt.set_timestamp(ts++);
+            packets->push(pkt);
+        }
+        input_stream.add_packets(packets);
+    };
+    // close the adaption window now instead of waiting for the period
+    auto adapt = [&] {
+        input_stream.next_adapt_ = 0;
+        input_stream.adapt_queue_size();
+    };
+
+    // bursts which the consumer drains completely let the queue grow
+    for (int i = 0; i < 2; i++) {
+        fill();
+        while (!input_stream.is_empty())
+            input_stream.pop_next_packet(false);
+        adapt();
+    }
+    EXPECT_EQ(input_stream.max_queue_size_, 16);
+
+    // a consumer which never catches up shrinks it down to the minimum
+    for (int i = 0; i < 20; i++) {
+        fill();
+        input_stream.pop_next_packet(false);
+        adapt();
+    }
+    EXPECT_EQ(input_stream.max_queue_size_, 2);
+}
+
 // TEST(input_stream, pop_next_packet) {
 //    int stream_id = 1;
 //    std::string name = "video";
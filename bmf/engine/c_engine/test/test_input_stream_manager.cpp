@@ -75,3 +75,83 @@ TEST(input_stream_manager, schedule_node) {
     immediate_input_stream_manager.add_packets(stream_id, packets);
     immediate_input_stream_manager.schedule_node();
 }
+
+TEST(input_stream_manager, max_batch) {
+    std::vector<StreamConfig> input_stream_names(2);
+    input_stream_names[0].identifier = "video";
+    input_stream_names[1].identifier = "audio";
+    std::vector<int> output_stream_id_list = {0};
+    std::vector<Task> tasks;
+    InputStreamManagerCallBack callback;
+    callback.scheduler_cb = [&tasks](Task &task) { tasks.push_back(task); };
+    DefaultInputManager input_stream_manager(1, input_stream_names,
+                                             output_stream_id_list, 5, callback);
+    input_stream_manager.max_batch_ = 3;
+
+    for (int stream_id = 0; stream_id < 2; stream_id++) {
+        auto packets = std::make_shared<SafeQueue<Packet>>();
+        for (int64_t ts = 1; ts <= 4; ts++) {
+            Packet packet(0);
+            packet.set_timestamp(ts);
+            packets->push(packet);
+        }
+        packets->push(Packet::generate_eof_packet());
+        input_stream_manager.add_packets(stream_id, packets);
+    }
+    while (input_stream_manager.schedule_node())
+        ;
+
+    // eof is never batched with regular timestamps
+    ASSERT_EQ(tasks.size(), 3);
+    std::vector<int64_t> timestamps = {3, 4, BMF_EOF};
+    std::vector<std::vector<int64_t>> packets = {{1, 2, 3}, {4}, {BMF_EOF}};
+    for (int i = 0; i < tasks.size(); i++) {
+        EXPECT_EQ(tasks[i].timestamp(), timestamps[i]);
+        for (int stream_id = 0; stream_id < 2; stream_id++) {
+            std::vector<int64_t> got;
+            Packet pkt;
+            while (tasks[i].pop_packet_from_input_queue(stream_id, pkt))
+                got.push_back(pkt.timestamp());
+            EXPECT_EQ(got, packets[i]);
+        }
+    }
+}
+
+TEST(input_stream_manager, time_bounding) {
+    std::vector<StreamConfig> input_stream_names(2);
+    input_stream_names[0].identifier = "video";
+    input_stream_names[1].identifier = "audio";
+    std::vector<int> output_stream_id_list = {0};
+    std::vector<Task> tasks;
+    int sched_required = 0;
+    InputStreamManagerCallBack callback;
+    callback.scheduler_cb = [&tasks](Task &task) { tasks.push_back(task); };
+    callback.sched_required = [&sched_required](int, bool) {
+        sched_required++;
+    };
+    DefaultInputManager input_stream_manager(1, input_stream_names,
+                                             output_stream_id_list, 5, callback);
+
+    auto packets = std::make_shared<SafeQueue<Packet>>();
+    for (int64_t ts = 1; ts <= 2; ts++) {
+        Packet packet(0);
+        packet.set_timestamp(ts);
+        packets->push(packet);
+    }
+    input_stream_manager.add_packets(0, packets);
+    // timestamp 1 may still come on the audio stream
+    EXPECT_FALSE(input_stream_manager.schedule_node());
+
+    // the upstream dropped it
+    sched_required = 0;
+    input_stream_manager.advance_time_bounding(1, 1);
+    EXPECT_EQ(sched_required, 1);
+    ASSERT_TRUE(input_stream_manager.schedule_node());
+    ASSERT_EQ(tasks.size(), 1);
+    EXPECT_EQ(tasks[0].timestamp(), 1);
+    EXPECT_FALSE(input_stream_manager.schedule_node());
+
+    // the bound never moves back
+    input_stream_manager.advance_time_bounding(1, 0);
+    EXPECT_EQ(input_stream_manager.input_streams_[1]->get_time_bounding(), 2);
+}
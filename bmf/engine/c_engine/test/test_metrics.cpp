@@ -0,0 +1,204 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/graph.h"
+#include "../include/metrics.h"
+#include "test_graph_modules.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+TEST(metrics, histogram_export) {
+    MetricHistogram histogram;
+    histogram.observe(5000);       // 5us
+    histogram.observe(3000000);    // 3ms
+    histogram.observe(20000000000); // 20s
+    int64_t counter = 7;
+
+    MetricsRegistry registry;
+    registry.add_histogram("bmf_test_seconds", "Test durations.",
+                           {{"node", "1"}}, &histogram);
+    registry.add_counter("bmf_test_total", "Test counter.",
+                         {{"node", "1"}, {"name", "a\"b"}},
+                         [&counter] { return double(counter); });
+    auto text = registry.export_text();
+
+    EXPECT_NE(text.find("# TYPE bmf_test_seconds histogram\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_seconds_bucket{node=\"1\",le=\"1e-05\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_seconds_bucket{node=\"1\",le=\"0.005\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_seconds_bucket{node=\"1\",le=\"+Inf\"} 3\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_seconds_count{node=\"1\"} 3\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_total{node=\"1\",name=\"a\\\"b\"} 7\n"),
+              std::string::npos);
+
+    // counters are read at export time
+    counter = 9;
+    EXPECT_NE(registry.export_text().find("} 9\n"), std::string::npos);
+    registry.remove(nullptr);
+    EXPECT_EQ(registry.export_text(), "");
+}
+
+TEST(metrics, latency_percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0);
+    // 1us to 1000us, one each
+    for (int64_t us = 1; us <= 1000; us++)
+        histogram.observe(us * 1000);
+    auto near = [](int64_t value, int64_t expected) {
+        return std::abs(value - expected) <= expected / 32;
+    };
+    EXPECT_TRUE(near(histogram.percentile(0.5), 500000));
+    EXPECT_TRUE(near(histogram.percentile(0.99), 990000));
+    EXPECT_TRUE(near(histogram.percentile(0.999), 999000));
+    EXPECT_TRUE(near(histogram.percentile(1), 1000000));
+    // small values are exact
+    EXPECT_EQ(LatencyHistogram::bucket(7), 7);
+    EXPECT_EQ(LatencyHistogram::bucket(31), 31);
+    EXPECT_LT(LatencyHistogram::bucket(INT64_MAX),
+              LatencyHistogram::BUCKET_NUM);
+
+    MetricsRegistry registry;
+    registry.add_summary("bmf_test_latency_seconds", "Test latency.",
+                         {{"node", "1"}}, &histogram);
+    // registering a series again replaces it
+    registry.add_summary("bmf_test_latency_seconds", "Test latency.",
+                         {{"node", "1"}}, &histogram);
+    auto text = registry.export_text();
+    EXPECT_NE(text.find("# TYPE bmf_test_latency_seconds summary\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_latency_seconds{node=\"1\","
+                        "quantile=\"0.999\"} "),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_test_latency_seconds_count{node=\"1\"} 1000\n"),
+              std::string::npos);
+    EXPECT_EQ(text.find("bmf_test_latency_seconds_count",
+                        text.find("bmf_test_latency_seconds_count") + 1),
+              std::string::npos);
+}
+
+TEST(metrics, packet_latency) {
+    nlohmann::json graph_json = {
+        {"option", {{"latency_tracking", true}}},
+        {"nodes",
+         {test_node_json(0, "count_source", {}, {0}),
+          test_node_json(1, "count_relay", {0}, {1}),
+          test_node_json(2, "count_sink", {1}, {})}}};
+    std::map<int, std::shared_ptr<Module>> pre_modules;
+    pre_modules[0] = std::make_shared<TestSource>(0, 100);
+    pre_modules[1] = std::make_shared<TestRelay>(1);
+    auto sink = std::make_shared<TestSink>(2);
+    pre_modules[2] = sink;
+    auto graph = make_test_graph(graph_json, pre_modules);
+    graph->start();
+    graph->close();
+
+    // the relay made new packets, they carry on the source context
+    EXPECT_EQ(sink->hops_, 2);
+    auto paths = graph->get_latency();
+    ASSERT_EQ(paths.size(), 2);
+    std::sort(paths.begin(), paths.end(),
+              [](PathLatency const &a, PathLatency const &b) {
+                  return a.node < b.node;
+              });
+    EXPECT_EQ(paths[0].source, 0);
+    EXPECT_EQ(paths[0].node, 1);
+    EXPECT_EQ(paths[0].count, 100);
+    EXPECT_EQ(paths[1].source, 0);
+    EXPECT_EQ(paths[1].node, 2);
+    EXPECT_GT(paths[1].count, 0);
+    EXPECT_GT(paths[1].p50_ns, 0);
+    EXPECT_LE(paths[1].p50_ns, paths[1].p99_ns);
+    EXPECT_LE(paths[1].p99_ns, paths[1].p999_ns);
+
+    auto metrics = graph->get_metrics();
+    auto text = metrics->export_text();
+    EXPECT_NE(text.find("bmf_packet_latency_seconds_count{source=\"0\","
+                        "node=\"1\",module=\"count_relay\"} 100\n"),
+              std::string::npos);
+
+    // the readers point into the graph, they go away with it
+    graph.reset();
+    EXPECT_EQ(metrics->export_text(), "");
+}
+
+#ifndef _WIN32
+TEST(metrics, graph_metrics) {
+    std::string socket_path =
+        "/tmp/bmf_metrics_test_" + std::to_string(getpid()) + ".sock";
+    nlohmann::json graph_json = {
+        {"option", {{"metrics_listen", "unix:" + socket_path}}},
+        {"nodes",
+         {test_node_json(0, "count_source", {}, {0}),
+          test_node_json(1, "count_sink", {0}, {})}}};
+    std::map<int, std::shared_ptr<Module>> pre_modules;
+    pre_modules[0] = std::make_shared<TestSource>(0, 100);
+    pre_modules[1] = std::make_shared<TestSink>(1);
+    auto graph = make_test_graph(graph_json, pre_modules);
+    graph->start();
+    graph->close();
+
+    auto text = graph->get_metrics()->export_text();
+    // the sink takes the 100 packets and the eof in one task or more
+    EXPECT_NE(text.find("bmf_node_process_seconds_count{node=\"1\","
+                        "module=\"count_sink\"} "),
+              std::string::npos);
+    EXPECT_EQ(text.find("bmf_node_process_seconds_count{node=\"1\","
+                        "module=\"count_sink\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_stream_queue_depth{node=\"1\","
+                        "module=\"count_sink\",stream=\"s0\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("bmf_scheduler_queue_busy_seconds_total{queue=\"0\"}"),
+              std::string::npos);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(),
+                 sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(connect(fd, (sockaddr *)&addr, sizeof(addr)), 0);
+    std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(send(fd, request.data(), request.size(), 0), request.size());
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, n);
+    close(fd);
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.0 200 OK"), 0);
+    EXPECT_NE(response.find("bmf_node_process_seconds_bucket"),
+              std::string::npos);
+
+    // the socket goes away with the graph
+    graph.reset();
+    EXPECT_NE(access(socket_path.c_str(), F_OK), 0);
+}
+#endif
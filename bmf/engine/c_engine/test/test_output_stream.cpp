@@ -86,3 +86,31 @@ TEST(output_stream, propagate_packets) {
     packets->push(packet);
     output_stream.propagate_packets(packets);
 }
+
+TEST(output_stream, shared_fan_out) {
+    OutputStream output_stream(0, "video");
+    std::vector<std::shared_ptr<InputStreamManager>> mirrors(3);
+    std::vector<std::shared_ptr<CallBackForTest>> call_backs;
+    for (auto &mirror : mirrors) {
+        call_backs.push_back(initInputStreamManager(mirror));
+        output_stream.add_mirror_stream(mirror, 0);
+    }
+    auto packets = std::make_shared<std::vector<Packet>>();
+    for (int i = 0; i < 2; i++) {
+        Packet packet(std::string("frame"));
+        packet.set_timestamp(i);
+        packets->push_back(packet);
+    }
+    PacketBatch batch(packets);
+    output_stream.propagate_packets(batch);
+
+    // every mirror sees the whole batch, holding the very same packets
+    for (auto &mirror : mirrors) {
+        for (int i = 0; i < 2; i++) {
+            Packet packet = mirror->pop_next_packet(0, false);
+            EXPECT_EQ(packet.timestamp(), i);
+            EXPECT_EQ(packet.unsafe_self(), (*batch)[i].unsafe_self());
+        }
+    }
+    EXPECT_EQ(batch->size(), 2);
+}
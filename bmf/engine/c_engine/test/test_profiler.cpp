@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/profiler.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <thread>
+
+USE_BMF_ENGINE_NS
+
+namespace {
+
+const int64_t MS = 1000000;
+
+NodeProfile make_node(int id, int queue, int64_t process_ms,
+                      int64_t queued_ms, std::vector<int> downstream) {
+    NodeProfile node;
+    node.id = id;
+    node.module = "m" + std::to_string(id);
+    node.scheduler_queue = queue;
+    node.is_source = false;
+    node.tasks = 100;
+    node.process_ns = process_ms * MS;
+    node.task_ns = node.process_ns;
+    node.queued_ns = queued_ms * MS;
+    node.backpressure_ns = 0;
+    node.downstream = downstream;
+    return node;
+}
+
+} // namespace
+
+TEST(profiler, critical_path) {
+    // 0 fans out to 1 and 2 which join in 3, the branch through 2 is slower
+    // per task although 1 is busier in total
+    std::vector<NodeProfile> nodes = {
+        make_node(0, 0, 100, 0, {1, 2}), make_node(1, 0, 500, 0, {3}),
+        make_node(2, 0, 100, 500, {3}), make_node(3, 0, 100, 0, {})};
+    nodes[0].is_source = true;
+    nodes[1].tasks = 1000;
+    ProfileReport report(nodes, {{0, 800 * MS, 0}}, 1000 * MS);
+
+    EXPECT_EQ(report.critical_path_, std::vector<int>({0, 2, 3}));
+    EXPECT_EQ(report.critical_path_ns_, 8 * MS);
+    EXPECT_EQ(report.bottleneck_, 1);
+    EXPECT_NE(report.dump().find("critical path: 0 -> 2 -> 3"),
+              std::string::npos);
+}
+
+TEST(profiler, critical_path_loop) {
+    // 0 -> 1 -> 2 -> 1 loops back, the path stops before repeating a node
+    std::vector<NodeProfile> nodes = {make_node(0, 0, 100, 0, {1}),
+                                      make_node(1, 0, 100, 0, {2}),
+                                      make_node(2, 0, 100, 0, {1})};
+    nodes[0].is_source = true;
+    ProfileReport report(nodes, {{0, 300 * MS, 0}}, 1000 * MS);
+
+    EXPECT_EQ(report.critical_path_, std::vector<int>({0, 1, 2}));
+    EXPECT_EQ(report.critical_path_ns_, 3 * MS);
+}
+
+TEST(profiler, suggestions) {
+    std::vector<NodeProfile> nodes = {make_node(0, 0, 100, 0, {1}),
+                                      make_node(1, 0, 900, 0, {2}),
+                                      make_node(2, 0, 300, 0, {})};
+    nodes[0].is_source = true;
+    ProfileReport report(nodes, {{0, 1000 * MS, 0}}, 1000 * MS);
+
+    ASSERT_EQ(report.bottleneck_, 1);
+    ASSERT_EQ(report.suggestions_.size(), 2);
+    // enough replicas to get down to node 2, as far as the cpus allow
+    int dist_nums = std::min<int>(
+        3, std::max<int>(2, std::thread::hardware_concurrency()));
+    EXPECT_NE(report.suggestions_[0].find("\"dist_nums\": " +
+                                          std::to_string(dist_nums)),
+              std::string::npos);
+    // node 2 takes turns with the bottleneck on the only queue
+    EXPECT_NE(report.suggestions_[1].find("node 2"), std::string::npos);
+    EXPECT_NE(report.suggestions_[1].find("\"scheduler\": 1"),
+              std::string::npos);
+    EXPECT_NE(report.suggestions_[1].find("\"scheduler_count\": 2"),
+              std::string::npos);
+}
+
+TEST(profiler, source_bottleneck) {
+    std::vector<NodeProfile> nodes = {make_node(0, 0, 900, 0, {1}),
+                                      make_node(1, 1, 100, 0, {})};
+    nodes[0].is_source = true;
+    ProfileReport report(nodes, {{0, 900 * MS, 0}, {1, 100 * MS, 0}},
+                         1000 * MS);
+
+    EXPECT_EQ(report.bottleneck_, 0);
+    ASSERT_EQ(report.suggestions_.size(), 1);
+    EXPECT_NE(report.suggestions_[0].find("can not be distributed"),
+              std::string::npos);
+}
+
+TEST(profiler, bottleneck_by_module_process) {
+    // node 1 processes fast but spends long passing its outputs on
+    std::vector<NodeProfile> nodes = {make_node(0, 0, 100, 0, {1}),
+                                      make_node(1, 0, 100, 0, {2}),
+                                      make_node(2, 0, 300, 0, {})};
+    nodes[0].is_source = true;
+    nodes[1].task_ns = 900 * MS;
+    ProfileReport report(nodes, {{0, 1300 * MS, 0}}, 2000 * MS);
+
+    EXPECT_EQ(report.bottleneck_, 2);
+    EXPECT_NE(report.dump().find("TASK(ms)"), std::string::npos);
+}
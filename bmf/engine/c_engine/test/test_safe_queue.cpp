@@ -29,4 +29,32 @@ TEST(safe_queue, single_thread) {
     int item;
     safe_queue.pop(item);
     EXPECT_EQ(item, 1);
-}
\ No newline at end of file
+}
+
+TEST(mpsc_queue, multi_producer) {
+    MpscQueue<int> queue;
+    const int producers = 4;
+    const int per_producer = 10000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < per_producer; i++)
+                queue.push(p * per_producer + i);
+        });
+
+    // each producer's items must come out in the order they were pushed
+    std::vector<int> last(producers, -1);
+    int total = 0;
+    auto consume = [&](int &&v) {
+        int p = v / per_producer;
+        EXPECT_GT(v, last[p]);
+        last[p] = v;
+        total++;
+    };
+    while (total < producers * per_producer)
+        queue.pop_all(consume);
+    for (auto &t : threads)
+        t.join();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.pop_all(consume), 0);
+}
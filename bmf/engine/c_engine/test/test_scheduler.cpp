@@ -14,9 +14,19 @@
  * limitations under the License.
  */
 #include "../include/scheduler.h"
+#include "../include/graph.h"
+#include "test_graph_modules.h"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 USE_BMF_ENGINE_NS
 USE_BMF_SDK_NS
 TEST(scheduler, start) {
@@ -25,3 +35,294 @@ TEST(scheduler, start) {
         std::make_shared<Scheduler>(callback, 1);
     //    scheduler->start();
 }
+
+namespace {
+class SlowPassThrough : public TestPassThrough {
+  public:
+    SlowPassThrough(int node_id) : TestPassThrough(node_id) {}
+
+    int32_t process(Task &task) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return TestPassThrough::process(task);
+    }
+};
+
+void run_fan_out_graph(bool work_stealing) {
+    const int total = 200;
+    const int sinks = 4;
+    // every node is pinned to queue 0, only stealing spreads the work
+    nlohmann::json graph_json = {
+        {"option", {{"scheduler_count", 4}, {"work_stealing", work_stealing}}},
+        {"nodes", nlohmann::json::array()}};
+    graph_json["nodes"].push_back(test_node_json(0, "seq_source", {}, {0}));
+    std::map<int, std::shared_ptr<Module>> pre_modules;
+    std::vector<std::shared_ptr<TestSink>> sink_modules;
+    pre_modules[0] = std::make_shared<TestSource>(0, total);
+    for (int i = 1; i <= sinks; i++) {
+        graph_json["nodes"].push_back(test_node_json(i, "seq_sink", {0}, {}));
+        sink_modules.push_back(std::make_shared<TestSink>(i));
+        pre_modules[i] = sink_modules.back();
+    }
+    auto graph = make_test_graph(graph_json, pre_modules);
+    graph->start();
+    graph->close();
+
+    for (auto &sink : sink_modules) {
+        EXPECT_EQ(sink->received_, total);
+        EXPECT_FALSE(sink->overlapped_);
+        EXPECT_FALSE(sink->out_of_order_);
+    }
+}
+
+std::shared_ptr<TestSink> run_chain_graph(
+    int stages, int total, bool event_backpressure,
+    std::function<void(Graph &, TestSink &)> while_running = nullptr) {
+    nlohmann::json graph_json = {
+        {"option",
+         {{"scheduler_count", 2}, {"event_backpressure", event_backpressure}}},
+        {"nodes", nlohmann::json::array()}};
+    graph_json["nodes"].push_back(test_node_json(0, "seq_source", {}, {0}));
+    std::map<int, std::shared_ptr<Module>> pre_modules;
+    pre_modules[0] = std::make_shared<TestSource>(0, total);
+    for (int i = 1; i <= stages; i++) {
+        graph_json["nodes"].push_back(
+            test_node_json(i, "pass_through", {i - 1}, {i}, i % 2));
+        pre_modules[i] = std::make_shared<TestPassThrough>(i);
+    }
+    auto sink = std::make_shared<TestSink>(stages + 1);
+    graph_json["nodes"].push_back(
+        test_node_json(stages + 1, "seq_sink", {stages}, {}, 1));
+    pre_modules[stages + 1] = sink;
+
+    auto graph = make_test_graph(graph_json, pre_modules);
+    graph->start();
+    if (while_running)
+        while_running(*graph, *sink);
+    graph->close();
+    return sink;
+}
+} // namespace
+
+TEST(scheduler, fan_out) { run_fan_out_graph(false); }
+
+TEST(scheduler, work_stealing) { run_fan_out_graph(true); }
+
+TEST(scheduler, event_backpressure) {
+    for (bool event_backpressure : {false, true}) {
+        auto sink = run_chain_graph(8, 500, event_backpressure);
+        EXPECT_EQ(sink->received_, 500);
+        EXPECT_FALSE(sink->out_of_order_);
+    }
+}
+
+TEST(scheduler, pause_resume) {
+    const int total = 20000;
+    auto sink = run_chain_graph(4, total, false, [&](Graph &graph,
+                                                     TestSink &sink) {
+        // a timed pause ends by itself
+        graph.pause_running(5);
+        int received = sink.received_;
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (received < total && sink.received_ == received &&
+               std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_TRUE(received == total || sink.received_ > received);
+
+        for (int i = 0; i < 2000; i++) {
+            graph.pause_running();
+            // every queue thread is parked, nothing runs until the resume
+            received = sink.received_;
+            if (i % 100 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            EXPECT_EQ(sink.received_, received);
+            graph.resume_running();
+        }
+
+        // a timer of an earlier pause does not end a later one
+        graph.pause_running(1);
+        graph.resume_running();
+        graph.pause_running();
+        received = sink.received_;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        EXPECT_EQ(sink.received_, received);
+        graph.resume_running();
+    });
+    EXPECT_EQ(sink->received_, total);
+    EXPECT_FALSE(sink->out_of_order_);
+}
+
+TEST(scheduler, deadline_drop) {
+    const int total = 100;
+    // timestamps map to nanoseconds, all frames are due 10ms after the first
+    // one arrives while the middle node needs 2ms for each of them, the
+    // default input manager makes one task per frame
+    nlohmann::json graph_json = {
+        {"option",
+         {{"scheduler_count", 2},
+          {"latency_budget_ms", 10},
+          {"deadline_time_base", 0.000000001}}},
+        {"nodes",
+         {test_node_json(0, "seq_source", {}, {0}),
+          test_node_json(1, "slow_pass_through", {0}, {1}, 1),
+          test_node_json(2, "seq_sink", {1}, {})}}};
+    graph_json["nodes"][1]["meta_info"] = {{"drop_expired", true}};
+    graph_json["nodes"][1]["input_manager"] = "default";
+    auto sink = std::make_shared<TestSink>(2);
+    std::map<int, std::shared_ptr<Module>> pre_modules = {
+        {0, std::make_shared<TestSource>(0, total)},
+        {1, std::make_shared<SlowPassThrough>(1)},
+        {2, sink}};
+    auto graph = make_test_graph(graph_json, pre_modules);
+    graph->start();
+    graph->close();
+
+    std::shared_ptr<Node> node;
+    graph->get_node(1, node);
+    // late frames are shed, the eof still gets through
+    EXPECT_GT(node->deadline_drop_cnt_, 0);
+    EXPECT_GE(node->deadline_miss_cnt_, node->deadline_drop_cnt_);
+    EXPECT_EQ(sink->received_ + node->deadline_drop_cnt_, total);
+    EXPECT_FALSE(sink->out_of_order_);
+    auto info = graph->status().nodes[1].jsonify().json_value_;
+    EXPECT_EQ(info["deadline_drop_count"].get<int64_t>(),
+              node->deadline_drop_cnt_);
+}
+
+TEST(scheduler, choose_node_schedule) {
+    std::map<int, std::shared_ptr<Node>> nodes;
+    SchedulerCallBack callback;
+    callback.get_node_ = [&nodes](int node_id,
+                                  std::shared_ptr<Node> &node) -> int {
+        node = nodes.count(node_id) ? nodes[node_id] : nullptr;
+        return 0;
+    };
+    Scheduler scheduler(callback, 1);
+
+    NodeCallBack node_callback;
+    node_callback.scheduler_cb = [](Task &) {};
+    for (int i = 0; i < 3; i++) {
+        nlohmann::json node_json = {{"id", i},
+                                    {"module_info", {{"name", "source"}}},
+                                    {"input_streams", nlohmann::json::array()},
+                                    {"output_streams", nlohmann::json::array()}};
+        NodeConfig node_config(node_json);
+        nodes[i] = std::make_shared<Node>(
+            i, node_config, node_callback, std::make_shared<TestSource>(i, 1),
+            BmfMode::NORMAL_MODE, nullptr);
+        scheduler.add_or_remove_node(i, true);
+    }
+
+    // least recently scheduled node is picked each time
+    std::vector<int> picked;
+    for (int i = 0; i < 6; i++) {
+        std::shared_ptr<Node> node;
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        ASSERT_TRUE(scheduler.choose_node_schedule(now, node));
+        picked.push_back(node->get_id());
+    }
+    EXPECT_NE(picked[0], picked[1]);
+    EXPECT_NE(picked[1], picked[2]);
+    EXPECT_NE(picked[0], picked[2]);
+    EXPECT_EQ(std::vector<int>(picked.begin(), picked.begin() + 3),
+              std::vector<int>(picked.begin() + 3, picked.end()));
+
+    scheduler.add_or_remove_node(picked[0], false);
+    for (int i = 0; i < 4; i++) {
+        std::shared_ptr<Node> node;
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        ASSERT_TRUE(scheduler.choose_node_schedule(now, node));
+        EXPECT_NE(node->get_id(), picked[0]);
+    }
+    EXPECT_EQ(scheduler.schedule_order_.size(), 2);
+
+    // a node which cannot make progress leaves the order until it is rearmed
+    nlohmann::json node_json = {{"id", 3},
+                                {"module_info", {{"name", "sink"}}},
+                                {"input_streams", {{{"identifier", "s0"}}}},
+                                {"output_streams", nlohmann::json::array()}};
+    NodeConfig node_config(node_json);
+    nodes[3] = std::make_shared<Node>(3, node_config, node_callback,
+                                      std::make_shared<TestSink>(3),
+                                      BmfMode::NORMAL_MODE, nullptr);
+    while (!nodes[3]->too_many_tasks_pending())
+        nodes[3]->inc_pending_task();
+    scheduler.add_or_remove_node(3, true);
+    for (int i = 0; i < 4; i++) {
+        std::shared_ptr<Node> node;
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        ASSERT_TRUE(scheduler.choose_node_schedule(now, node));
+        EXPECT_NE(node->get_id(), 3);
+    }
+    EXPECT_EQ(scheduler.schedule_order_.size(), 2);
+    EXPECT_EQ(scheduler.blocked_nodes_, std::set<int>({3}));
+
+    nodes[3]->dec_pending_task();
+    scheduler.rearm_node(3);
+    std::shared_ptr<Node> node;
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    ASSERT_TRUE(scheduler.choose_node_schedule(now, node));
+    EXPECT_EQ(node->get_id(), 3);
+    EXPECT_TRUE(scheduler.blocked_nodes_.empty());
+}
+
+TEST(scheduler, parse_cpu_list) {
+    EXPECT_EQ(parse_cpu_list("0-3,8,10-11"),
+              std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parse_cpu_list("5"), std::vector<int>({5}));
+    EXPECT_TRUE(parse_cpu_list("").empty());
+    EXPECT_THROW(parse_cpu_list("3-1"), std::invalid_argument);
+    EXPECT_THROW(parse_cpu_list("a,b"), std::invalid_argument);
+}
+
+TEST(scheduler, queue_affinity) {
+    std::map<int, std::shared_ptr<Node>> nodes;
+    SchedulerCallBack callback;
+    callback.get_node_ = [&nodes](int node_id,
+                                  std::shared_ptr<Node> &node) -> int {
+        node = nodes.count(node_id) ? nodes[node_id] : nullptr;
+        return 0;
+    };
+    // any cpu this process may run on
+    int cpu = 0;
+#ifdef __linux__
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    while (!CPU_ISSET(cpu, &allowed))
+        cpu++;
+#endif
+    Scheduler scheduler(callback, 2);
+    EXPECT_THROW(scheduler.set_queue_affinity(
+                     {std::to_string(cpu_count()), "0"}, false),
+                 std::invalid_argument);
+    scheduler.set_queue_affinity({std::to_string(cpu)}, true);
+    for (auto &q : scheduler.scheduler_queues_) {
+        EXPECT_EQ(q->cpu_set_, std::vector<int>({cpu}));
+        EXPECT_EQ(q->numa_node_, numa_node_of_cpu(cpu));
+    }
+
+    NodeCallBack node_callback;
+    node_callback.sched_required = [](int, bool) { return 0; };
+    nlohmann::json node_json = {{"id", 0},
+                                {"module_info", {{"name", "source"}}},
+                                {"input_streams", nlohmann::json::array()},
+                                {"output_streams", nlohmann::json::array()}};
+    NodeConfig node_config(node_json);
+    nodes[0] = std::make_shared<Node>(0, node_config, node_callback,
+                                      std::make_shared<TestSource>(0, 10),
+                                      BmfMode::NORMAL_MODE, nullptr);
+
+    auto &q = scheduler.scheduler_queues_[0];
+    q->start();
+    for (int i = 0; i < 10; i++) {
+        Task task(0, {}, {});
+        task.set_timestamp(i);
+        q->add_task(std::move(task), 1);
+    }
+    q->close();
+#ifdef __linux__
+    EXPECT_EQ(q->last_cpu_, cpu);
+    EXPECT_EQ(q->cpu_migrations_, 0);
+#endif
+    EXPECT_EQ(q->numa_migrations_, 0);
+}
@@ -18,6 +18,9 @@
 #include "../include/scheduler_queue.h"
 
 #include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
 // bool operator<(const Item &lhs, const Item &rhs) {
 //    if (lhs.task.get_timestamp()>rhs.task.get_timestamp())
 //    {
@@ -52,4 +55,76 @@ TEST(scheduler_queue, start) {
 //    while (queue.pop(item)){
 //        std::cout<<item.task.get_timestamp()<<std::endl;
 //    }
-//}
\ No newline at end of file
+//}
+TEST(scheduler_queue, priority) {
+    SchedulerQueueCallBack callback;
+    SchedulerQueue scheduler_queue(0, callback);
+    std::vector<std::pair<int, int>> node_priorities = {{1, 0}, {2, 5}, {3, 1}};
+    for (auto &np : node_priorities) {
+        Task task(np.first, {}, {});
+        task.set_timestamp(10 - np.first);
+        scheduler_queue.add_task(std::move(task), np.second);
+    }
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 2);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 3);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 1);
+}
+
+TEST(scheduler_queue, size_without_drain) {
+    SchedulerQueueCallBack callback;
+    SchedulerQueue scheduler_queue(0, callback);
+    for (int i = 0; i < 3; i++) {
+        Task task(i, {}, {});
+        task.set_timestamp(i);
+        scheduler_queue.add_task(std::move(task), 0);
+    }
+    // other threads only read the count, the tasks stay in the inbox
+    EXPECT_EQ(scheduler_queue.size(), 3);
+    EXPECT_FALSE(scheduler_queue.inbox_.empty());
+    EXPECT_TRUE(scheduler_queue.snapshot().empty());
+
+    scheduler_queue.drain_inbox();
+    auto items = scheduler_queue.snapshot();
+    ASSERT_EQ(items.size(), 3);
+    EXPECT_EQ(items[0].task.node_id_, 0);
+    EXPECT_EQ(scheduler_queue.size(), 3);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 0);
+    EXPECT_EQ(scheduler_queue.size(), 2);
+}
+
+TEST(scheduler_queue, earliest_deadline_first) {
+    SchedulerQueueCallBack callback;
+    SchedulerQueue scheduler_queue(0, callback);
+    // node 3 has no deadline, the rest go by deadline not timestamp
+    std::vector<std::pair<int, int64_t>> node_deadlines = {
+        {1, 300}, {2, 100}, {3, INT64_MAX}, {4, 200}};
+    for (auto &nd : node_deadlines) {
+        Task task(nd.first, {}, {});
+        task.set_timestamp(nd.first);
+        scheduler_queue.add_task(std::move(task), 0, nd.second);
+    }
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 2);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 4);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 1);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 3);
+}
+
+TEST(scheduler_queue, priority_aging) {
+    SchedulerQueueCallBack callback;
+    SchedulerQueue scheduler_queue(0, callback);
+    scheduler_queue.aging_period_ = 1000000; // 1ms
+
+    Task low(1, {}, {});
+    low.set_timestamp(1);
+    scheduler_queue.add_task(std::move(low), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    Task high(2, {}, {});
+    high.set_timestamp(1);
+    scheduler_queue.add_task(std::move(high), 2);
+
+    // the low priority task waited long enough to overtake
+    scheduler_queue.drain_inbox();
+    scheduler_queue.age_tasks();
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 1);
+    EXPECT_EQ(scheduler_queue.pop_task().task.node_id_, 2);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/split_module.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+USE_BMF_SDK_NS
+
+namespace {
+
+// one input and three replicas, returns the number of packets each replica
+// got, EOF excluded
+std::vector<int> split(SplitModule &module, std::vector<Packet> pkts) {
+    Task task(0, {0}, {0, 1, 2});
+    for (auto &pkt : pkts)
+        task.fill_input_packet(0, pkt);
+    EXPECT_EQ(module.process(task), 0);
+    std::vector<int> counts;
+    for (auto &output : task.get_outputs()) {
+        int count = 0;
+        for (; !output.second->empty(); output.second->pop())
+            if (output.second->front().timestamp() != BMF_EOF)
+                count++;
+        counts.push_back(count);
+    }
+    return counts;
+}
+
+std::vector<Packet> frames(int count) {
+    std::vector<Packet> pkts;
+    for (int i = 0; i < count; i++) {
+        Packet pkt(std::to_string(i));
+        pkt.set_timestamp(i);
+        pkts.push_back(pkt);
+    }
+    return pkts;
+}
+
+} // namespace
+
+TEST(split_module, round_robin) {
+    SplitModule module(0, JsonParam());
+    EXPECT_EQ(split(module, frames(6)), std::vector<int>({2, 2, 2}));
+}
+
+TEST(split_module, pending_tasks) {
+    JsonParam option;
+    option.parse("{\"strategy\": \"pending_tasks\"}");
+    SplitModule module(0, option);
+    // replica 0 is backed up
+    std::vector<ReplicaLoad> loads(3);
+    loads[0].pending_tasks = 5;
+    loads[2].queued = 1;
+    module.load_probe_ = [&loads](int stream) { return loads[stream]; };
+
+    auto counts = split(module, frames(6));
+    EXPECT_EQ(counts[0], 0);
+    EXPECT_EQ(counts[1] + counts[2], 6);
+    EXPECT_LE(std::abs(counts[1] - (counts[2] + 1)), 1);
+
+    // queue depth ignores the tasks already scheduled
+    option.parse("{\"strategy\": \"queue_depth\"}");
+    SplitModule depth_module(0, option);
+    depth_module.load_probe_ = module.load_probe_;
+    counts = split(depth_module, frames(5));
+    EXPECT_EQ(counts, std::vector<int>({2, 2, 1}));
+}
+
+TEST(split_module, key_affinity) {
+    JsonParam option;
+    option.parse("{\"strategy\": \"pending_tasks\", \"key\": \"scene\"}");
+    SplitModule module(0, option);
+    int calls = 0;
+    module.load_probe_ = [&calls](int stream) {
+        calls++;
+        return ReplicaLoad();
+    };
+
+    std::vector<Packet> pkts;
+    for (int i = 0; i < 9; i++) {
+        JsonParam meta;
+        meta.parse("{\"scene\": 7}");
+        Packet pkt(meta);
+        pkt.set_timestamp(i);
+        pkts.push_back(pkt);
+    }
+    auto counts = split(module, pkts);
+    // one replica gets the whole scene, load is not looked at
+    std::sort(counts.begin(), counts.end());
+    EXPECT_EQ(counts, std::vector<int>({0, 0, 9}));
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(split_module, eof_to_all_replicas) {
+    SplitModule module(0, JsonParam());
+    Task task(0, {0}, {0, 1, 2});
+    Packet pkt(std::string("frame"));
+    pkt.set_timestamp(0);
+    task.fill_input_packet(0, pkt);
+    task.fill_input_packet(0, Packet::generate_eof_packet());
+    EXPECT_EQ(module.process(task), 0);
+    for (auto &output : task.get_outputs()) {
+        ASSERT_FALSE(output.second->empty());
+        EXPECT_EQ(output.second->back().timestamp(), BMF_EOF);
+    }
+    EXPECT_EQ(task.timestamp(), DONE);
+}
+
+TEST(split_module, unknown_strategy) {
+    JsonParam option;
+    option.parse("{\"strategy\": \"random\"}");
+    EXPECT_THROW(SplitModule(0, option), std::exception);
+}
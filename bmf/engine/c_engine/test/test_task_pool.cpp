@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "../include/task_pool.h"
+
+#include "gtest/gtest.h"
+
+USE_BMF_ENGINE_NS
+USE_BMF_SDK_NS
+
+TEST(task_pool, recycle) {
+    TaskPool pool;
+    Task task = pool.acquire(1, {0, 1}, {0});
+    EXPECT_EQ(task.node_id_, 1);
+    EXPECT_EQ(task.get_inputs().size(), 2);
+    EXPECT_EQ(task.get_outputs().size(), 1);
+    EXPECT_EQ(pool.size(), 0);
+
+    task.set_timestamp(10);
+    task.fill_input_packet(0, Packet(0));
+    auto queue = task.get_inputs()[0].get();
+    pool.release(task);
+    EXPECT_EQ(pool.size(), 1);
+
+    // the same streams reuse the queues, emptied and with a fresh timestamp
+    Task reused = pool.acquire(2, {0, 1}, {0});
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(reused.node_id_, 2);
+    EXPECT_EQ(reused.timestamp(), 0);
+    EXPECT_EQ(reused.get_inputs()[0].get(), queue);
+    EXPECT_TRUE(reused.input_queue_empty(0));
+}
+
+TEST(task_pool, shared_queues_not_recycled) {
+    TaskPool pool;
+    Task task = pool.acquire(1, {0}, {0});
+    task.fill_input_packet(0, Packet(0));
+    Task copy = task;
+    pool.release(task);
+    EXPECT_EQ(pool.size(), 0);
+    // the copy still sees its packet
+    EXPECT_FALSE(copy.input_queue_empty(0));
+}
+
+TEST(task_pool, changed_streams) {
+    TaskPool pool;
+    Task a = pool.acquire(1, {0}, {0});
+    Task b = pool.acquire(1, {0}, {0});
+    pool.release(a);
+    pool.release(b);
+    EXPECT_EQ(pool.size(), 2);
+
+    Task task = pool.acquire(1, {0, 1}, {0});
+    EXPECT_EQ(task.get_inputs().size(), 2);
+    EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(task_pool, max_free) {
+    TaskPool pool(2);
+    std::vector<Task> tasks;
+    for (int i = 0; i < 4; i++)
+        tasks.push_back(pool.acquire(1, {0}, {0}));
+    for (auto &task : tasks)
+        pool.release(task);
+    EXPECT_EQ(pool.size(), 2);
+}
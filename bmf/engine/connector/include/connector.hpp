@@ -24,6 +24,7 @@
 #include <bmf/sdk/packet.h>
 #include <bmf/sdk/module.h>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <stdint.h>
@@ -51,6 +52,20 @@ class BMF_ENGINE_API BMFGraph {
     BMFGraph(std::string const &graph_config, bool is_path = false,
                           bool need_merge = true);
 
+    /*
+     * @brief Create a BMF Graph instance from a cached graph template, the
+     * config is only parsed and optimized the first time it is seen.
+     * @param [in] graph_config Config string in serialized json style.
+     * @param [in] node_options Options in serialized json style replacing
+     * those of the nodes with the given ids, e.g. the input and output of
+     * decoders and encoders.
+     * @param [in] need_merge Same as for the constructor.
+     */
+    static BMFGraph
+    from_template(std::string const &graph_config,
+                  std::map<int, std::string> const &node_options = {},
+                  bool need_merge = true);
+
     BMFGraph(BMFGraph const &graph);
 
     ~BMFGraph();
@@ -106,6 +121,8 @@ class BMF_ENGINE_API BMFGraph {
     GraphRunningInfo status();
 
   private:
+    explicit BMFGraph(uint32_t graph_uid);
+
     uint32_t graph_uid_;
 };
 
@@ -88,6 +88,11 @@ typedef struct SchedulerQueueInfo {
     std::string state;
     int64_t started_at;
     size_t queue_size;
+    std::vector<int> cpu_affinity;
+    int32_t numa_node;
+    int32_t last_cpu;
+    int64_t cpu_migrations;
+    int64_t numa_migrations;
     std::vector<TaskInfo> tasks;
 
     JsonParam jsonify() {
@@ -96,6 +101,11 @@ typedef struct SchedulerQueueInfo {
         ret["state"] = state;
         ret["started_at"] = started_at;
         ret["queue_size"] = queue_size;
+        ret["cpu_affinity"] = cpu_affinity;
+        ret["numa_node"] = numa_node;
+        ret["last_cpu"] = last_cpu;
+        ret["cpu_migrations"] = cpu_migrations;
+        ret["numa_migrations"] = numa_migrations;
         ret["tasks"] = nlohmann::json::array();
         for (auto &t : tasks)
             ret["tasks"].push_back(t.jsonify().json_value_);
@@ -143,6 +153,8 @@ typedef struct InputStreamInfo {
     uint64_t prev_id, nex_id;
     uint64_t max_size;
     uint64_t size;
+    uint64_t max_bytes;
+    uint64_t bytes;
     std::string name;
     std::vector<PacketInfo> packets;
 
@@ -153,6 +165,8 @@ typedef struct InputStreamInfo {
         ret["nex_id"] = nex_id;
         ret["max_size"] = max_size;
         ret["size"] = size;
+        ret["max_bytes"] = max_bytes;
+        ret["bytes"] = bytes;
         ret["name"] = name;
         ret["packets"] = nlohmann::json::array();
         for (auto &p : packets)
@@ -211,6 +225,8 @@ typedef struct NodeRunningInfo {
     uint64_t task_processed;
     uint64_t schedule_count;
     uint64_t schedule_success_count;
+    uint64_t deadline_miss_count;
+    uint64_t deadline_drop_count;
     NodeModuleInfo module_info;
     std::vector<InputStreamInfo> input_streams;
     std::vector<OutputStreamInfo> output_streams;
@@ -228,6 +244,8 @@ typedef struct NodeRunningInfo {
         ret["task_processed"] = task_processed;
         ret["schedule_count"] = schedule_count;
         ret["schedule_success_count"] = schedule_success_count;
+        ret["deadline_miss_count"] = deadline_miss_count;
+        ret["deadline_drop_count"] = deadline_drop_count;
         ret["module_info"] = module_info.jsonify().json_value_;
         ret["input_streams"] = nlohmann::json::array();
         for (auto &s : input_streams)
@@ -20,6 +20,7 @@
 #include "../../c_engine/include/callback_layer.h"
 #include "../../c_engine/include/graph_config.h"
 #include "../../c_engine/include/graph.h"
+#include "../../c_engine/include/graph_template.h"
 #include "../../c_engine/include/module_factory.h"
 #include "../../c_engine/include/optimizer.h"
 
@@ -36,6 +37,41 @@
 using json_t = nlohmann::json;
 
 namespace bmf {
+
+// pre-modules and callbacks registered through the connector, looked up
+// by the ids in the node meta
+static void bind_node_instances(
+    bmf_engine::GraphConfig &g_config,
+    std::map<int, std::shared_ptr<bmf_sdk::Module>> &created_modules,
+    std::map<int, std::shared_ptr<bmf_engine::ModuleCallbackLayer>>
+        &callback_bindings) {
+    for (auto &nd : g_config.nodes) {
+        auto meta = nd.meta;
+        callback_bindings[nd.id] =
+            std::make_shared<bmf_engine::ModuleCallbackLayer>();
+        if (meta.get_premodule_id() > 0) {
+            if (!internal::ConnectorMapping::ModuleInstanceMapping().exist(
+                    meta.get_premodule_id()))
+                throw std::logic_error("Trying to use an unexisted premodule.");
+            created_modules[nd.id] =
+                internal::ConnectorMapping::ModuleInstanceMapping().get(
+                    meta.get_premodule_id());
+        }
+
+        // copied, the registered callback binds every graph instantiated
+        // from the same template
+        for (auto cb : meta.get_callback_binding()) {
+            if (!internal::ConnectorMapping::ModuleCallbackInstanceMapping()
+                     .exist(cb.second))
+                throw std::logic_error("Trying to bind an unexisted callback.");
+            callback_bindings[nd.id]->add_callback(
+                cb.first,
+                *internal::ConnectorMapping::ModuleCallbackInstanceMapping()
+                     .get(cb.second));
+        }
+    }
+}
+
 BMFGraph::BMFGraph(const std::string &graph_config, bool is_path,
                    bool need_merge) {
 
@@ -80,29 +116,7 @@ BMFGraph::BMFGraph(const std::string &graph_config, bool is_path,
     // dump merged graph
     bmf_engine::Optimizer::dump_graph(g_config, true);
 
-    for (auto &nd : g_config.nodes) {
-        auto meta = nd.meta;
-        callback_bindings[nd.id] =
-            std::make_shared<bmf_engine::ModuleCallbackLayer>();
-        if (meta.get_premodule_id() > 0) {
-            if (!internal::ConnectorMapping::ModuleInstanceMapping().exist(
-                    meta.get_premodule_id()))
-                throw std::logic_error("Trying to use an unexisted premodule.");
-            created_modules[nd.id] =
-                internal::ConnectorMapping::ModuleInstanceMapping().get(
-                    meta.get_premodule_id());
-        }
-
-        for (auto cb : meta.get_callback_binding()) {
-            if (!internal::ConnectorMapping::ModuleCallbackInstanceMapping()
-                     .exist(cb.second))
-                throw std::logic_error("Trying to bind an unexisted callback.");
-            callback_bindings[nd.id]->add_callback(
-                cb.first,
-                std::move(*internal::ConnectorMapping::ModuleCallbackInstanceMapping()
-                     .get(cb.second)));
-        }
-    }
+    bind_node_instances(g_config, created_modules, callback_bindings);
 
     // Clean up pre-modules.
     std::map<int, std::shared_ptr<bmf_sdk::Module>> all_created_modules;
@@ -125,6 +139,29 @@ BMFGraph::BMFGraph(const std::string &graph_config, bool is_path,
         internal::ConnectorMapping::GraphInstanceMapping().insert(g_instance);
 }
 
+BMFGraph::BMFGraph(uint32_t graph_uid) : graph_uid_(graph_uid) {}
+
+BMFGraph BMFGraph::from_template(std::string const &graph_config,
+                                 std::map<int, std::string> const &node_options,
+                                 bool need_merge) {
+    auto graph_template =
+        bmf_engine::GraphTemplate::get(graph_config, need_merge);
+    std::map<int, bmf_sdk::JsonParam> options;
+    for (auto &it : node_options)
+        options[it.first] = bmf_sdk::JsonParam(json_t::parse(it.second));
+    auto g_config = graph_template->instantiate(options);
+
+    std::map<int, std::shared_ptr<bmf_sdk::Module>> created_modules;
+    std::map<int, std::shared_ptr<bmf_engine::ModuleCallbackLayer>>
+        callback_bindings;
+    bind_node_instances(g_config, created_modules, callback_bindings);
+    auto g_instance = std::make_shared<bmf_engine::Graph>(
+        g_config, created_modules, callback_bindings);
+
+    return BMFGraph(
+        internal::ConnectorMapping::GraphInstanceMapping().insert(g_instance));
+}
+
 BMFGraph::BMFGraph(BMFGraph const &graph) {
     graph_uid_ = graph.graph_uid_;
     internal::ConnectorMapping::GraphInstanceMapping().ref(graph_uid_);
@@ -164,12 +164,21 @@ if(HMP_ENABLE_FFMPEG)
     endif()
 endif()
 
-##### libyuv(deprecated)
-#add_subdirectory(third_party/libyuv)
-#target_include_directories(yuv
-#    INTERFACE
-#        $<BUILD_INTERFACE:${PROJECT_SOURCE_DIR}/third_party/libyuv/include>)
-#list(APPEND HMP_CORE_PRI_DEPS yuv)
+##### libyuv
+if(HMP_ENABLE_LIBYUV)
+    find_path(LIBYUV_INCLUDE_DIR libyuv.h)
+    find_library(LIBYUV_LIBRARY yuv)
+    if(NOT LIBYUV_INCLUDE_DIR OR NOT LIBYUV_LIBRARY)
+        message("libyuv not found, disable it")
+        set(HMP_ENABLE_LIBYUV OFF)
+    else()
+        add_library(libyuv::yuv UNKNOWN IMPORTED)
+        set_target_properties(libyuv::yuv PROPERTIES
+            IMPORTED_LOCATION ${LIBYUV_LIBRARY}
+            INTERFACE_INCLUDE_DIRECTORIES ${LIBYUV_INCLUDE_DIR})
+        list(APPEND HMP_CORE_PRI_DEPS libyuv::yuv)
+    endif()
+endif()
 
 
 ##### OpenCV
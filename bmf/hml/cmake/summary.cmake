@@ -26,6 +26,7 @@ if(HMP_ENABLE_OPENCV)
     message(STATUS "    OPENCV Libraries      : ${OpenCV_LIBS}")
 endif()
 message(STATUS     "  NPP_ENABLED             : ${HMP_ENABLE_NPP}")
+message(STATUS     "  LIBYUV_ENABLED          : ${HMP_ENABLE_LIBYUV}")
 message(STATUS     "  OPENMP_ENABLED          : ${HMP_ENABLE_OPENMP}")
 if(HMP_ENABLE_OPENMP)
     message(STATUS "     OpenMP_CXX_FLAGS     : ${OpenMP_CXX_FLAGS}")
@@ -58,6 +58,30 @@ struct HMP_API Allocator {
 };
 using AllocatorFlags = Allocator::Flags;
 
+// Stats of the default kCPU allocator. It caches freed blocks by size
+// class, blocks up to 1 MiB in a cache of the freeing thread, bigger ones in
+// a shared pool, and hands them out again for the same size class.
+struct CPUAllocatorStats {
+    int64_t active = 0; // bytes allocated and not freed yet
+    int64_t active_peak = 0;
+    int64_t cached = 0; // bytes freed and kept for reuse
+    int64_t cache_limit = 0;
+    int64_t alloc_count = 0; // calls of alloc()
+    int64_t cache_hits = 0;  // allocations served from a cache
+    int64_t system_allocs = 0;
+    int64_t system_frees = 0;
+};
+
+HMP_API CPUAllocatorStats cpu_allocator_stats();
+
+// freed blocks are released to the system once the cache holds this many
+// bytes, 0 disables caching. It starts at HMP_CPU_CACHE_LIMIT_MB (1024 if
+// not set)
+HMP_API void set_cpu_cache_limit(int64_t bytes);
+
+// release the shared pool and the cache of the calling thread
+HMP_API void empty_cpu_cache();
+
 HMP_API void set_allocator(DeviceType device, Allocator *allocator,
                            unsigned flags = 0);
 HMP_API Allocator *get_allocator(DeviceType device, unsigned flags = 0);
@@ -84,6 +84,27 @@ HMP_API int64_t device_count(DeviceType device_type);
 HMP_API optional<Device> current_device(DeviceType device_type);
 HMP_API void set_current_device(const Device &device);
 
+// Kernel backends of kCPU from lowest to highest rank, see
+// kernel/dispatch_stub.h. Generic kernels exist for every op, the others
+// only for some ops and cases.
+enum class CPUBackend : int8_t {
+    Generic = 0,
+    LibYUV, // built with HMP_ENABLE_LIBYUV
+    SIMD,   // hand-written AVX2 (x86_64) or NEON (aarch64) kernels
+
+    NumCPUBackends
+};
+
+HMP_API std::string stringfy(const CPUBackend &backend);
+
+// built in and supported by this CPU
+HMP_API bool cpu_backend_available(CPUBackend backend);
+
+// highest backend used by kCPU kernels, the default is the highest available
+// one or HMP_CPU_BACKEND (generic, libyuv or simd) if it is set
+HMP_API CPUBackend cpu_backend();
+HMP_API void set_cpu_backend(CPUBackend backend);
+
 namespace impl {
 
 struct DeviceManager {
@@ -98,6 +98,21 @@ HMP_API Tensor normalize(const Tensor &src, const Tensor &mean,
 HMP_API Tensor &normalize(Tensor &dst, const Tensor &src, const Tensor &mean,
                           const Tensor &std, ChannelFormat cformat = kNCHW);
 
+// yuv_to_rgb, resize and normalize in one pass: dst is a float32 or half
+// NCHW image of the output size holding (rgb - mean) / std, rgb_format is
+// PF_RGB24 or PF_BGR24 for the channel order. uint8 YUV inputs only
+HMP_API Tensor &preprocess(Tensor &dst, const TensorList &src,
+                           const PixelInfo &pix_info, const Tensor &mean,
+                           const Tensor &std,
+                           ImageFilterMode mode = ImageFilterMode::Bilinear,
+                           PixelFormat rgb_format = PF_RGB24);
+HMP_API Tensor preprocess(const TensorList &src, const PixelInfo &pix_info,
+                          int width, int height, const Tensor &mean,
+                          const Tensor &std,
+                          ImageFilterMode mode = ImageFilterMode::Bilinear,
+                          ScalarType dtype = kFloat32,
+                          PixelFormat rgb_format = PF_RGB24);
+
 //
 HMP_API Tensor &erode(Tensor &dst, const Tensor &src,
                       const optional<Tensor> &kernel = nullopt,
@@ -267,10 +267,20 @@ const static ImageRotationMode kRotate270 = ImageRotationMode::Rotate270;
 
 HMP_API std::string stringfy(const ImageRotationMode &mode);
 
-enum class ImageFilterMode : uint8_t { Nearest, Bilinear, Bicubic };
+// Area averages the covered source pixels (box filter), Lanczos uses a
+// 3-lobe kernel widened by the scale factor when downscaling
+enum class ImageFilterMode : uint8_t {
+    Nearest,
+    Bilinear,
+    Bicubic,
+    Area,
+    Lanczos
+};
 const static ImageFilterMode kNearest = ImageFilterMode::Nearest;
 const static ImageFilterMode kBilinear = ImageFilterMode::Bilinear;
 const static ImageFilterMode kBicubic = ImageFilterMode::Bicubic;
+const static ImageFilterMode kArea = ImageFilterMode::Area;
+const static ImageFilterMode kLanczos = ImageFilterMode::Lanczos;
 
 HMP_API std::string stringfy(const ImageFilterMode &mode);
 
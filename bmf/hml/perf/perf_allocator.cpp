@@ -44,6 +44,30 @@ BENCHMARK_TEMPLATE(BM_allocator, kCPU, false)
     ->Threads(8)
     ->Unit(benchmark::kMicrosecond);
 
+// a decoder-like pattern: a few 4K NV12 frames in flight, each freed a few
+// frames later, arg(0) == 0 disables the CPU allocator cache
+void BM_frame_allocator(benchmark::State &state) {
+    auto limit = cpu_allocator_stats().cache_limit;
+    set_cpu_cache_limit(state.range(0) ? limit : 0);
+    auto options = TensorOptions(kUInt8).device(kCPU);
+    auto system_allocs = cpu_allocator_stats().system_allocs;
+
+    std::vector<Tensor> frames(4);
+    int64_t n = 0;
+    for (auto _ : state) {
+        auto frame = empty({2160 * 3 / 2, 3840}, options);
+        // a decoder writes the whole frame, touch a page of it at least
+        frame.data<uint8_t>()[0] = 1;
+        frames[n++ % frames.size()] = frame;
+    }
+    frames.clear();
+    state.counters["system_allocs"] =
+        cpu_allocator_stats().system_allocs - system_allocs;
+    set_cpu_cache_limit(limit);
+}
+
+BENCHMARK(BM_frame_allocator)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
 #ifdef HMP_ENABLE_CUDA
 BENCHMARK_TEMPLATE(BM_allocator, kCPU, true)
     ->Args({42, 4 << 20})
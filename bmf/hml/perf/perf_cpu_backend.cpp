@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hmp/imgproc.h>
+#include <benchmark/benchmark.h>
+
+using namespace hmp;
+
+namespace {
+
+// a kCPU kernel on a YUV420P frame with the backends capped at arg(0),
+// args(1, 2) are the frame size, the output is 1/scale of it. A backend
+// which is not built in or not supported by this CPU is skipped, an op
+// without a kernel in the backend runs the one ranked below it
+template <typename Op>
+void BM_cpu_backend(benchmark::State &state, Op op, int scale) {
+    auto backend = static_cast<CPUBackend>(state.range(0));
+    if (!cpu_backend_available(backend)) {
+        state.SkipWithError("backend not available");
+        return;
+    }
+    auto width = state.range(1);
+    auto height = state.range(2);
+    auto pix_info = PixelInfo(PF_YUV420P);
+    auto src = Frame(width, height, pix_info);
+    for (int i = 0; i < src.nplanes(); ++i) {
+        src.plane(i).fill_(i * 64 + 16);
+    }
+    auto dst = Frame(width / scale, height / scale, pix_info);
+
+    auto saved = cpu_backend();
+    set_cpu_backend(backend);
+    for (auto _ : state) {
+        op(dst.data(), src.data(), pix_info);
+    }
+    set_cpu_backend(saved);
+    state.SetLabel(stringfy(backend));
+    state.SetBytesProcessed(state.iterations() * width * height * 3 / 2);
+}
+
+void mirror_op(TensorList &dst, const TensorList &src,
+               const PixelInfo &pix_info) {
+    img::yuv_mirror(dst, src, pix_info, ImageAxis::Horizontal);
+}
+
+template <ImageFilterMode Mode>
+void resize_op(TensorList &dst, const TensorList &src,
+               const PixelInfo &pix_info) {
+    img::yuv_resize(dst, src, pix_info, Mode);
+}
+
+void common_resolutions(benchmark::internal::Benchmark *b) {
+    for (int backend = 0;
+         backend < static_cast<int>(CPUBackend::NumCPUBackends); ++backend) {
+        b->Args({backend, 1280, 720});
+        b->Args({backend, 1920, 1080});
+        b->Args({backend, 3840, 2160});
+    }
+    b->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK_CAPTURE(BM_cpu_backend, yuv_mirror, mirror_op, 1)
+    ->Apply(common_resolutions);
+BENCHMARK_CAPTURE(BM_cpu_backend, yuv_resize,
+                  resize_op<ImageFilterMode::Bilinear>, 2)
+    ->Apply(common_resolutions);
+BENCHMARK_CAPTURE(BM_cpu_backend, yuv_resize_bicubic,
+                  resize_op<ImageFilterMode::Bicubic>, 2)
+    ->Apply(common_resolutions);
+BENCHMARK_CAPTURE(BM_cpu_backend, yuv_resize_area,
+                  resize_op<ImageFilterMode::Area>, 2)
+    ->Apply(common_resolutions);
+BENCHMARK_CAPTURE(BM_cpu_backend, yuv_resize_lanczos,
+                  resize_op<ImageFilterMode::Lanczos>, 2)
+    ->Apply(common_resolutions);
+
+} // namespace
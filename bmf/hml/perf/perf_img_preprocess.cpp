@@ -0,0 +1,62 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hmp/imgproc.h>
+#include <benchmark/benchmark.h>
+
+using namespace hmp;
+
+namespace {
+
+// NV12 frame of args(1, 2) to a normalized float32 NCHW tensor of
+// args(3, 4), arg(0) selects yuv_to_rgb -> resize -> normalize (0) or
+// img::preprocess (1)
+void BM_img_preprocess(benchmark::State &state) {
+    auto fused = state.range(0);
+    auto swidth = state.range(1);
+    auto sheight = state.range(2);
+    auto dwidth = state.range(3);
+    auto dheight = state.range(4);
+    auto pix_info = PixelInfo(PF_NV12);
+    auto src = Frame(swidth, sheight, pix_info);
+    for (int i = 0; i < src.nplanes(); ++i) {
+        src.plane(i).fill_(i * 64 + 16);
+    }
+    auto mean = empty({3}, kFloat32).fill_(128);
+    auto std = empty({3}, kFloat32).fill_(64);
+    auto dst = empty({1, 3, dheight, dwidth}, kFloat32);
+
+    for (auto _ : state) {
+        if (fused) {
+            img::preprocess(dst, src.data(), pix_info, mean, std);
+        } else {
+            auto rgb = img::yuv_to_rgb(src.data(), pix_info, kNCHW);
+            auto resized = img::resize(rgb, dwidth, dheight,
+                                       ImageFilterMode::Bilinear, kNCHW);
+            img::normalize(dst, resized.unsqueeze(0), mean, std, kNCHW);
+        }
+    }
+    state.SetLabel(fused ? "fused" : "unfused");
+}
+
+BENCHMARK(BM_img_preprocess)
+    ->Args({0, 1920, 1080, 640, 640})
+    ->Args({1, 1920, 1080, 640, 640})
+    ->Args({0, 1920, 1080, 224, 224})
+    ->Args({1, 1920, 1080, 224, 224})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
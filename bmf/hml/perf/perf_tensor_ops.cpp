@@ -0,0 +1,84 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <hmp/tensor.h>
+#include <benchmark/benchmark.h>
+
+using namespace hmp;
+
+namespace {
+
+// a 1080p RGB frame, arg(0) selects the layout: 0 contiguous, 1 a crop of
+// a wider frame (rows are contiguous), 2 a transposed view (nothing is)
+Tensor frame(ScalarType dtype, int64_t layout) {
+    const int64_t width = 1920, height = 1080;
+    Tensor t;
+    if (layout == 0) {
+        t = empty({height, width, 3}, dtype);
+    } else if (layout == 1) {
+        t = empty({height, width + 128, 3}, dtype).slice(1, 0, width);
+    } else {
+        t = empty({width, height, 3}, dtype).transpose(0, 1);
+    }
+    return t.fill_(3);
+}
+
+// in place ops, so only the op itself is measured
+template <typename Op>
+void BM_binary_ops(benchmark::State &state, ScalarType dtype, Op op) {
+    auto a = frame(dtype, state.range(0));
+    auto b = frame(dtype, state.range(0)).fill_(1);
+    for (auto _ : state) {
+        op(a, b);
+    }
+    state.SetBytesProcessed(state.iterations() * a.nbytes() * 3);
+}
+
+template <typename Op>
+void BM_unary_ops(benchmark::State &state, ScalarType dtype, Op op) {
+    auto a = frame(dtype, state.range(0));
+    for (auto _ : state) {
+        op(a);
+    }
+    state.SetBytesProcessed(state.iterations() * a.nbytes() * 2);
+}
+
+void add_op(Tensor &a, const Tensor &b) { a += b; }
+
+void mul_op(Tensor &a, const Tensor &b) { a *= b; }
+
+void mul_scalar_op(Tensor &a) { a *= 1; }
+
+void clip_op(Tensor &a) { a.clip_(1, 200); }
+
+void round_op(Tensor &a) { a.round_(); }
+
+void layouts(benchmark::internal::Benchmark *b) {
+    b->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK_CAPTURE(BM_binary_ops, add_u8, kUInt8, add_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_binary_ops, add_f32, kFloat32, add_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_binary_ops, mul_u8, kUInt8, mul_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_binary_ops, mul_f32, kFloat32, mul_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_unary_ops, mul_scalar_u8, kUInt8, mul_scalar_op)
+    ->Apply(layouts);
+BENCHMARK_CAPTURE(BM_unary_ops, clip_u8, kUInt8, clip_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_unary_ops, clip_f32, kFloat32, clip_op)->Apply(layouts);
+BENCHMARK_CAPTURE(BM_unary_ops, round_f32, kFloat32, round_op)
+    ->Apply(layouts);
+
+} // namespace
@@ -19,6 +19,7 @@
 #endif
 #include <pybind11/pybind11.h>
 #include <hmp/core/logging.h>
+#include <hmp/core/allocator.h>
 #include <hmp/core/scalar_type.h>
 #include <hmp/core/device.h>
 #include <hmp/core/stream.h>
@@ -110,4 +111,18 @@ void coreBind(py::module &m) {
         .def("device", &Timer::device);
 
     m.def("create_timer", &create_timer, py::arg("device_type") = kCPU);
+
+    py::class_<CPUAllocatorStats>(m, "CPUAllocatorStats")
+        .def_readonly("active", &CPUAllocatorStats::active)
+        .def_readonly("active_peak", &CPUAllocatorStats::active_peak)
+        .def_readonly("cached", &CPUAllocatorStats::cached)
+        .def_readonly("cache_limit", &CPUAllocatorStats::cache_limit)
+        .def_readonly("alloc_count", &CPUAllocatorStats::alloc_count)
+        .def_readonly("cache_hits", &CPUAllocatorStats::cache_hits)
+        .def_readonly("system_allocs", &CPUAllocatorStats::system_allocs)
+        .def_readonly("system_frees", &CPUAllocatorStats::system_frees);
+
+    m.def("cpu_allocator_stats", &cpu_allocator_stats);
+    m.def("set_cpu_cache_limit", &set_cpu_cache_limit, py::arg("bytes"));
+    m.def("empty_cpu_cache", &empty_cpu_cache);
 }
@@ -121,6 +121,8 @@ void imageBind(py::module &m) {
         .value("kNearest", ImageFilterMode::Nearest)
         .value("kBilinear", ImageFilterMode::Bilinear)
         .value("kBicubic", ImageFilterMode::Bicubic)
+        .value("kArea", ImageFilterMode::Area)
+        .value("kLanczos", ImageFilterMode::Lanczos)
         .export_values();
 
     py::enum_<ImageRotationMode>(m, "ImageRotationMode")
@@ -367,6 +369,25 @@ void imageBind(py::module &m) {
             py::arg("src"), py::arg("mean"), py::arg("std"),
             py::arg("format") = kNCHW);
 
+    img.def("preprocess",
+            (Tensor & (*)(Tensor &, const TensorList &, const PixelInfo &,
+                          const Tensor &, const Tensor &, ImageFilterMode,
+                          PixelFormat)) &
+                img::preprocess,
+            py::arg("dst"), py::arg("src"), py::arg("pix_info"),
+            py::arg("mean"), py::arg("std"),
+            py::arg("mode") = ImageFilterMode::Bilinear,
+            py::arg("rgb_format") = PF_RGB24);
+    img.def("preprocess",
+            (Tensor(*)(const TensorList &, const PixelInfo &, int, int,
+                       const Tensor &, const Tensor &, ImageFilterMode,
+                       ScalarType, PixelFormat)) &
+                img::preprocess,
+            py::arg("src"), py::arg("pix_info"), py::arg("width"),
+            py::arg("height"), py::arg("mean"), py::arg("std"),
+            py::arg("mode") = ImageFilterMode::Bilinear,
+            py::arg("dtype") = kFloat32, py::arg("rgb_format") = PF_RGB24);
+
     img.def("erode",
             (Tensor & (*)(Tensor &, const Tensor &, const optional<Tensor> &,
                           ChannelFormat)) &
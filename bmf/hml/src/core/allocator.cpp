@@ -17,6 +17,15 @@
 #include <hmp/core/logging.h>
 #include <hmp/core/allocator.h>
 #include <hmp/core/scalar_type.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace hmp {
 
@@ -26,17 +35,306 @@ void dummyDeleter(void *) {
 
 namespace {
 
-class CPUAllocator : public Allocator {
+constexpr size_t kCPUAlignment = 64; // cache line, and AVX-512 loads
+constexpr size_t kCPUPageSize = 4096;
+// blocks up to this size are cached per thread, bigger ones are rounded to
+// pages and kept in the shared pool
+constexpr size_t kCPUSmallSize = 1 << 20;
+constexpr size_t kThreadCacheBlocks = 8; // per size class
+constexpr size_t kThreadCacheBytes = 16 << 20;
+// 64 bytes, then 4 classes per power of two up to kCPUSmallSize
+constexpr int kSmallClasses = 1 + 14 * 4;
+
+inline int floor_log2(size_t v) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return int(idx);
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+inline size_t cpu_block_size(size_t size) {
+    if (size <= kCPUAlignment) {
+        return kCPUAlignment;
+    }
+    if (size > kCPUSmallSize) {
+        return (size + kCPUPageSize - 1) / kCPUPageSize * kCPUPageSize;
+    }
+    auto step = (size_t(1) << floor_log2(size - 1)) / 4;
+    return (size + step - 1) / step * step;
+}
+
+// index of a small block size given by cpu_block_size
+inline int cpu_size_class(size_t bsize) {
+    if (bsize <= kCPUAlignment) {
+        return 0;
+    }
+    auto exp = floor_log2(bsize - 1);
+    auto step = (size_t(1) << exp) / 4;
+    return 1 + (exp - 6) * 4 + int(bsize / step) - 5;
+}
+
+// inverse of cpu_size_class
+inline size_t cpu_class_size(int idx) {
+    if (idx == 0) {
+        return kCPUAlignment;
+    }
+    auto step = (size_t(1) << (6 + (idx - 1) / 4)) / 4;
+    return step * (5 + (idx - 1) % 4);
+}
+
+void *cpu_system_alloc(size_t bsize) {
+    auto alignment = bsize > kCPUSmallSize ? kCPUPageSize : kCPUAlignment;
+#ifdef _WIN32
+    return _aligned_malloc(bsize, alignment);
+#else
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, bsize) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+void cpu_system_free(void *ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+class CPUCachingAllocator;
+CPUCachingAllocator &cpu_caching_allocator();
+
+// small blocks freed by this thread, handed back to the shared pool when
+// the thread exits or the cache is full
+struct CPUThreadCache {
+    std::vector<void *> blocks[kSmallClasses];
+    size_t bytes = 0;
+
+    ~CPUThreadCache();
+};
+
+// set by ~CPUThreadCache, blocks freed later by the exiting thread, e.g. from
+// other thread_local destructors, bypass the cache. A plain bool has no
+// destructor, so it can still be read then
+static thread_local bool sThreadCacheDestroyed = false;
+
+// Reuses freed blocks of the same size class instead of going to
+// malloc/free for every frame. Cached bytes are kept below cache_limit
+// (checked without locking, so it may be exceeded by a few blocks when
+// threads free at the same time).
+class CPUCachingAllocator : public Allocator {
   public:
+    CPUCachingAllocator() {
+        int64_t limit_mb = 1024;
+        if (auto env = getenv("HMP_CPU_CACHE_LIMIT_MB")) {
+            limit_mb = std::max<int64_t>(atoll(env), 0);
+        }
+        limit_ = limit_mb << 20;
+    }
+
     DataPtr alloc(int64_t size) override {
-        // TODO: alignment support
-        auto ptr = malloc(size);
-        HMP_REQUIRE(ptr, "CPU out of memory");
-        return DataPtr(ptr, free, kCPU);
+        alloc_count_.fetch_add(1, std::memory_order_relaxed);
+        auto bsize = cpu_block_size(std::max<int64_t>(size, 0));
+        auto ptr = take_cached(bsize);
+        if (ptr) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ptr = cpu_system_alloc(bsize);
+            if (!ptr) { // give the cached blocks back and retry
+                empty_cache();
+                ptr = cpu_system_alloc(bsize);
+            }
+            HMP_REQUIRE(ptr, "CPU out of memory");
+            system_allocs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto nbytes = int64_t(bsize);
+        auto active =
+            active_.fetch_add(nbytes, std::memory_order_relaxed) + nbytes;
+        auto peak = active_peak_.load(std::memory_order_relaxed);
+        while (active > peak && !active_peak_.compare_exchange_weak(
+                                    peak, active, std::memory_order_relaxed)) {
+        }
+        return DataPtr(ptr, [bsize](void *p) {
+            cpu_caching_allocator().release(p, bsize);
+        }, kCPU);
+    }
+
+    void release(void *ptr, size_t bsize) {
+        active_.fetch_sub(bsize, std::memory_order_relaxed);
+        if (cached_.load(std::memory_order_relaxed) + int64_t(bsize) >
+            limit_.load(std::memory_order_relaxed)) {
+            system_free(ptr);
+            return;
+        }
+        cached_.fetch_add(bsize, std::memory_order_relaxed);
+
+        auto cache = bsize <= kCPUSmallSize ? thread_cache() : nullptr;
+        if (cache) {
+            auto &blocks = cache->blocks[cpu_size_class(bsize)];
+            if (blocks.size() < kThreadCacheBlocks &&
+                cache->bytes + bsize <= kThreadCacheBytes) {
+                blocks.push_back(ptr);
+                cache->bytes += bsize;
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> l(mutex_);
+        pool_[bsize].push_back(ptr);
+    }
+
+    // move the blocks of an exiting thread to the shared pool
+    void flush(CPUThreadCache &cache) {
+        std::lock_guard<std::mutex> l(mutex_);
+        for (int i = 0; i < kSmallClasses; ++i) {
+            auto &blocks = cache.blocks[i];
+            if (!blocks.empty()) {
+                auto &pooled = pool_[cpu_class_size(i)];
+                pooled.insert(pooled.end(), blocks.begin(), blocks.end());
+                blocks.clear();
+            }
+        }
+        cache.bytes = 0;
+    }
+
+    // trims the shared pool and the cache of the calling thread, other
+    // threads hand their blocks over when they exit
+    void set_limit(int64_t limit) {
+        limit_ = std::max<int64_t>(limit, 0);
+        auto cache = thread_cache();
+        if (cache && cached_.load() > limit_.load()) {
+            flush(*cache);
+        }
+        std::lock_guard<std::mutex> l(mutex_);
+        // largest blocks first
+        for (auto it = pool_.rbegin(); it != pool_.rend() &&
+                                       cached_.load() > limit_.load();
+             ++it) {
+            auto &blocks = it->second;
+            while (!blocks.empty() && cached_.load() > limit_.load()) {
+                cached_.fetch_sub(it->first, std::memory_order_relaxed);
+                system_free(blocks.back());
+                blocks.pop_back();
+            }
+        }
+    }
+
+    void empty_cache() {
+        if (auto cache = thread_cache()) {
+            for (int i = 0; i < kSmallClasses; ++i) {
+                auto bsize = cpu_class_size(i);
+                for (auto ptr : cache->blocks[i]) {
+                    cached_.fetch_sub(bsize, std::memory_order_relaxed);
+                    system_free(ptr);
+                }
+                cache->blocks[i].clear();
+            }
+            cache->bytes = 0;
+        }
+
+        std::lock_guard<std::mutex> l(mutex_);
+        for (auto &it : pool_) {
+            for (auto ptr : it.second) {
+                cached_.fetch_sub(it.first, std::memory_order_relaxed);
+                system_free(ptr);
+            }
+        }
+        pool_.clear();
+    }
+
+    CPUAllocatorStats stats() const {
+        CPUAllocatorStats stats;
+        stats.active = active_.load(std::memory_order_relaxed);
+        stats.active_peak = active_peak_.load(std::memory_order_relaxed);
+        stats.cached = cached_.load(std::memory_order_relaxed);
+        stats.cache_limit = limit_.load(std::memory_order_relaxed);
+        stats.alloc_count = alloc_count_.load(std::memory_order_relaxed);
+        stats.cache_hits = hits_.load(std::memory_order_relaxed);
+        stats.system_allocs = system_allocs_.load(std::memory_order_relaxed);
+        stats.system_frees = system_frees_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+  private:
+    // null once the cache of the calling thread is destroyed
+    static CPUThreadCache *thread_cache() {
+        if (sThreadCacheDestroyed) {
+            return nullptr;
+        }
+        static thread_local CPUThreadCache cache;
+        return &cache;
     }
+
+    void *take_cached(size_t &bsize) {
+        if (limit_.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        void *ptr = nullptr;
+        auto cache = bsize <= kCPUSmallSize ? thread_cache() : nullptr;
+        if (cache) {
+            auto &blocks = cache->blocks[cpu_size_class(bsize)];
+            if (!blocks.empty()) {
+                ptr = blocks.back();
+                blocks.pop_back();
+                cache->bytes -= bsize;
+            }
+        }
+        if (!ptr) {
+            std::lock_guard<std::mutex> l(mutex_);
+            // small blocks must match their class, a large one may be up to
+            // 1/8 bigger than asked for
+            auto it = pool_.lower_bound(bsize);
+            auto max_size = bsize > kCPUSmallSize ? bsize + bsize / 8 : bsize;
+            for (; it != pool_.end() && it->first <= max_size; ++it) {
+                if (!it->second.empty()) {
+                    ptr = it->second.back();
+                    it->second.pop_back();
+                    bsize = it->first;
+                    break;
+                }
+            }
+        }
+        if (ptr) {
+            cached_.fetch_sub(bsize, std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    void system_free(void *ptr) {
+        cpu_system_free(ptr);
+        system_frees_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::mutex mutex_;
+    std::map<size_t, std::vector<void *>> pool_; // by block size
+    std::atomic<int64_t> limit_{0};
+    std::atomic<int64_t> cached_{0};
+    std::atomic<int64_t> active_{0};
+    std::atomic<int64_t> active_peak_{0};
+    std::atomic<int64_t> alloc_count_{0};
+    std::atomic<int64_t> hits_{0};
+    std::atomic<int64_t> system_allocs_{0};
+    std::atomic<int64_t> system_frees_{0};
 };
 
-static CPUAllocator sDefaultCPUAllocator;
+// never destroyed, blocks may be freed by thread caches and static objects
+// after the end of main
+CPUCachingAllocator &cpu_caching_allocator() {
+    static auto allocator = new CPUCachingAllocator();
+    return *allocator;
+}
+
+CPUThreadCache::~CPUThreadCache() {
+    sThreadCacheDestroyed = true;
+    cpu_caching_allocator().flush(*this);
+}
+
+static Allocator *sDefaultCPUAllocator = &cpu_caching_allocator();
 
 //+1(Pinned CPU allocator)
 const static int sNumberDeviceTypes =
@@ -49,6 +347,16 @@ HMP_DECLARE_ALLOCATOR(kCPU, 0);
 HMP_DECLARE_ALLOCATOR(kCPU, 1);
 HMP_DECLARE_ALLOCATOR(kCUDA, 0);
 
+HMP_API CPUAllocatorStats cpu_allocator_stats() {
+    return cpu_caching_allocator().stats();
+}
+
+HMP_API void set_cpu_cache_limit(int64_t bytes) {
+    cpu_caching_allocator().set_limit(bytes);
+}
+
+HMP_API void empty_cpu_cache() { cpu_caching_allocator().empty_cache(); }
+
 HMP_API void set_allocator(DeviceType device, Allocator *allocator,
                            unsigned flags) {
     HMP_REQUIRE(device < DeviceType::NumDeviceTypes, "invalid device type {}",
@@ -80,6 +388,6 @@ HMP_API Allocator *get_allocator(DeviceType device, unsigned flags) {
     }
 }
 
-HMP_REGISTER_ALLOCATOR(kCPU, &sDefaultCPUAllocator, 0);
+HMP_REGISTER_ALLOCATOR(kCPU, sDefaultCPUAllocator, 0);
 
 } // namespace hmp
\ No newline at end of file
@@ -146,6 +146,10 @@ std::string stringfy(const ImageFilterMode &mode) {
         return "kBilinear";
     case ImageFilterMode::Bicubic:
         return "kBicubic";
+    case ImageFilterMode::Area:
+        return "kArea";
+    case ImageFilterMode::Lanczos:
+        return "kLanczos";
     default:
         return fmt::format("ImageFilterMode({})", static_cast<int>(mode));
     }
@@ -419,6 +419,31 @@ Tensor &normalize(Tensor &dst, const Tensor &src, const Tensor &mean,
     return kernel::img_normalize(dst, src, mean, std, cformat);
 }
 
+Tensor &preprocess(Tensor &dst, const TensorList &src,
+                   const PixelInfo &pix_info, const Tensor &mean,
+                   const Tensor &std, ImageFilterMode mode,
+                   PixelFormat rgb_format) {
+    auto pformat = infer_ppixel_format(pix_info);
+    return kernel::yuv_preprocess(dst, src, pformat, mean, std, mode,
+                                  rgb_format);
+}
+
+Tensor preprocess(const TensorList &src, const PixelInfo &pix_info, int width,
+                  int height, const Tensor &mean, const Tensor &std,
+                  ImageFilterMode mode, ScalarType dtype,
+                  PixelFormat rgb_format) {
+    auto has_batch_dim = src[0].dim() == 4;
+    auto batch = has_batch_dim ? src[0].size(0) : int64_t(1);
+    auto dst = empty({batch, int64_t(3), int64_t(height), int64_t(width)},
+                     src[0].options().dtype(dtype));
+    preprocess(dst, src, pix_info, mean, std, mode, rgb_format);
+
+    if (!has_batch_dim) {
+        dst.squeeze_(0);
+    }
+    return dst;
+}
+
 Tensor &erode(Tensor &dst, const Tensor &src, const optional<Tensor> &kernel_,
               ChannelFormat cformat) {
     Tensor kernel;
@@ -32,7 +32,7 @@ Tensor &mul_scalar_cpu(Tensor &out, const Tensor &ina, const Scalar &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "mul_scalar_cpu", [&]() {
         auto b = inb.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, ina,
-                                            [&](scalar_t a) { return a * b; });
+                                            [b](scalar_t a) { return a * b; });
     });
     return out;
 }
@@ -49,7 +49,7 @@ Tensor &add_scalar_cpu(Tensor &out, const Tensor &ina, const Scalar &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "add_scalar_cpu", [&]() {
         auto b = inb.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, ina,
-                                            [&](scalar_t a) { return a + b; });
+                                            [b](scalar_t a) { return a + b; });
     });
     return out;
 }
@@ -66,7 +66,7 @@ Tensor &sub_scalar_cpu(Tensor &out, const Tensor &ina, const Scalar &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "sub_scalar_cpu", [&]() {
         auto b = inb.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, ina,
-                                            [&](scalar_t a) { return a - b; });
+                                            [b](scalar_t a) { return a - b; });
     });
     return out;
 }
@@ -75,7 +75,7 @@ Tensor &sub_scalar2_cpu(Tensor &out, const Scalar &ina, const Tensor &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "sub_scalar_cpu", [&]() {
         auto a = ina.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, inb,
-                                            [&](scalar_t b) { return a - b; });
+                                            [a](scalar_t b) { return a - b; });
     });
     return out;
 }
@@ -92,7 +92,7 @@ Tensor &div_scalar_cpu(Tensor &out, const Tensor &ina, const Scalar &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "div_scalar_cpu", [&]() {
         auto b = inb.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, ina,
-                                            [&](scalar_t a) { return a / b; });
+                                            [b](scalar_t a) { return a / b; });
     });
     return out;
 }
@@ -101,7 +101,7 @@ Tensor &div_scalar2_cpu(Tensor &out, const Scalar &ina, const Tensor &inb) {
     HMP_DISPATCH_ALL_TYPES_AND_HALF(out.scalar_type(), "div_scalar_cpu", [&]() {
         auto a = ina.to<scalar_t>();
         cpu::uop_kernel<scalar_t, scalar_t>(out, inb,
-                                            [&](scalar_t b) { return a / b; });
+                                            [a](scalar_t b) { return a / b; });
     });
     return out;
 }
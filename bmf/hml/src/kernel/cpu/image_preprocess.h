@@ -0,0 +1,163 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <kernel/imgproc.h>
+#include <kernel/cpu/image_resize.h>
+
+namespace hmp {
+namespace kernel {
+namespace cpu {
+
+// Fused yuv_to_rgb + resize + normalize. The planes are resized in YUV with
+// the separable filter (chroma straight from its own resolution), then each
+// output row is converted, clamped to [0, 255] and normalized while it is
+// still in cache. Nothing is rounded to 8 bits in between.
+
+// limited range YUV to RGB, same coefficients as YUV2RGB
+struct YUVMatrix {
+    float y, rv, gu, gv, bu;
+};
+
+inline YUVMatrix yuv_matrix(PPixelFormat format) {
+    switch (format) {
+    case PPixelFormat::H420:
+    case PPixelFormat::H422:
+    case PPixelFormat::H444:
+    case PPixelFormat::NV12_BT709:
+    case PPixelFormat::NV21_BT709:
+        return {1.164384f, 1.792741f, -0.213249f, -0.532909f, 2.112402f};
+    case PPixelFormat::I420:
+    case PPixelFormat::I422:
+    case PPixelFormat::I444:
+    case PPixelFormat::NV12:
+    case PPixelFormat::NV21:
+        return {1.164384f, 1.596027f, -0.391762f, -0.812968f, 2.017232f};
+    default:
+        break;
+    }
+    HMP_REQUIRE(false, "yuv_preprocess: unsupported PPixelFormat {}", format);
+    return {};
+}
+
+// CC is the channels of the chroma planes, 1 for planar and 2 for NV12/NV21
+template <typename OT, int CC, typename Ops>
+void yuv_preprocess(Tensor &dst, const TensorList &src, PPixelFormat format,
+                    const int64_t *channel, const float *scale,
+                    const float *bias, ImageFilterMode mode) {
+    const int nchroma = 3 - CC;
+    auto m = yuv_matrix(format);
+    auto batch = dst.size(0);
+    auto dheight = dst.size(2);
+    auto dwidth = dst.size(3);
+    auto xc = resize_coeffs(src[0].size(2), dwidth, mode);
+    auto yc = resize_coeffs(src[0].size(1), dheight, mode);
+    auto cxc = resize_coeffs(src[1].size(2), dwidth, mode);
+    auto cyc = resize_coeffs(src[1].size(1), dheight, mode);
+    // offsets of u and v in the resized chroma row
+    int64_t uoff = 0, voff = CC == 1 ? dwidth : 1;
+    if (format == PPixelFormat::NV21 || format == PPixelFormat::NV21_BT709) {
+        std::swap(uoff, voff);
+    }
+
+    parallel_for(0, batch * dheight, 16, [&](int64_t begin, int64_t end) {
+        ResizeRowCache<uint8_t, 1, Ops> ycache(xc, yc, dwidth);
+        std::vector<ResizeRowCache<uint8_t, CC, Ops>> ccache;
+        for (int i = 0; i < nchroma; ++i) {
+            ccache.emplace_back(cxc, cyc, dwidth);
+        }
+        std::vector<float> yrow(dwidth), crow(2 * dwidth);
+        for (int64_t r = begin; r < end; ++r) {
+            auto n = r / dheight;
+            auto y = r % dheight;
+            auto rows = ycache.rows(src[0].data<uint8_t>() +
+                                        n * src[0].stride(0),
+                                    src[0].stride(1), n, y);
+            Ops::vertical(yrow.data(), rows, ycache.weights(y), ycache.ntaps(),
+                          dwidth);
+            for (int i = 0; i < nchroma; ++i) {
+                auto &plane = src[1 + i];
+                rows = ccache[i].rows(plane.data<uint8_t>() +
+                                          n * plane.stride(0),
+                                      plane.stride(1), n, y);
+                Ops::vertical(crow.data() + i * dwidth, rows,
+                              ccache[i].weights(y), ccache[i].ntaps(),
+                              dwidth * CC);
+            }
+
+            auto out = dst.data<OT>() + n * dst.stride(0) + y * dst.stride(2);
+            auto r_out = out + channel[0], g_out = out + channel[1],
+                 b_out = out + channel[2];
+            auto yp = yrow.data(), up = crow.data() + uoff,
+                 vp = crow.data() + voff;
+            for (int64_t x = 0; x < dwidth; ++x) {
+                auto luma = (yp[x] - 16.f) * m.y;
+                auto u = up[x * CC] - 128.f;
+                auto v = vp[x * CC] - 128.f;
+                auto rv = std::min(std::max(luma + m.rv * v, 0.f), 255.f);
+                auto gv = std::min(std::max(luma + m.gu * u + m.gv * v, 0.f),
+                                   255.f);
+                auto bv = std::min(std::max(luma + m.bu * u, 0.f), 255.f);
+                r_out[x] = OT(rv * scale[0] + bias[0]);
+                g_out[x] = OT(gv * scale[1] + bias[1]);
+                b_out[x] = OT(bv * scale[2] + bias[2]);
+            }
+        }
+    });
+}
+
+// dst is a (N, 3, H, W) float32 or half image, src are uint8 NHWC planes
+template <typename Ops>
+Tensor &yuv_preprocess(Tensor &dst, const TensorList &src, PPixelFormat format,
+                       const Tensor &mean, const Tensor &std,
+                       ImageFilterMode mode, PixelFormat rformat) {
+    HMP_REQUIRE(rformat == PF_RGB24 || rformat == PF_BGR24,
+                "yuv_preprocess: unsupported RGB PixelFormat {}", rformat);
+    for (auto &plane : src) {
+        HMP_REQUIRE(plane.scalar_type() == kUInt8,
+                    "yuv_preprocess: expect uint8 planes, got {}",
+                    plane.scalar_type());
+    }
+
+    // (rgb - mean) / std as rgb * scale + bias, all in R, G, B order
+    auto fmean = mean.to(kFloat32);
+    auto fstd = std.to(kFloat32);
+    int64_t channel[3];
+    float scale[3], bias[3];
+    for (int i = 0; i < 3; ++i) {
+        auto c = rformat == PF_BGR24 ? 2 - i : i;
+        channel[i] = c * dst.stride(1);
+        scale[i] = 1.f / fstd.data<float>()[c * fstd.stride(0)];
+        bias[i] = -fmean.data<float>()[c * fmean.stride(0)] * scale[i];
+    }
+
+    HMP_DISPATCH_FLOAT32_AND_HALF(dst.scalar_type(), "yuv_preprocess", [&]() {
+        // kernel::yuv_preprocess checked the planes match the format
+        if (src.size() == 2) {
+            yuv_preprocess<scalar_t, 2, Ops>(dst, src, format, channel, scale,
+                                             bias, mode);
+        } else {
+            yuv_preprocess<scalar_t, 1, Ops>(dst, src, format, channel, scale,
+                                             bias, mode);
+        }
+    });
+
+    return dst;
+}
+
+} // namespace cpu
+} // namespace kernel
+} // namespace hmp
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <kernel/kernel_utils.h>
+#include <kernel/parallel.h>
+#include <hmp/imgproc/formats.h>
+#include <cmath>
+#include <vector>
+
+namespace hmp {
+namespace kernel {
+namespace cpu {
+
+// Separable resize: each source row is resized horizontally once into a
+// float row, each output row is a weighted sum of these rows. The taps of
+// both axes are computed once per call.
+
+// taps of each output pixel along one axis, source indices are clamped to
+// the border like kBReplicate
+struct ResizeCoeffs {
+    int ntaps = 0;
+    int64_t ssize = 0;
+    std::vector<int> index;    // dsize * ntaps
+    std::vector<float> weight; // dsize * ntaps
+    // the same taps ordered by tap, [t * dsize + i], for kernels working
+    // on several outputs at once
+    std::vector<int> tap_index;
+    std::vector<float> tap_weight;
+};
+
+inline double cubic_weight(double x) {
+    const double A = -0.75; // same as Filter<Bicubic>
+    x = std::fabs(x);
+    if (x <= 1) {
+        return ((A + 2) * x - (A + 3)) * x * x + 1;
+    } else if (x < 2) {
+        return ((A * x - 5 * A) * x + 8 * A) * x - 4 * A;
+    }
+    return 0;
+}
+
+inline double lanczos3_weight(double x) {
+    const double pi = 3.14159265358979323846;
+    x = std::fabs(x);
+    if (x < 1e-6) {
+        return 1;
+    } else if (x >= 3) {
+        return 0;
+    }
+    return 3 * std::sin(pi * x) * std::sin(pi * x / 3) / (pi * pi * x * x);
+}
+
+inline ResizeCoeffs resize_coeffs(int64_t ssize, int64_t dsize,
+                                  ImageFilterMode mode) {
+    ResizeCoeffs coeffs;
+    double scale = double(ssize) / dsize;
+    // Lanczos is widened when downscaling so every source pixel counts
+    double stretch = mode == ImageFilterMode::Lanczos ? std::max(scale, 1.0)
+                                                      : 1.0;
+    switch (mode) {
+    case ImageFilterMode::Nearest:
+        coeffs.ntaps = 1;
+        break;
+    case ImageFilterMode::Bilinear:
+        coeffs.ntaps = 2;
+        break;
+    case ImageFilterMode::Bicubic:
+        coeffs.ntaps = 4;
+        break;
+    case ImageFilterMode::Area:
+        coeffs.ntaps = int(std::ceil(scale)) + 1;
+        break;
+    case ImageFilterMode::Lanczos:
+        coeffs.ntaps = 2 * int(std::ceil(3 * stretch));
+        break;
+    default:
+        HMP_REQUIRE(false, "resize_coeffs: unsupported filter mode {}", mode);
+    }
+
+    auto ntaps = coeffs.ntaps;
+    coeffs.ssize = ssize;
+    coeffs.index.resize(dsize * ntaps);
+    coeffs.weight.resize(dsize * ntaps);
+    coeffs.tap_index.resize(dsize * ntaps);
+    coeffs.tap_weight.resize(dsize * ntaps);
+    std::vector<double> w(ntaps);
+    for (int64_t i = 0; i < dsize; ++i) {
+        int64_t first;
+        double sum = 0;
+        if (mode == ImageFilterMode::Nearest) {
+            // same as Filter<Nearest>
+            first = int64_t(i * scale);
+            w[0] = sum = 1;
+        } else if (mode == ImageFilterMode::Area) {
+            // overlap of each source pixel with [i, i + 1) * scale
+            double begin = i * scale, end = (i + 1) * scale;
+            first = int64_t(std::floor(begin));
+            for (int t = 0; t < ntaps; ++t) {
+                auto lo = std::max<double>(begin, first + t);
+                auto hi = std::min<double>(end, first + t + 1);
+                w[t] = std::max(hi - lo, 0.0);
+                sum += w[t];
+            }
+        } else {
+            // same sampling position as Filter<Bilinear/Bicubic>
+            double center = (i + 0.5) * scale - 0.5;
+            first = int64_t(std::floor(center)) - ntaps / 2 + 1;
+            for (int t = 0; t < ntaps; ++t) {
+                auto x = (first + t - center) / stretch;
+                switch (mode) {
+                case ImageFilterMode::Bilinear:
+                    w[t] = std::max(1 - std::fabs(x), 0.0);
+                    break;
+                case ImageFilterMode::Bicubic:
+                    w[t] = cubic_weight(x);
+                    break;
+                default:
+                    w[t] = lanczos3_weight(x);
+                    break;
+                }
+                sum += w[t];
+            }
+        }
+
+        for (int t = 0; t < ntaps; ++t) {
+            coeffs.index[i * ntaps + t] =
+                int(std::min<int64_t>(std::max<int64_t>(first + t, 0),
+                                      ssize - 1));
+            coeffs.weight[i * ntaps + t] = float(w[t] / sum);
+            coeffs.tap_index[t * dsize + i] = coeffs.index[i * ntaps + t];
+            coeffs.tap_weight[t * dsize + i] = coeffs.weight[i * ntaps + t];
+        }
+    }
+    return coeffs;
+}
+
+template <typename T, int C>
+void resize_horizontal(float *out, const T *src, const ResizeCoeffs &xc,
+                       int64_t dwidth) {
+    auto ntaps = xc.ntaps;
+    for (int64_t x = 0; x < dwidth; ++x) {
+        auto index = &xc.index[x * ntaps];
+        auto weight = &xc.weight[x * ntaps];
+        float sum[C] = {0};
+        for (int t = 0; t < ntaps; ++t) {
+            auto s = src + int64_t(index[t]) * C;
+            for (int c = 0; c < C; ++c) {
+                sum[c] += float(s[c]) * weight[t];
+            }
+        }
+        for (int c = 0; c < C; ++c) {
+            out[x * C + c] = sum[c];
+        }
+    }
+}
+
+// row functions of both passes, the SIMD backend has its own
+struct ScalarResizeOps {
+    template <typename T, int C>
+    static void horizontal(float *out, const T *src, const ResizeCoeffs &xc,
+                           int64_t dwidth) {
+        resize_horizontal<T, C>(out, src, xc, dwidth);
+    }
+
+    // out[i] = sum(w[t] * rows[t][i])
+    static void vertical(float *out, const float *const *rows, const float *w,
+                         int ntaps, int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            out[i] = rows[0][i] * w[0];
+        }
+        for (int t = 1; t < ntaps; ++t) {
+            auto row = rows[t];
+            auto wt = w[t];
+            for (int64_t i = 0; i < n; ++i) {
+                out[i] += row[i] * wt;
+            }
+        }
+    }
+
+    template <typename T>
+    static void store(T *dst, const float *src, int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            dst[i] = saturate_cast<T>(std::is_integral<T>::value
+                                          ? std::nearbyint(src[i])
+                                          : src[i]);
+        }
+    }
+};
+
+// an image plane of (height, width, channels), strides in elements
+template <typename T> struct ResizePlane {
+    const T *src;
+    T *dst;
+    int64_t src_stride;
+    int64_t dst_stride;
+};
+
+// horizontally resized source rows of the planes one thread works on. The
+// taps of an output row are consecutive source rows (clamped), so source
+// row r can live in slot r % ntaps and neighbouring output rows reuse it
+template <typename T, int C, typename Ops> class ResizeRowCache {
+  public:
+    ResizeRowCache(const ResizeCoeffs &xc, const ResizeCoeffs &yc,
+                   int64_t dwidth)
+        : xc_(xc), yc_(yc), dwidth_(dwidth),
+          ring_(yc.ntaps * dwidth * C), slot_plane_(yc.ntaps, -1),
+          slot_row_(yc.ntaps, -1), rows_(yc.ntaps) {}
+
+    // taps of output row y, plane is any id unique to the source plane
+    const float *const *rows(const T *src, int64_t src_stride, int64_t plane,
+                             int64_t y) {
+        auto ntaps = yc_.ntaps;
+        for (int t = 0; t < ntaps; ++t) {
+            auto sy = yc_.index[y * ntaps + t];
+            auto slot = sy % ntaps;
+            auto row = ring_.data() + slot * dwidth_ * C;
+            if (slot_plane_[slot] != plane || slot_row_[slot] != sy) {
+                Ops::template horizontal<T, C>(row, src + sy * src_stride,
+                                               xc_, dwidth_);
+                slot_plane_[slot] = plane;
+                slot_row_[slot] = sy;
+            }
+            rows_[t] = row;
+        }
+        return rows_.data();
+    }
+
+    const float *weights(int64_t y) const {
+        return &yc_.weight[y * yc_.ntaps];
+    }
+
+    int ntaps() const { return yc_.ntaps; }
+
+  private:
+    const ResizeCoeffs &xc_;
+    const ResizeCoeffs &yc_;
+    int64_t dwidth_;
+    std::vector<float> ring_;
+    std::vector<int64_t> slot_plane_;
+    std::vector<int64_t> slot_row_;
+    std::vector<const float *> rows_;
+};
+
+template <typename T, int C, typename Ops>
+void separable_resize(const std::vector<ResizePlane<T>> &planes,
+                      int64_t swidth, int64_t sheight, int64_t dwidth,
+                      int64_t dheight, ImageFilterMode mode) {
+    auto xc = resize_coeffs(swidth, dwidth, mode);
+    auto yc = resize_coeffs(sheight, dheight, mode);
+    auto drow = dwidth * C;
+
+    parallel_for(0, planes.size() * dheight, 16, [&](int64_t begin,
+                                                     int64_t end) {
+        ResizeRowCache<T, C, Ops> cache(xc, yc, dwidth);
+        std::vector<float> acc(drow);
+        for (int64_t r = begin; r < end; ++r) {
+            auto p = r / dheight;
+            auto y = r % dheight;
+            auto &plane = planes[p];
+            auto rows = cache.rows(plane.src, plane.src_stride, p, y);
+            Ops::vertical(acc.data(), rows, cache.weights(y), cache.ntaps(),
+                          drow);
+            Ops::store(plane.dst + y * plane.dst_stride, acc.data(), drow);
+        }
+    });
+}
+
+template <typename T, typename Ops>
+void img_resize_separable(Tensor &dst, const Tensor &src, ImageFilterMode mode,
+                          ChannelFormat cformat) {
+    // NCHW: one plane per channel
+    auto hdim = cformat == kNCHW ? 2 : 1;
+    auto channels = cformat == kNCHW ? 1 : src.size(-1);
+    auto nplanes = cformat == kNCHW ? src.size(1) : 1;
+    std::vector<ResizePlane<T>> planes;
+    for (int64_t n = 0; n < src.size(0); ++n) {
+        for (int64_t c = 0; c < nplanes; ++c) {
+            auto s = cformat == kNCHW ? src.select(0, n).select(0, c)
+                                      : src.select(0, n);
+            auto d = cformat == kNCHW ? dst.select(0, n).select(0, c)
+                                      : dst.select(0, n);
+            planes.push_back({s.data<T>(), d.data<T>(), src.stride(hdim),
+                              dst.stride(hdim)});
+        }
+    }
+
+    auto swidth = src.size(hdim + 1), sheight = src.size(hdim);
+    auto dwidth = dst.size(hdim + 1), dheight = dst.size(hdim);
+    switch (channels) {
+    case 1:
+        separable_resize<T, 1, Ops>(planes, swidth, sheight, dwidth, dheight,
+                                    mode);
+        break;
+    case 2:
+        separable_resize<T, 2, Ops>(planes, swidth, sheight, dwidth, dheight,
+                                    mode);
+        break;
+    case 3:
+        separable_resize<T, 3, Ops>(planes, swidth, sheight, dwidth, dheight,
+                                    mode);
+        break;
+    default:
+        separable_resize<T, 4, Ops>(planes, swidth, sheight, dwidth, dheight,
+                                    mode);
+        break;
+    }
+}
+
+// resize of uint8, uint16 or float32 images with up to 4 channels (NHWC)
+// and any filter but Nearest, false if the tensors are not supported
+template <typename Ops>
+bool img_resize_separable(Tensor &dst, const Tensor &src,
+                          ImageFilterMode mode, ChannelFormat cformat) {
+    auto channels = cformat == kNCHW ? 1 : src.size(-1);
+    if (mode == ImageFilterMode::Nearest || channels > 4) {
+        return false;
+    }
+    switch (src.scalar_type()) {
+    case kUInt8:
+        img_resize_separable<uint8_t, Ops>(dst, src, mode, cformat);
+        return true;
+    case kUInt16:
+        img_resize_separable<uint16_t, Ops>(dst, src, mode, cformat);
+        return true;
+    case kFloat32:
+        img_resize_separable<float, Ops>(dst, src, mode, cformat);
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace cpu
+} // namespace kernel
+} // namespace hmp
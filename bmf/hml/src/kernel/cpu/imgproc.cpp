@@ -16,6 +16,8 @@
 #include <kernel/imgproc.h>
 #include <kernel/kernel_utils.h>
 #include <kernel/cpu/kernel_utils.h>
+#include <kernel/cpu/image_resize.h>
+#include <kernel/cpu/image_preprocess.h>
 #include <kernel/image_color_cvt.h>
 #include <kernel/image_filter.h>
 
@@ -200,6 +202,17 @@ TensorList &yuv_to_yuv_cpu(TensorList &dst, const TensorList &src,
 
 Tensor &img_resize_cpu(Tensor &dst, const Tensor &src, ImageFilterMode mode,
                        ChannelFormat cformat) {
+    // no per pixel Filter for these
+    if (mode == ImageFilterMode::Area || mode == ImageFilterMode::Lanczos) {
+        HMP_REQUIRE(
+            cpu::img_resize_separable<cpu::ScalarResizeOps>(dst, src, mode,
+                                                            cformat),
+            "img_resize_cpu: {} expects uint8, uint16 or float32 images "
+            "with up to 4 channels",
+            mode);
+        return dst;
+    }
+
     HMP_DISPATCH_IMAGE_TYPES_AND_HALF(
         src.scalar_type(), "img_resize_cpu", [&]() {
             auto channel = cformat == kNCHW ? 1 : src.size(-1);
@@ -248,6 +261,14 @@ TensorList &yuv_resize_cpu(TensorList &dst, const TensorList &src,
     return dst;
 }
 
+Tensor &yuv_preprocess_cpu(Tensor &dst, const TensorList &src,
+                           PPixelFormat format, const Tensor &mean,
+                           const Tensor &std, ImageFilterMode mode,
+                           PixelFormat rgbformat) {
+    return cpu::yuv_preprocess<cpu::ScalarResizeOps>(dst, src, format, mean,
+                                                     std, mode, rgbformat);
+}
+
 Tensor &img_mirror_cpu(Tensor &dst, const Tensor &src, ImageAxis axis,
                        ChannelFormat cformat) {
     HMP_DISPATCH_IMAGE_TYPES_AND_HALF(
@@ -398,6 +419,7 @@ HMP_DEVICE_DISPATCH(kCPU, yuv_to_yuv_stub, &yuv_to_yuv_cpu)
 HMP_DEVICE_DISPATCH(kCPU, yuv_resize_stub, &yuv_resize_cpu)
 HMP_DEVICE_DISPATCH(kCPU, yuv_rotate_stub, &yuv_rotate_cpu)
 HMP_DEVICE_DISPATCH(kCPU, yuv_mirror_stub, &yuv_mirror_cpu)
+HMP_DEVICE_DISPATCH(kCPU, yuv_preprocess_stub, &yuv_preprocess_cpu)
 HMP_DEVICE_DISPATCH(kCPU, img_resize_stub, &img_resize_cpu)
 HMP_DEVICE_DISPATCH(kCPU, img_rotate_stub, &img_rotate_cpu)
 HMP_DEVICE_DISPATCH(kCPU, img_mirror_stub, &img_mirror_cpu)
@@ -0,0 +1,412 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// CPUBackend::SIMD kernels, AVX2 on x86_64 (selected at runtime, no extra
+// compile flags needed) and NEON on aarch64
+
+#include <kernel/imgproc.h>
+#include <kernel/kernel_utils.h>
+#include <kernel/parallel.h>
+#include <kernel/cpu/image_resize.h>
+#include <kernel/cpu/image_preprocess.h>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HMP_SIMD_AVX2
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define HMP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HMP_TARGET_AVX2
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HMP_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(HMP_SIMD_AVX2) || defined(HMP_SIMD_NEON)
+
+namespace hmp {
+namespace kernel {
+namespace {
+
+// reverse the elements of a row, elements are Elem bytes
+template <int Elem>
+#ifdef HMP_SIMD_AVX2
+HMP_TARGET_AVX2
+#endif
+void mirror_row(uint8_t *dst, const uint8_t *src, int64_t bytes) {
+    int64_t i = 0;
+#ifdef HMP_SIMD_AVX2
+    // reverse the elements in each 128 bit lane, then swap the lanes
+    alignas(32) uint8_t index[32];
+    for (int j = 0; j < 32; ++j) {
+        auto k = j % 16;
+        index[j] = (16 / Elem - 1 - k / Elem) * Elem + k % Elem;
+    }
+    auto mask = _mm256_load_si256(reinterpret_cast<const __m256i *>(index));
+    for (; i + 32 <= bytes; i += 32) {
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        v = _mm256_shuffle_epi8(v, mask);
+        v = _mm256_permute2x128_si256(v, v, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + bytes - i - 32),
+                            v);
+    }
+#else
+    for (; i + 16 <= bytes; i += 16) {
+        auto v = vld1q_u8(src + i);
+        if (Elem == 1) {
+            v = vrev64q_u8(v);
+        } else if (Elem == 2) {
+            v = vreinterpretq_u8_u16(vrev64q_u16(vreinterpretq_u16_u8(v)));
+        } else {
+            v = vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(v)));
+        }
+        vst1q_u8(dst + bytes - i - 16, vextq_u8(v, v, 8));
+    }
+#endif
+    for (; i < bytes; i += Elem) {
+        memcpy(dst + bytes - i - Elem, src + i, Elem);
+    }
+}
+
+struct Plane {
+    uint8_t *dst;
+    const uint8_t *src;
+    int64_t dst_stride; // bytes
+    int64_t src_stride;
+};
+
+// mirror planes of height rows with width bytes per row, false if the row
+// elements are not 1, 2 or 4 bytes
+bool mirror_planes(const std::vector<Plane> &planes, int64_t height,
+                   int64_t width, int64_t elem, ImageAxis axis) {
+    auto hmirror = static_cast<uint8_t>(axis) &
+                   static_cast<uint8_t>(ImageAxis::Horizontal);
+    auto vmirror = static_cast<uint8_t>(axis) &
+                   static_cast<uint8_t>(ImageAxis::Vertical);
+    void (*row_func)(uint8_t *, const uint8_t *, int64_t) = nullptr;
+    if (hmirror) {
+        switch (elem) {
+        case 1:
+            row_func = &mirror_row<1>;
+            break;
+        case 2:
+            row_func = &mirror_row<2>;
+            break;
+        case 4:
+            row_func = &mirror_row<4>;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    int64_t rows = planes.size() * height;
+    parallel_for(0, rows, 64, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            auto &p = planes[r / height];
+            auto y = r % height;
+            auto sy = vmirror ? height - 1 - y : y;
+            auto d = p.dst + y * p.dst_stride;
+            auto s = p.src + sy * p.src_stride;
+            if (row_func) {
+                row_func(d, s, width);
+            } else {
+                memcpy(d, s, width);
+            }
+        }
+    });
+    return true;
+}
+
+Tensor &img_mirror_simd(Tensor &dst, const Tensor &src, ImageAxis axis,
+                        ChannelFormat cformat) {
+    auto itemsize = src.itemsize();
+    // NCHW: one plane per channel, NHWC: channels are part of a row element
+    auto elem = cformat == kNCHW ? itemsize : itemsize * src.size(-1);
+    auto height = cformat == kNCHW ? src.size(2) : src.size(1);
+    auto width = (cformat == kNCHW ? src.size(3) : src.size(2)) * elem;
+    auto hdim = cformat == kNCHW ? 2 : 1;
+
+    std::vector<Plane> planes;
+    if (src.unsafe_data() != dst.unsafe_data()) {
+        auto nplanes = cformat == kNCHW ? src.size(1) : 1;
+        for (int64_t n = 0; n < src.size(0); ++n) {
+            for (int64_t c = 0; c < nplanes; ++c) {
+                auto s = cformat == kNCHW ? src.select(0, n).select(0, c)
+                                          : src.select(0, n);
+                auto d = cformat == kNCHW ? dst.select(0, n).select(0, c)
+                                          : dst.select(0, n);
+                planes.push_back({static_cast<uint8_t *>(d.unsafe_data()),
+                                  static_cast<const uint8_t *>(s.unsafe_data()),
+                                  dst.stride(hdim) * itemsize,
+                                  src.stride(hdim) * itemsize});
+            }
+        }
+    }
+
+    if (planes.empty() || !mirror_planes(planes, height, width, elem, axis)) {
+        return img_mirror_stub.fallback(CPUBackend::SIMD, dst, src, axis,
+                                        cformat);
+    }
+    return dst;
+}
+
+TensorList &yuv_mirror_simd(TensorList &dst, const TensorList &src,
+                            PPixelFormat format, ImageAxis axis) {
+    for (size_t i = 0; i < src.size(); ++i) {
+        img_mirror_simd(dst[i], src[i], axis, ChannelFormat::NHWC);
+    }
+
+    return dst;
+}
+
+// passes and store of the separable resize (cpu/image_resize.h)
+#ifdef HMP_SIMD_AVX2
+// integer pixels are gathered as 32 bit words and masked
+HMP_TARGET_AVX2
+__m256 gather_pixels(const uint8_t *src, __m256i index) {
+    auto v = _mm256_i32gather_epi32(reinterpret_cast<const int *>(src), index,
+                                    1);
+    return _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xFF)));
+}
+
+HMP_TARGET_AVX2
+__m256 gather_pixels(const uint16_t *src, __m256i index) {
+    auto v = _mm256_i32gather_epi32(reinterpret_cast<const int *>(src), index,
+                                    2);
+    return _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xFFFF)));
+}
+
+HMP_TARGET_AVX2
+__m256 gather_pixels(const float *src, __m256i index) {
+    return _mm256_i32gather_ps(src, index, 4);
+}
+
+// horizontal pass of single channel rows, 8 outputs with one gather per tap.
+// The word loads must stay in the row, so the last outputs whose taps reach
+// the end of it are done one by one
+template <typename T>
+HMP_TARGET_AVX2 void resize_horizontal(float *out, const T *src,
+                                       const cpu::ResizeCoeffs &xc,
+                                       int64_t dwidth) {
+    auto ntaps = xc.ntaps;
+    const int64_t pad = 4 / sizeof(T) - 1;
+    auto end = dwidth;
+    while (end > 0 && xc.index[end * ntaps - 1] + pad >= xc.ssize) {
+        --end;
+    }
+
+    int64_t x = 0;
+    for (; x + 8 <= end; x += 8) {
+        auto acc = _mm256_setzero_ps();
+        for (int t = 0; t < ntaps; ++t) {
+            auto tap = t * dwidth + x;
+            auto index = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(&xc.tap_index[tap]));
+            auto w = _mm256_loadu_ps(&xc.tap_weight[tap]);
+            acc = _mm256_add_ps(acc,
+                                _mm256_mul_ps(gather_pixels(src, index), w));
+        }
+        _mm256_storeu_ps(out + x, acc);
+    }
+    for (; x < dwidth; ++x) {
+        auto index = &xc.index[x * ntaps];
+        auto weight = &xc.weight[x * ntaps];
+        float sum = 0;
+        for (int t = 0; t < ntaps; ++t) {
+            sum += float(src[index[t]]) * weight[t];
+        }
+        out[x] = sum;
+    }
+}
+
+HMP_TARGET_AVX2
+void resize_vertical(float *out, const float *const *rows, const float *w,
+                     int ntaps, int64_t n) {
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto w0 = _mm256_set1_ps(w[0]);
+        auto a0 = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), w0);
+        auto a1 = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i + 8), w0);
+        for (int t = 1; t < ntaps; ++t) {
+            auto wt = _mm256_set1_ps(w[t]);
+            a0 = _mm256_add_ps(
+                a0, _mm256_mul_ps(_mm256_loadu_ps(rows[t] + i), wt));
+            a1 = _mm256_add_ps(
+                a1, _mm256_mul_ps(_mm256_loadu_ps(rows[t] + i + 8), wt));
+        }
+        _mm256_storeu_ps(out + i, a0);
+        _mm256_storeu_ps(out + i + 8, a1);
+    }
+    for (; i < n; ++i) {
+        auto v = rows[0][i] * w[0];
+        for (int t = 1; t < ntaps; ++t) {
+            v += rows[t][i] * w[t];
+        }
+        out[i] = v;
+    }
+}
+
+// rounds to nearest even like the scalar tail
+HMP_TARGET_AVX2
+void resize_store(uint8_t *dst, const float *src, int64_t n) {
+    int64_t i = 0;
+    const auto perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= n; i += 32) {
+        auto a = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i));
+        auto b = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i + 8));
+        auto c = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i + 16));
+        auto d = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i + 24));
+        // packs work per 128 bit lane, the permute restores the order
+        auto v = _mm256_packus_epi16(_mm256_packs_epi32(a, b),
+                                     _mm256_packs_epi32(c, d));
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+    }
+    for (; i < n; ++i) {
+        dst[i] = saturate_cast<uint8_t>(std::nearbyint(src[i]));
+    }
+}
+
+HMP_TARGET_AVX2
+void resize_store(uint16_t *dst, const float *src, int64_t n) {
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto a = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i));
+        auto b = _mm256_cvtps_epi32(_mm256_loadu_ps(src + i + 8));
+        auto v = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+    }
+    for (; i < n; ++i) {
+        dst[i] = saturate_cast<uint16_t>(std::nearbyint(src[i]));
+    }
+}
+#else
+void resize_vertical(float *out, const float *const *rows, const float *w,
+                     int ntaps, int64_t n) {
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto a0 = vmulq_n_f32(vld1q_f32(rows[0] + i), w[0]);
+        auto a1 = vmulq_n_f32(vld1q_f32(rows[0] + i + 4), w[0]);
+        for (int t = 1; t < ntaps; ++t) {
+            a0 = vmlaq_n_f32(a0, vld1q_f32(rows[t] + i), w[t]);
+            a1 = vmlaq_n_f32(a1, vld1q_f32(rows[t] + i + 4), w[t]);
+        }
+        vst1q_f32(out + i, a0);
+        vst1q_f32(out + i + 4, a1);
+    }
+    for (; i < n; ++i) {
+        auto v = rows[0][i] * w[0];
+        for (int t = 1; t < ntaps; ++t) {
+            v += rows[t][i] * w[t];
+        }
+        out[i] = v;
+    }
+}
+
+void resize_store(uint8_t *dst, const float *src, int64_t n) {
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto a = vqmovun_s32(vcvtnq_s32_f32(vld1q_f32(src + i)));
+        auto b = vqmovun_s32(vcvtnq_s32_f32(vld1q_f32(src + i + 4)));
+        vst1_u8(dst + i, vqmovn_u16(vcombine_u16(a, b)));
+    }
+    for (; i < n; ++i) {
+        dst[i] = saturate_cast<uint8_t>(std::nearbyint(src[i]));
+    }
+}
+
+void resize_store(uint16_t *dst, const float *src, int64_t n) {
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto a = vqmovun_s32(vcvtnq_s32_f32(vld1q_f32(src + i)));
+        auto b = vqmovun_s32(vcvtnq_s32_f32(vld1q_f32(src + i + 4)));
+        vst1q_u16(dst + i, vcombine_u16(a, b));
+    }
+    for (; i < n; ++i) {
+        dst[i] = saturate_cast<uint16_t>(std::nearbyint(src[i]));
+    }
+}
+#endif
+
+void resize_store(float *dst, const float *src, int64_t n) {
+    memcpy(dst, src, n * sizeof(float));
+}
+
+// NEON has no gather, its horizontal pass is the scalar one
+struct SimdResizeOps {
+    template <typename T, int C>
+    static void horizontal(float *out, const T *src,
+                           const cpu::ResizeCoeffs &xc, int64_t dwidth) {
+#ifdef HMP_SIMD_AVX2
+        if (C == 1) {
+            resize_horizontal(out, src, xc, dwidth);
+            return;
+        }
+#endif
+        cpu::resize_horizontal<T, C>(out, src, xc, dwidth);
+    }
+
+    static void vertical(float *out, const float *const *rows, const float *w,
+                         int ntaps, int64_t n) {
+        resize_vertical(out, rows, w, ntaps, n);
+    }
+
+    template <typename T>
+    static void store(T *dst, const float *src, int64_t n) {
+        resize_store(dst, src, n);
+    }
+};
+
+Tensor &img_resize_simd(Tensor &dst, const Tensor &src, ImageFilterMode mode,
+                        ChannelFormat cformat) {
+    if (!cpu::img_resize_separable<SimdResizeOps>(dst, src, mode, cformat)) {
+        return img_resize_stub.fallback(CPUBackend::SIMD, dst, src, mode,
+                                        cformat);
+    }
+    return dst;
+}
+
+TensorList &yuv_resize_simd(TensorList &dst, const TensorList &src,
+                            PPixelFormat format, ImageFilterMode mode) {
+    for (size_t i = 0; i < src.size(); ++i) {
+        img_resize_simd(dst[i], src[i], mode, ChannelFormat::NHWC);
+    }
+
+    return dst;
+}
+
+Tensor &yuv_preprocess_simd(Tensor &dst, const TensorList &src,
+                            PPixelFormat format, const Tensor &mean,
+                            const Tensor &std, ImageFilterMode mode,
+                            PixelFormat rgbformat) {
+    return cpu::yuv_preprocess<SimdResizeOps>(dst, src, format, mean, std,
+                                              mode, rgbformat);
+}
+
+HMP_CPU_BACKEND_DISPATCH(SIMD, img_mirror_stub, &img_mirror_simd)
+HMP_CPU_BACKEND_DISPATCH(SIMD, yuv_mirror_stub, &yuv_mirror_simd)
+HMP_CPU_BACKEND_DISPATCH(SIMD, img_resize_stub, &img_resize_simd)
+HMP_CPU_BACKEND_DISPATCH(SIMD, yuv_resize_stub, &yuv_resize_simd)
+HMP_CPU_BACKEND_DISPATCH(SIMD, yuv_preprocess_stub, &yuv_preprocess_simd)
+
+} // namespace
+} // namespace kernel
+} // namespace hmp
+
+#endif
@@ -17,6 +17,7 @@
 
 #include <kernel/kernel_utils.h>
 #include <kernel/parallel.h>
+#include <numeric>
 
 namespace hmp {
 namespace kernel {
@@ -31,6 +32,126 @@ inline void invoke_elementwise_kernel(int64_t N, const F &f) {
     });
 }
 
+// elements per thread at least, smaller tensors run in fewer threads
+const int64_t kElementwiseGrain = 32768;
+
+// strides of NArgs operands sharing one shape
+template <int NArgs> struct ElementwiseLayout {
+    SizeArray sizes;
+    SizeArray strides[NArgs];
+
+    // merges size 1 dims and dims which are contiguous with the next one in
+    // every operand, so a contiguous tensor is 1D and a crop with padded
+    // rows is (rows, row elements)
+    void coalesce() {
+        SizeArray csizes;
+        SizeArray cstrides[NArgs];
+        for (size_t d = 0; d < sizes.size(); ++d) {
+            if (sizes[d] == 1) {
+                continue;
+            }
+            bool merge = !csizes.empty();
+            for (int a = 0; a < NArgs && merge; ++a) {
+                merge = cstrides[a].back() == strides[a][d] * sizes[d];
+            }
+            if (merge) {
+                csizes.back() *= sizes[d];
+                for (int a = 0; a < NArgs; ++a) {
+                    cstrides[a].back() = strides[a][d];
+                }
+            } else {
+                csizes.push_back(sizes[d]);
+                for (int a = 0; a < NArgs; ++a) {
+                    cstrides[a].push_back(strides[a][d]);
+                }
+            }
+        }
+        if (csizes.empty()) { // a single element
+            csizes.push_back(1);
+            for (int a = 0; a < NArgs; ++a) {
+                cstrides[a].push_back(1);
+            }
+        }
+        sizes = csizes;
+        for (int a = 0; a < NArgs; ++a) {
+            strides[a] = cstrides[a];
+        }
+    }
+};
+
+// Runs an elementwise op over the operands of layout, offsets are in
+// elements. row(offsets, n) gets runs of n elements which are contiguous in
+// every operand, the whole tensor or each innermost row after coalescing.
+// Otherwise elem(offsets) is called per element.
+template <int NArgs, typename RowFunc, typename ElemFunc>
+void elementwise_for(ElementwiseLayout<NArgs> layout, const RowFunc &row,
+                     const ElemFunc &elem) {
+    using offset_type = Vector<int64_t, NArgs>;
+    layout.coalesce();
+    auto ndim = int64_t(layout.sizes.size());
+    auto width = layout.sizes.back();
+    bool inner_contiguous = true;
+    const int64_t *strides[NArgs];
+    for (int a = 0; a < NArgs; ++a) {
+        inner_contiguous &= layout.strides[a].back() == 1;
+        strides[a] = layout.strides[a].data();
+    }
+
+    if (inner_contiguous && ndim == 1) {
+        parallel_for(0, width, kElementwiseGrain,
+                     [&](int64_t begin, int64_t end) {
+                         offset_type offs;
+                         for (int a = 0; a < NArgs; ++a) {
+                             offs[a] = begin;
+                         }
+                         row(offs, end - begin);
+                     });
+    } else if (inner_contiguous) {
+        // offsets of the rows only
+        auto offsetCalc = OffsetCalculator<NArgs, int64_t>(
+            ndim - 1, layout.sizes.data(), strides);
+        auto rows = std::accumulate(layout.sizes.begin(),
+                                    layout.sizes.end() - 1, int64_t(1),
+                                    std::multiplies<int64_t>());
+        parallel_for(0, rows, divup(kElementwiseGrain, width),
+                     [&](int64_t begin, int64_t end) {
+                         for (int64_t r = begin; r < end; ++r) {
+                             row(offsetCalc.get(r), width);
+                         }
+                     });
+    } else {
+        auto offsetCalc = OffsetCalculator<NArgs, int64_t>(
+            ndim, layout.sizes.data(), strides);
+        auto N = std::accumulate(layout.sizes.begin(), layout.sizes.end(),
+                                 int64_t(1), std::multiplies<int64_t>());
+        parallel_for(0, N, kElementwiseGrain, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                elem(offsetCalc.get(i));
+            }
+        });
+    }
+}
+
+// Contiguous loops. The pointers are arguments rather than captures of
+// the kernel lambda, so the compiler knows a store can't change them and
+// vectorizes (and unrolls) the loop for every dtype. Through captures a
+// uint8 store may alias the capture and each element reloads them, which
+// is also why ops capture their scalars by value.
+template <typename OT, typename IT, typename Func>
+void uop_loop(OT *out, const IT *in, int64_t n, const Func &f) {
+    for (int64_t i = 0; i < n; ++i) {
+        out[i] = f(in[i]);
+    }
+}
+
+template <typename OT, typename IT0, typename IT1, typename Func>
+void bop_loop(OT *out, const IT0 *in0, const IT1 *in1, int64_t n,
+              const Func &f) {
+    for (int64_t i = 0; i < n; ++i) {
+        out[i] = f(in0[i], in1[i]);
+    }
+}
+
 template <typename OT, typename Func>
 void gen_kernel(Tensor &out, const Func &f) {
     auto optr = out.data<OT>();
@@ -57,22 +178,16 @@ void uop_kernel(Tensor &out, const Tensor &in, const Func &f) {
 
     auto optr = out.data<OT>();
     auto iptr = in.data<IT>();
-    auto N = out.nitems();
-
-    if (in.is_contiguous() && out.is_contiguous()) {
-        invoke_elementwise_kernel(
-            N, [&](int64_t idx) { optr[idx] = f(iptr[idx]); });
-    } else {
-        const int64_t *strides[] = {out.strides().data(), in.strides().data()};
-        const int64_t *sizes = out.shape().data();
-        auto offsetCalc =
-            OffsetCalculator<2, int64_t>(out.dim(), sizes, strides);
-
-        invoke_elementwise_kernel(N, [&](int64_t idx) {
-            auto offs = offsetCalc.get(idx);
+    ElementwiseLayout<2> layout{out.shape(), {out.strides(), in.strides()}};
+
+    elementwise_for(
+        layout,
+        [&](const Vector<int64_t, 2> &offs, int64_t n) {
+            uop_loop(optr + offs[0], iptr + offs[1], n, f);
+        },
+        [&](const Vector<int64_t, 2> &offs) {
             optr[offs[0]] = f(iptr[offs[1]]);
         });
-    }
 }
 
 template <typename OT, typename IT0, typename IT1, typename Func>
@@ -83,23 +198,17 @@ void bop_kernel(Tensor &out, const Tensor &in0, const Tensor &in1,
     auto optr = out.data<OT>();
     auto iptr0 = in0.data<IT0>();
     auto iptr1 = in1.data<IT1>();
-    auto N = out.nitems();
-
-    if (out.is_contiguous() && in0.is_contiguous() && in1.is_contiguous()) {
-        invoke_elementwise_kernel(
-            N, [&](int64_t idx) { optr[idx] = f(iptr0[idx], iptr1[idx]); });
-    } else {
-        const int64_t *strides[] = {out.strides().data(), in0.strides().data(),
-                                    in1.strides().data()};
-        const int64_t *sizes = out.shape().data();
-        auto offsetCalc =
-            OffsetCalculator<3, int64_t>(out.dim(), sizes, strides);
-
-        invoke_elementwise_kernel(N, [&](int64_t idx) {
-            auto offs = offsetCalc.get(idx);
+    ElementwiseLayout<3> layout{out.shape(),
+                                {out.strides(), in0.strides(), in1.strides()}};
+
+    elementwise_for(
+        layout,
+        [&](const Vector<int64_t, 3> &offs, int64_t n) {
+            bop_loop(optr + offs[0], iptr0 + offs[1], iptr1 + offs[2], n, f);
+        },
+        [&](const Vector<int64_t, 3> &offs) {
             optr[offs[0]] = f(iptr0[offs[1]], iptr1[offs[2]]);
         });
-    }
 }
 
 template <typename Func, typename Index = int64_t>
@@ -74,9 +74,10 @@ Tensor &clip_cpu(Tensor &out, const Tensor &in, const Scalar &min,
                     "clip_cpu: expect min <= max, got min={}, max={}", min_v,
                     max_v);
 
-        cpu::uop_kernel<scalar_t, scalar_t>(out, in, [&](scalar_t v) {
-            return v < min_v ? min_v : (v > max_v ? max_v : v);
-        });
+        cpu::uop_kernel<scalar_t, scalar_t>(
+            out, in, [min_v, max_v](scalar_t v) {
+                return v < min_v ? min_v : (v > max_v ? max_v : v);
+            });
     });
     return out;
 }
@@ -40,6 +40,10 @@ inline int to_cv_filter_mode(ImageFilterMode mode) {
         return cv::INTER_LINEAR;
     case kBicubic:
         return cv::INTER_CUBIC;
+    case kArea:
+        return cv::INTER_AREA;
+    case kLanczos:
+        return cv::INTER_LANCZOS4;
     default:
         HMP_REQUIRE(false, "{} is not supported by OpenCV", mode);
     }
@@ -14,5 +14,130 @@
  * limitations under the License.
  */
 #include <kernel/dispatch_stub.h>
+#include <hmp/core/logging.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
-namespace hmp {} // namespace hmp
\ No newline at end of file
+namespace hmp {
+
+namespace {
+
+bool cpu_has_avx2() {
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    bool avx2 = info[1] & (1 << 5);
+    __cpuid(info, 1);
+    bool osxsave = info[2] & (1 << 27);
+    // the OS saves the ymm registers
+    return avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+bool detect_backend(CPUBackend backend) {
+    switch (backend) {
+    case CPUBackend::Generic:
+        return true;
+    case CPUBackend::LibYUV:
+#ifdef HMP_ENABLE_LIBYUV
+        return true;
+#else
+        return false;
+#endif
+    case CPUBackend::SIMD:
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return true;
+#else
+        return cpu_has_avx2();
+#endif
+    default:
+        return false;
+    }
+}
+
+struct CPUBackendState {
+    bool available[static_cast<int>(CPUBackend::NumCPUBackends)];
+    std::atomic<int> selected;
+
+    CPUBackendState() {
+        int highest = 0;
+        for (int i = 0; i < static_cast<int>(CPUBackend::NumCPUBackends);
+             ++i) {
+            available[i] = detect_backend(static_cast<CPUBackend>(i));
+            if (available[i]) {
+                highest = i;
+            }
+        }
+        selected = highest;
+
+        if (auto env = getenv("HMP_CPU_BACKEND")) {
+            for (int i = 0; i < static_cast<int>(CPUBackend::NumCPUBackends);
+                 ++i) {
+                if (strcmp(env, backend_name(static_cast<CPUBackend>(i))) ==
+                    0) {
+                    selected = i;
+                    return;
+                }
+            }
+            HMP_WRN("Unknown HMP_CPU_BACKEND={}, expect generic, libyuv or "
+                    "simd",
+                    env);
+        }
+    }
+
+    static const char *backend_name(CPUBackend backend) {
+        switch (backend) {
+        case CPUBackend::Generic:
+            return "generic";
+        case CPUBackend::LibYUV:
+            return "libyuv";
+        case CPUBackend::SIMD:
+            return "simd";
+        default:
+            return "unknown";
+        }
+    }
+};
+
+CPUBackendState &cpu_backend_state() {
+    static CPUBackendState state;
+    return state;
+}
+
+} // namespace
+
+std::string stringfy(const CPUBackend &backend) {
+    return CPUBackendState::backend_name(backend);
+}
+
+bool cpu_backend_available(CPUBackend backend) {
+    auto idx = static_cast<int>(backend);
+    return idx >= 0 && idx < static_cast<int>(CPUBackend::NumCPUBackends) &&
+           cpu_backend_state().available[idx];
+}
+
+CPUBackend cpu_backend() {
+    return static_cast<CPUBackend>(
+        cpu_backend_state().selected.load(std::memory_order_relaxed));
+}
+
+void set_cpu_backend(CPUBackend backend) {
+    HMP_REQUIRE(backend >= CPUBackend::Generic &&
+                    backend < CPUBackend::NumCPUBackends,
+                "set_cpu_backend: invalid backend {}",
+                static_cast<int>(backend));
+    cpu_backend_state().selected = static_cast<int>(backend);
+}
+
+} // namespace hmp
@@ -21,6 +21,10 @@ namespace hmp {
 
 template <typename F> class DispatchStub;
 
+// Each stub has one function per device type, and for kCPU one per
+// CPUBackend. A kCPU call goes to the highest ranked backend which is
+// registered, available on this CPU and not above cpu_backend(). A backend
+// kernel hands the cases it does not implement to fallback().
 template <typename Ret, typename... Args> class DispatchStub<Ret (*)(Args...)> {
   public:
     using FuncType = Ret (*)(Args...);
@@ -32,7 +36,9 @@ template <typename Ret, typename... Args> class DispatchStub<Ret (*)(Args...)> {
     DispatchStub(const char *name) : name_(name) {}
 
     Ret operator()(DeviceType device_type, Args... args) {
-        auto func = funcs_[static_cast<int>(device_type)];
+        auto func = device_type == kCPU
+                        ? cpu_func(static_cast<int>(cpu_backend()) + 1)
+                        : funcs_[static_cast<int>(device_type)];
         HMP_REQUIRE(func != nullptr,
                     "Function {} not implemented in device type {}", name_,
                     device_type);
@@ -40,16 +46,48 @@ template <typename Ret, typename... Args> class DispatchStub<Ret (*)(Args...)> {
         return (*func)(std::forward<Args>(args)...);
     }
 
+    // call the kCPU function ranked below backend
+    Ret fallback(CPUBackend backend, Args... args) {
+        auto func = cpu_func(static_cast<int>(backend));
+        HMP_REQUIRE(func != nullptr,
+                    "Function {} has no kCPU fallback below backend {}", name_,
+                    backend);
+
+        return (*func)(std::forward<Args>(args)...);
+    }
+
     template <typename D, typename F>
     friend void setDispatch(D &d, const DeviceType &device, F func);
+    template <typename D, typename F>
+    friend void setCPUDispatch(D &d, const CPUBackend &backend, F func);
 
   private:
     void set(DeviceType device, FuncType func) {
-        funcs_[static_cast<int>(device)] = func;
+        if (device == kCPU) {
+            cpu_funcs_[static_cast<int>(CPUBackend::Generic)] = func;
+        } else {
+            funcs_[static_cast<int>(device)] = func;
+        }
+    }
+
+    void set(CPUBackend backend, FuncType func) {
+        cpu_funcs_[static_cast<int>(backend)] = func;
+    }
+
+    // highest available backend ranked below end
+    FuncType cpu_func(int end) const {
+        for (int i = end - 1; i >= 0; --i) {
+            if (cpu_funcs_[i] &&
+                cpu_backend_available(static_cast<CPUBackend>(i))) {
+                return cpu_funcs_[i];
+            }
+        }
+        return nullptr;
     }
 
     const char *name_;
     FuncType funcs_[static_cast<int>(DeviceType::NumDeviceTypes)];
+    FuncType cpu_funcs_[static_cast<int>(CPUBackend::NumCPUBackends)];
 };
 
 #define HMP_DECLARE_DEVICE_DISPATCH(device, name)                              \
@@ -72,6 +110,11 @@ void setDispatch(D &d, const DeviceType &device, Func func) {
     d.set(device, func);
 }
 
+template <typename D, typename Func>
+void setCPUDispatch(D &d, const CPUBackend &backend, Func func) {
+    d.set(backend, func);
+}
+
 #define HMP_DEVICE_DISPATCH(device, name, func)                                \
     namespace {                                                                \
     static Register<name##Class &, const DeviceType &, decltype(func)>         \
@@ -80,6 +123,17 @@ void setDispatch(D &d, const DeviceType &device, Func func) {
     }                                                                          \
     HMP_DEFINE_TAG(__s##device##name##Dispatch);
 
+// register func as the kCPU function of name for CPUBackend::backend, the
+// generic kernels use HMP_DEVICE_DISPATCH(kCPU, ...)
+#define HMP_CPU_BACKEND_DISPATCH(backend, name, func)                          \
+    namespace {                                                                \
+    static Register<name##Class &, const CPUBackend &, decltype(func)>         \
+        __s##backend##name##Dispatch(                                          \
+            setCPUDispatch<name##Class &, decltype(func)>, name,               \
+            CPUBackend::backend, func);                                        \
+    }                                                                          \
+    HMP_DEFINE_TAG(__s##backend##name##Dispatch);
+
 // Scalar type dispatch
 
 #define HMP_TYPE_DISPATCH_CASE(scalar_type, ...)                               \
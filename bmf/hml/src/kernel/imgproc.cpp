@@ -41,6 +41,7 @@ HMP_DEFINE_DISPATCH_STUB(yuv_to_yuv_stub)
 HMP_DEFINE_DISPATCH_STUB(yuv_resize_stub)
 HMP_DEFINE_DISPATCH_STUB(yuv_rotate_stub)
 HMP_DEFINE_DISPATCH_STUB(yuv_mirror_stub)
+HMP_DEFINE_DISPATCH_STUB(yuv_preprocess_stub)
 HMP_DEFINE_DISPATCH_STUB(img_resize_stub)
 HMP_DEFINE_DISPATCH_STUB(img_rotate_stub)
 HMP_DEFINE_DISPATCH_STUB(img_mirror_stub)
@@ -213,6 +214,49 @@ TensorList &yuv_mirror(TensorList &dst, const TensorList &src,
     return dst;
 }
 
+Tensor &yuv_preprocess(Tensor &dst, const TensorList &src, PPixelFormat format,
+                       const Tensor &mean, const Tensor &std,
+                       ImageFilterMode mode, PixelFormat rgbformat) {
+    auto stmp = img::image_format(src, kNHWC);
+    auto dtmp = img::image_format(dst, kNCHW);
+
+    yuv_common_check(stmp, 1, "yuv_preprocess");
+    img_common_check(dtmp, kNCHW, 0, "yuv_preprocess");
+    checkDevice({stmp[0], dtmp, mean, std}, dtmp.device(), "yuv_preprocess");
+    // NV12/NV21 have interleaved chroma in one plane, the others one plane
+    // per chroma channel
+    auto semi_planar =
+        format == PPixelFormat::NV12 || format == PPixelFormat::NV21 ||
+        format == PPixelFormat::NV12_BT709 ||
+        format == PPixelFormat::NV21_BT709;
+    size_t nplanes = semi_planar ? 2 : 3;
+    HMP_REQUIRE(stmp.size() == nplanes,
+                "yuv_preprocess: expect {} planes for PPixelFormat {}, got {}",
+                nplanes, format, stmp.size());
+    for (size_t i = 0; i < stmp.size(); ++i) {
+        int64_t channels = i > 0 && semi_planar ? 2 : 1;
+        HMP_REQUIRE(stmp[i].size(-1) == channels,
+                    "yuv_preprocess: expect {} channels in plane {} for "
+                    "PPixelFormat {}, got {}",
+                    channels, i, format, stmp[i].size(-1));
+    }
+    HMP_REQUIRE(dtmp.size(1) == 3,
+                "yuv_preprocess: require 3 channels for dst, got {}",
+                dtmp.size(1));
+    HMP_REQUIRE(stmp[0].size(0) == dtmp.size(0),
+                "yuv_preprocess: expect src and dst have same batch dim, got "
+                "src={}, dst={}",
+                stmp[0].size(0), dtmp.size(0));
+    HMP_REQUIRE(mean.dim() == 1 && std.dim() == 1 && mean.size(0) == 3 &&
+                    std.size(0) == 3,
+                "yuv_preprocess: invalid mean or std shape, expect (3,)");
+
+    yuv_preprocess_stub(dtmp.device_type(), dtmp, stmp, format, mean, std,
+                        mode, rgbformat);
+
+    return dst;
+}
+
 Tensor &img_resize(Tensor &dst, const Tensor &src, ImageFilterMode mode,
                    ChannelFormat cformat) {
     auto stmp = img::image_format(src, cformat);
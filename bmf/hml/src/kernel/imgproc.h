@@ -71,6 +71,11 @@ HMP_DECLARE_DISPATCH_STUB(yuv_rotate_stub,
 HMP_DECLARE_DISPATCH_STUB(yuv_mirror_stub,
                           TensorList &(*)(TensorList &, const TensorList &,
                                           PPixelFormat, ImageAxis));
+HMP_DECLARE_DISPATCH_STUB(yuv_preprocess_stub,
+                          Tensor &(*)(Tensor &, const TensorList &,
+                                      PPixelFormat, const Tensor &,
+                                      const Tensor &, ImageFilterMode,
+                                      PixelFormat));
 HMP_DECLARE_DISPATCH_STUB(img_resize_stub,
                           Tensor &(*)(Tensor &, const Tensor &, ImageFilterMode,
                                       ChannelFormat));
@@ -128,6 +133,9 @@ TensorList &yuv_rotate(TensorList &dst, const TensorList &src,
 TensorList &yuv_mirror(TensorList &dst, const TensorList &src,
                        PPixelFormat format, ImageAxis axis);
 
+Tensor &yuv_preprocess(Tensor &dst, const TensorList &src, PPixelFormat format,
+                       const Tensor &mean, const Tensor &std,
+                       ImageFilterMode mode, PixelFormat rgbformat);
 Tensor &img_resize(Tensor &dst, const Tensor &src, ImageFilterMode mode,
                    ChannelFormat cformat);
 Tensor &img_rotate(Tensor &dst, const Tensor &src, ImageRotationMode mode,
@@ -16,14 +16,21 @@
 
 #include <kernel/imgproc.h>
 #include <kernel/kernel_utils.h>
-#include <kernel/cpu/libyuv_wrapper.h>
+#include <kernel/libyuv/libyuv_wrapper.h>
 
 namespace hmp {
 namespace kernel {
 namespace {
 
 Tensor &yuv_to_rgb_cpu(Tensor &dst, const TensorList &src, PPixelFormat pformat,
-                       ChannelFormat cformat) {
+                       ChannelFormat cformat, PixelFormat rformat) {
+    // only 8 bit RGB, libyuv calls it RAW
+    if ((pformat != PPixelFormat::I420 && pformat != PPixelFormat::H420) ||
+        rformat != PF_RGB24 || dst.scalar_type() != kUInt8) {
+        return yuv_to_rgb_stub.fallback(CPUBackend::LibYUV, dst, src, pformat,
+                                        cformat, rformat);
+    }
+
     auto out = dst;
     if (cformat == ChannelFormat::NCHW) {
         out = empty({dst.size(0), dst.size(2), dst.size(3), dst.size(1)},
@@ -75,7 +82,14 @@ Tensor &yuv_to_rgb_cpu(Tensor &dst, const TensorList &src, PPixelFormat pformat,
 }
 
 TensorList &rgb_to_yuv_cpu(TensorList &dst, const Tensor &src,
-                           PPixelFormat pformat, ChannelFormat cformat) {
+                           PPixelFormat pformat, ChannelFormat cformat,
+                           PixelFormat rformat) {
+    if (pformat != PPixelFormat::I420 || rformat != PF_RGB24 ||
+        src.scalar_type() != kUInt8) {
+        return rgb_to_yuv_stub.fallback(CPUBackend::LibYUV, dst, src, pformat,
+                                        cformat, rformat);
+    }
+
     auto w = cformat == ChannelFormat::NHWC
                  ? src
                  : src.permute({0, 2, 3, 1}).contiguous();
@@ -99,16 +113,6 @@ TensorList &rgb_to_yuv_cpu(TensorList &dst, const Tensor &src,
                 ds[0].stride(0), ds[1].data<uint8_t>(), ds[1].stride(0),
                 ds[2].data<uint8_t>(), ds[2].stride(0), s.size(1), s.size(0));
             break;
-        case PPixelFormat::H420:
-            HMP_REQUIRE(ds.size() == 3,
-                        "rgb_to_yuv_cpu: expect 3 input planes, got {}",
-                        ds.size());
-            libyuv::RAWToJ420( // FIXME: No RAWToJ420 found
-                s.data<uint8_t>(), s.stride(0), ds[0].data<uint8_t>(),
-                ds[0].stride(0), ds[1].data<uint8_t>(), ds[1].stride(0),
-                ds[2].data<uint8_t>(), ds[2].stride(0), s.size(1), s.size(0));
-            break;
-
         default:
             HMP_REQUIRE(false, "rgb_to_yuv_cpu: unsupport pixel format {}",
                         pformat);
@@ -119,8 +123,32 @@ TensorList &rgb_to_yuv_cpu(TensorList &dst, const Tensor &src,
     return dst;
 }
 
+// libyuv works on single channel planes of uint8_t (and uint16_t for
+// scaling), other cases go to the kernels ranked below
+bool libyuv_planes(const TensorList &planes, bool allow_uint16) {
+    for (auto &p : planes) {
+        if (p.size(-1) != 1 ||
+            !(p.scalar_type() == kUInt8 ||
+              (allow_uint16 && p.scalar_type() == kUInt16))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool libyuv_filter(ImageFilterMode mode) {
+    // libyuv has no bicubic or lanczos filter
+    return mode == ImageFilterMode::Nearest ||
+           mode == ImageFilterMode::Bilinear || mode == ImageFilterMode::Area;
+}
+
 TensorList &yuv_resize_cpu(TensorList &dst, const TensorList &src,
                            PPixelFormat format, ImageFilterMode mode) {
+    if (!libyuv_planes(src, true) || !libyuv_filter(mode)) {
+        return yuv_resize_stub.fallback(CPUBackend::LibYUV, dst, src, format,
+                                        mode);
+    }
+
     auto batch = src[0].size(0);
     auto m = getLibYUVFilterMode(mode);
 
@@ -140,53 +168,69 @@ TensorList &yuv_resize_cpu(TensorList &dst, const TensorList &src,
 
 TensorList &yuv_rotate_cpu(TensorList &dst, const TensorList &src,
                            PPixelFormat format, ImageRotationMode rotate) {
+    if (!libyuv_planes(src, false)) {
+        return yuv_rotate_stub.fallback(CPUBackend::LibYUV, dst, src, format,
+                                        rotate);
+    }
+
     auto batch = src[0].size(0);
     auto m = getLibYUVRotationMode(rotate);
-
-    HMP_DISPATCH_UNSIGNED_INTEGRAL_TYPES(
-        src[0].scalar_type(), "yuv_rotate_cpu", [&]() {
-            for (int64_t i = 0; i < src.size(); ++i) {
-                for (int64_t j = 0; j < batch; ++j) {
-                    auto d = dst[i].select(0, j);
-                    auto s = src[i].select(0, j);
-                    libyuvRotatePlane<scalar_t>(d, s, m);
-                }
-            }
-        });
+    for (int64_t i = 0; i < src.size(); ++i) {
+        for (int64_t j = 0; j < batch; ++j) {
+            auto d = dst[i].select(0, j);
+            auto s = src[i].select(0, j);
+            libyuvRotatePlane<uint8_t>(d, s, m);
+        }
+    }
 
     return dst;
 }
 
 TensorList &yuv_mirror_cpu(TensorList &dst, const TensorList &src,
                            PPixelFormat format, ImageAxis axis) {
+    if (!libyuv_planes(src, false)) {
+        return yuv_mirror_stub.fallback(CPUBackend::LibYUV, dst, src, format,
+                                        axis);
+    }
+
     auto batch = src[0].size(0);
-    HMP_DISPATCH_UNSIGNED_INTEGRAL_TYPES(
-        src[0].scalar_type(), "yuv_mirror_cpu", [&]() {
-            for (int64_t i = 0; i < src.size(); ++i) {
-                for (int64_t j = 0; j < batch; ++j) {
-                    auto d = dst[i].select(0, j);
-                    auto s = src[i].select(0, j);
-                    libyuvMirrorPlane<scalar_t>(d, s, axis);
-                }
-            }
-        });
+    for (int64_t i = 0; i < src.size(); ++i) {
+        for (int64_t j = 0; j < batch; ++j) {
+            auto d = dst[i].select(0, j);
+            auto s = src[i].select(0, j);
+            libyuvMirrorPlane<uint8_t>(d, s, axis);
+        }
+    }
 
     return dst;
 }
 
+// NCHW images as planes of shape (H, W, 1)
+TensorList nchw_planes(const Tensor &img) {
+    TensorList planes;
+    for (int64_t i = 0; i < img.size(0); ++i) {
+        for (int64_t c = 0; c < img.size(1); ++c) {
+            planes.push_back(img.select(0, i).select(0, c).unsqueeze(-1));
+        }
+    }
+    return planes;
+}
+
 Tensor &img_resize_cpu(Tensor &dst, const Tensor &src, ImageFilterMode mode_,
                        ChannelFormat cformat) {
-    HMP_REQUIRE(cformat == ChannelFormat::NCHW,
-                "img_resize_cpu: only support NCHW layout");
+    if (cformat != ChannelFormat::NCHW || !libyuv_filter(mode_) ||
+        (src.scalar_type() != kUInt8 && src.scalar_type() != kUInt16)) {
+        return img_resize_stub.fallback(CPUBackend::LibYUV, dst, src, mode_,
+                                        cformat);
+    }
 
-    auto batch = src.size(0);
     auto mode = getLibYUVFilterMode(mode_);
+    auto dplanes = nchw_planes(dst);
+    auto splanes = nchw_planes(src);
     HMP_DISPATCH_UNSIGNED_INTEGRAL_TYPES(
         src.scalar_type(), "img_resize_cpu", [&]() {
-            for (int64_t i = 0; i < batch; ++i) {
-                auto d = dst.select(0, i);
-                auto s = src.select(0, i);
-                libyuvScalePlane<scalar_t>(d, s, mode);
+            for (size_t i = 0; i < splanes.size(); ++i) {
+                libyuvScalePlane<scalar_t>(dplanes[i], splanes[i], mode);
             }
         });
 
@@ -195,49 +239,48 @@ Tensor &img_resize_cpu(Tensor &dst, const Tensor &src, ImageFilterMode mode_,
 
 Tensor &img_rotate_cpu(Tensor &dst, const Tensor &src, ImageRotationMode mode_,
                        ChannelFormat cformat) {
-    HMP_REQUIRE(cformat == ChannelFormat::NCHW,
-                "img_rotate_cpu: only support NCHW layout");
+    if (cformat != ChannelFormat::NCHW || src.scalar_type() != kUInt8) {
+        return img_rotate_stub.fallback(CPUBackend::LibYUV, dst, src, mode_,
+                                        cformat);
+    }
 
-    auto batch = src.size(0);
     auto mode = getLibYUVRotationMode(mode_);
-    HMP_DISPATCH_UNSIGNED_INTEGRAL_TYPES(
-        src.scalar_type(), "img_rotate_cpu", [&]() {
-            for (int64_t i = 0; i < batch; ++i) {
-                auto d = dst.select(0, i);
-                auto s = src.select(0, i);
-                libyuvRotatePlane<scalar_t>(d, s, mode);
-            }
-        });
+    auto dplanes = nchw_planes(dst);
+    auto splanes = nchw_planes(src);
+    for (size_t i = 0; i < splanes.size(); ++i) {
+        libyuvRotatePlane<uint8_t>(dplanes[i], splanes[i], mode);
+    }
 
     return dst;
 }
 
 Tensor &img_mirror_cpu(Tensor &dst, const Tensor &src, ImageAxis axis,
                        ChannelFormat cformat) {
-    HMP_REQUIRE(cformat == ChannelFormat::NCHW,
-                "img_mirror_cpu: only support NCHW layout");
+    if (cformat != ChannelFormat::NCHW || src.scalar_type() != kUInt8) {
+        return img_mirror_stub.fallback(CPUBackend::LibYUV, dst, src, axis,
+                                        cformat);
+    }
 
-    auto batch = src.size(0);
-    HMP_DISPATCH_UNSIGNED_INTEGRAL_TYPES(
-        src.scalar_type(), "img_mirror_cpu", [&]() {
-            for (int64_t i = 0; i < batch; ++i) {
-                auto d = dst.select(0, i);
-                auto s = src.select(0, i);
-                libyuvMirrorPlane<scalar_t>(d, s, axis);
-            }
-        });
+    auto dplanes = nchw_planes(dst);
+    auto splanes = nchw_planes(src);
+    for (size_t i = 0; i < splanes.size(); ++i) {
+        libyuvMirrorPlane<uint8_t>(dplanes[i], splanes[i], axis);
+    }
 
     return dst;
 }
 
-// HMP_DEVICE_DISPATCH(kCPU, yuv_to_rgb_stub, &yuv_to_rgb_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, rgb_to_yuv_stub, &rgb_to_yuv_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, yuv_resize_stub, &yuv_resize_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, yuv_rotate_stub, &yuv_rotate_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, yuv_mirror_stub, &yuv_mirror_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, img_resize_stub, &img_resize_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, img_rotate_stub, &img_rotate_cpu)
-// HMP_DEVICE_DISPATCH(kCPU, img_mirror_stub, &img_mirror_cpu)
+// libyuv samples the scaled pixels at other positions than the generic
+// kernels and converts I420 with its own fixed point matrix, so results would
+// depend on the selected backend. Only the bit exact kernels are registered.
+// HMP_CPU_BACKEND_DISPATCH(LibYUV, yuv_to_rgb_stub, &yuv_to_rgb_cpu)
+// HMP_CPU_BACKEND_DISPATCH(LibYUV, rgb_to_yuv_stub, &rgb_to_yuv_cpu)
+// HMP_CPU_BACKEND_DISPATCH(LibYUV, yuv_resize_stub, &yuv_resize_cpu)
+HMP_CPU_BACKEND_DISPATCH(LibYUV, yuv_rotate_stub, &yuv_rotate_cpu)
+HMP_CPU_BACKEND_DISPATCH(LibYUV, yuv_mirror_stub, &yuv_mirror_cpu)
+// HMP_CPU_BACKEND_DISPATCH(LibYUV, img_resize_stub, &img_resize_cpu)
+HMP_CPU_BACKEND_DISPATCH(LibYUV, img_rotate_stub, &img_rotate_cpu)
+HMP_CPU_BACKEND_DISPATCH(LibYUV, img_mirror_stub, &img_mirror_cpu)
 } // namespace
 } // namespace kernel
-} // namespace hmp
\ No newline at end of file
+} // namespace hmp
@@ -27,7 +27,7 @@ static libyuv::FilterModeEnum getLibYUVFilterMode(ImageFilterMode mode) {
         return libyuv::kFilterNone;
     case ImageFilterMode::Bilinear:
         return libyuv::kFilterBilinear;
-    case ImageFilterMode::Bicubic:
+    case ImageFilterMode::Area:
         return libyuv::kFilterBox;
     default:
         HMP_REQUIRE(false, "unsupport filter mode({}) in libyuv", mode);
@@ -29,6 +29,10 @@ inline int getNPPIFilterMode(ImageFilterMode mode) {
         return NPPI_INTER_LINEAR;
     case ImageFilterMode::Bicubic:
         return NPPI_INTER_CUBIC;
+    case ImageFilterMode::Area:
+        return NPPI_INTER_SUPER;
+    case ImageFilterMode::Lanczos:
+        return NPPI_INTER_LANCZOS;
     default:
         HMP_REQUIRE(false, "unsupport filter mode({}) in NPPI", mode);
     }
@@ -144,4 +144,72 @@ TEST(TestAllocator, cuda_device_allocator_inactive) {
 
 #endif
 
+TEST(TestAllocator, cpu_caching_allocator) {
+    auto allocator = get_allocator(kCPU);
+    empty_cpu_cache();
+
+    // aligned, small and page sized blocks
+    for (int64_t size : {1, 100, 4000, 3 << 20}) {
+        auto data = allocator->alloc(size);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data.get()) % 64);
+    }
+
+    // freed blocks are handed out again
+    auto stats = cpu_allocator_stats();
+    const int64_t frame_size = 3840 * 2160 * 3 / 2;
+    void *ptr = nullptr;
+    {
+        auto data = allocator->alloc(frame_size);
+        ptr = data.get();
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 4096);
+        EXPECT_GE(cpu_allocator_stats().active, stats.active + frame_size);
+    }
+    EXPECT_GE(cpu_allocator_stats().cached, frame_size);
+    {
+        auto data = allocator->alloc(frame_size);
+        EXPECT_EQ(ptr, data.get());
+        auto small0 = allocator->alloc(1000);
+        void *small_ptr = small0.get();
+        small0 = DataPtr();
+        auto small1 = allocator->alloc(1010); // same size class
+        EXPECT_EQ(small_ptr, small1.get());
+    }
+    auto stats1 = cpu_allocator_stats();
+    EXPECT_EQ(stats.active, stats1.active);
+    EXPECT_EQ(stats.cache_hits + 2, stats1.cache_hits);
+    EXPECT_EQ(stats.system_allocs + 2, stats1.system_allocs);
+
+    // blocks freed by another thread are reused once it exits
+    DataPtr data = allocator->alloc(1 << 16);
+    ptr = data.get();
+    std::thread([&]() { data = DataPtr(); }).join();
+    EXPECT_EQ(ptr, allocator->alloc(1 << 16).get());
+
+    // a block freed by a thread_local destroyed after the cache of its
+    // thread goes to the shared pool, the calling thread caches one already
+    std::thread([&]() {
+        static thread_local DataPtr block; // constructed before the cache
+        block = allocator->alloc(1 << 16);
+        ptr = block.get();
+    }).join();
+    {
+        auto a = allocator->alloc(1 << 16);
+        auto b = allocator->alloc(1 << 16);
+        EXPECT_TRUE(a.get() == ptr || b.get() == ptr);
+    }
+
+    // nothing is kept beyond the limit
+    auto limit = cpu_allocator_stats().cache_limit;
+    set_cpu_cache_limit(0);
+    EXPECT_EQ(0, cpu_allocator_stats().cached);
+    stats = cpu_allocator_stats();
+    allocator->alloc(frame_size);
+    allocator->alloc(frame_size);
+    stats1 = cpu_allocator_stats();
+    EXPECT_EQ(stats.cache_hits, stats1.cache_hits);
+    EXPECT_EQ(stats.system_frees + 2, stats1.system_frees);
+    EXPECT_EQ(0, stats1.cached);
+    set_cpu_cache_limit(limit);
+}
+
 } // namespace hmp
\ No newline at end of file
@@ -258,3 +258,277 @@ TEST(tensor_op, nchw_to_nhwc) {
     // C
     EXPECT_EQ(nhwc.size(NHWC_C), 3);
 }
+
+TEST(tensor_op, mirror_cpu_backends) {
+    auto backend = cpu_backend();
+    for (auto cformat : {kNCHW, kNHWC}) {
+        // 3 channel NHWC rows are not handled by the SIMD kernels
+        for (int64_t channels : {1, 3, 4}) {
+            auto shape = cformat == kNCHW ? SizeArray{2, channels, 17, 67}
+                                          : SizeArray{2, 17, 67, channels};
+            auto src = empty(shape, kUInt8);
+            auto data = src.data<uint8_t>();
+            for (int64_t i = 0; i < src.nitems(); ++i) {
+                data[i] = static_cast<uint8_t>(i * 7 + i / 67);
+            }
+
+            for (auto axis : {ImageAxis::Horizontal, ImageAxis::Vertical,
+                              ImageAxis::HorizontalAndVertical}) {
+                set_cpu_backend(CPUBackend::Generic);
+                auto expect = empty_like(src);
+                img::mirror(expect, src, axis, cformat);
+
+                for (auto b : {CPUBackend::LibYUV, CPUBackend::SIMD}) {
+                    if (!cpu_backend_available(b)) {
+                        continue;
+                    }
+                    set_cpu_backend(b);
+                    auto out = empty_like(src);
+                    img::mirror(out, src, axis, cformat);
+                    EXPECT_EQ(0, memcmp(expect.data<uint8_t>(),
+                                        out.data<uint8_t>(), src.nitems()))
+                        << stringfy(b);
+                }
+            }
+        }
+    }
+    set_cpu_backend(backend);
+}
+
+TEST(tensor_op, rotate_cpu_backends) {
+    auto backend = cpu_backend();
+    for (auto cformat : {kNCHW, kNHWC}) {
+        for (int64_t channels : {1, 3}) {
+            auto shape = cformat == kNCHW ? SizeArray{2, channels, 17, 67}
+                                          : SizeArray{2, 17, 67, channels};
+            auto src = empty(shape, kUInt8);
+            auto data = src.data<uint8_t>();
+            for (int64_t i = 0; i < src.nitems(); ++i) {
+                data[i] = static_cast<uint8_t>(i * 7 + i / 67);
+            }
+
+            for (auto mode :
+                 {ImageRotationMode::Rotate90, ImageRotationMode::Rotate180,
+                  ImageRotationMode::Rotate270}) {
+                auto dshape = shape;
+                if (mode != ImageRotationMode::Rotate180) {
+                    auto hdim = cformat == kNCHW ? 2 : 1;
+                    std::swap(dshape[hdim], dshape[hdim + 1]);
+                }
+                set_cpu_backend(CPUBackend::Generic);
+                auto expect = empty(dshape, kUInt8);
+                img::rotate(expect, src, mode, cformat);
+
+                for (auto b : {CPUBackend::LibYUV, CPUBackend::SIMD}) {
+                    if (!cpu_backend_available(b)) {
+                        continue;
+                    }
+                    set_cpu_backend(b);
+                    auto out = empty(dshape, kUInt8);
+                    img::rotate(out, src, mode, cformat);
+                    EXPECT_EQ(0, memcmp(expect.data<uint8_t>(),
+                                        out.data<uint8_t>(), src.nitems()))
+                        << stringfy(b);
+                }
+            }
+        }
+    }
+    set_cpu_backend(backend);
+}
+
+TEST(tensor_op, resize_filters) {
+    // a 2x area downscale is the mean of each 2x2 block
+    auto src = empty({1, 8, 8, 1}, kFloat32);
+    auto data = src.data<float>();
+    for (int64_t i = 0; i < src.nitems(); ++i) {
+        data[i] = float(i);
+    }
+    auto dst = empty({1, 4, 4, 1}, kFloat32);
+    img::resize(dst, src, ImageFilterMode::Area, kNHWC);
+    for (int64_t y = 0; y < 4; ++y) {
+        for (int64_t x = 0; x < 4; ++x) {
+            auto s = data + y * 16 + x * 2;
+            EXPECT_FLOAT_EQ((s[0] + s[1] + s[8] + s[9]) / 4,
+                            dst.data<float>()[y * 4 + x]);
+        }
+    }
+
+    // a constant image stays constant
+    for (auto mode : {ImageFilterMode::Area, ImageFilterMode::Lanczos}) {
+        auto flat = empty({1, 3, 31, 45}, kUInt8).fill_(77);
+        for (SizeArray size : {SizeArray{1, 3, 13, 17}, SizeArray{1, 3, 64,
+                                                                  90}}) {
+            auto out = empty(size, kUInt8);
+            img::resize(out, flat, mode, kNCHW);
+            for (int64_t i = 0; i < out.nitems(); ++i) {
+                EXPECT_EQ(77, out.data<uint8_t>()[i]);
+            }
+        }
+    }
+}
+
+TEST(tensor_op, resize_cpu_backends) {
+    auto backend = cpu_backend();
+    for (auto cformat : {kNCHW, kNHWC}) {
+        for (int64_t channels : {1, 2, 3, 4}) {
+            auto shape = cformat == kNCHW ? SizeArray{2, channels, 37, 67}
+                                          : SizeArray{2, 37, 67, channels};
+            auto src = empty(shape, kUInt8);
+            auto data = src.data<uint8_t>();
+            for (int64_t i = 0; i < src.nitems(); ++i) {
+                data[i] = static_cast<uint8_t>(i * 7 + i / 67);
+            }
+
+            for (auto mode :
+                 {ImageFilterMode::Bilinear, ImageFilterMode::Bicubic,
+                  ImageFilterMode::Area, ImageFilterMode::Lanczos}) {
+                // the per pixel Filter of Generic has no 2 channel images
+                bool filter = mode == ImageFilterMode::Bilinear ||
+                              mode == ImageFilterMode::Bicubic;
+                if (filter && cformat == kNHWC && channels == 2) {
+                    continue;
+                }
+                for (auto scale : {0.4, 1.7}) {
+                    auto dshape = shape;
+                    auto hdim = cformat == kNCHW ? 2 : 1;
+                    dshape[hdim] = int64_t(shape[hdim] * scale);
+                    dshape[hdim + 1] = int64_t(shape[hdim + 1] * scale);
+
+                    set_cpu_backend(CPUBackend::Generic);
+                    auto expect = empty(dshape, kUInt8);
+                    img::resize(expect, src, mode, cformat);
+
+                    set_cpu_backend(CPUBackend::SIMD);
+                    auto out = empty(dshape, kUInt8);
+                    img::resize(out, src, mode, cformat);
+                    // the passes may sum in another order, Generic filters
+                    // each pixel for Bilinear and Bicubic
+                    for (int64_t i = 0; i < out.nitems(); ++i) {
+                        EXPECT_NEAR(expect.data<uint8_t>()[i],
+                                    out.data<uint8_t>()[i], 1);
+                    }
+                }
+            }
+        }
+    }
+    set_cpu_backend(backend);
+}
+
+TEST(tensor_op, preprocess) {
+    auto max_diff = [](const Tensor &a, const Tensor &b) {
+        auto diff = (a.to(kFloat32) - b.to(kFloat32)).abs().contiguous();
+        auto data = diff.data<float>();
+        float m = 0;
+        for (int64_t i = 0; i < diff.nitems(); ++i) {
+            m = std::max(m, data[i]);
+        }
+        return m;
+    };
+    auto mean = empty({3}, kFloat32);
+    auto std = empty({3}, kFloat32);
+    for (int i = 0; i < 3; ++i) {
+        mean.data<float>()[i] = 120.f - i * 10;
+        std.data<float>()[i] = 50.f + i * 10;
+    }
+
+    for (auto format : {PF_YUV444P, PF_YUV420P, PF_NV12}) {
+        auto pix_info = PixelInfo(format);
+        auto src = Frame(96, 64, pix_info);
+        // smooth planes, so the chroma upsampling of yuv_to_rgb hardly
+        // matters
+        for (int p = 0; p < src.nplanes(); ++p) {
+            auto plane = src.plane(p);
+            auto data = plane.data<uint8_t>();
+            for (int64_t i = 0; i < plane.nitems(); ++i) {
+                auto x = (i % plane.stride(0)) / plane.size(-1);
+                auto y = i / plane.stride(0);
+                data[i] = uint8_t(64 + p * 16 + (x + y) * 64 / plane.size(1));
+            }
+        }
+
+        for (auto mode : {ImageFilterMode::Bilinear, ImageFilterMode::Area}) {
+            // yuv_to_rgb -> resize -> normalize
+            auto rgb = img::yuv_to_rgb(src.data(), pix_info, kNCHW)
+                           .to(kFloat32)
+                           .unsqueeze(0);
+            auto resized = img::resize(rgb, 40, 24, mode, kNCHW);
+            auto expect = img::normalize(resized, mean, std, kNCHW);
+
+            auto out = img::preprocess(src.data(), pix_info, 40, 24, mean,
+                                       std, mode);
+            EXPECT_EQ(out.shape(), SizeArray({3, 24, 40}));
+            // within 3 levels of 8 bit rgb
+            EXPECT_LT(max_diff(out, expect.squeeze(0)), 3.f / 50.f)
+                << stringfy(format);
+
+            auto bgr = img::preprocess(src.data(), pix_info, 40, 24, mean, std,
+                                       mode, kHalf, PF_BGR24);
+            EXPECT_EQ(bgr.dtype(), kHalf);
+            // channel 0 of bgr is blue, normalized with mean[0] and std[0]
+            auto blue = (out.select(0, 2) * 70.f + 100.f - 120.f) / 50.f;
+            EXPECT_LT(max_diff(bgr.select(0, 0), blue), 0.02f);
+        }
+    }
+
+    // planes that do not match the format
+    auto yuv420p = Frame(96, 64, PixelInfo(PF_YUV420P)).data();
+    auto nv12 = Frame(96, 64, PixelInfo(PF_NV12)).data();
+    EXPECT_THROW(img::preprocess(yuv420p, PixelInfo(PF_NV21), 40, 24, mean,
+                                 std),
+                 std::exception);
+    EXPECT_THROW(img::preprocess(nv12, PixelInfo(PF_YUV420P), 40, 24, mean,
+                                 std),
+                 std::exception);
+    // two planes for NV12, but the chroma is planar
+    EXPECT_THROW(img::preprocess({yuv420p[0], yuv420p[1]}, PixelInfo(PF_NV12),
+                                 40, 24, mean, std),
+                 std::exception);
+}
+
+TEST(tensor_op, elementwise_layouts) {
+    auto fill = [](Tensor t) {
+        auto data = t.data<float>();
+        for (int64_t i = 0; i < t.nitems(); ++i) {
+            data[i] = float(i % 251);
+        }
+        return t;
+    };
+
+    // contiguous, a crop with padded rows and a transposed view
+    auto base = fill(empty({6, 40, 3}, kFloat32));
+    std::vector<Tensor> views{base, base.slice(1, 4, 37),
+                              base.transpose(0, 1)};
+    for (auto &view : views) {
+        auto a = view.clone();
+        auto b = fill(empty(view.shape(), kFloat32));
+        auto expect = a.contiguous();
+        auto out = view;
+        out += b;
+        out = out.contiguous();
+        auto bc = b.contiguous();
+        for (int64_t i = 0; i < out.nitems(); ++i) {
+            EXPECT_EQ(expect.data<float>()[i] + bc.data<float>()[i],
+                      out.data<float>()[i]);
+        }
+        // restore the view, the next one shares the buffer
+        view.copy_(a);
+    }
+
+    // clip of a crop leaves the padding alone
+    auto frame = fill(empty({4, 20, 3}, kFloat32));
+    auto crop = frame.slice(1, 2, 18);
+    crop.clip_(10, 20);
+    auto data = frame.data<float>();
+    for (int64_t i = 0; i < frame.nitems(); ++i) {
+        auto x = (i / 3) % 20;
+        auto v = float(i % 251);
+        auto expect = x >= 2 && x < 18 ? std::min(std::max(v, 10.f), 20.f) : v;
+        EXPECT_EQ(expect, data[i]);
+    }
+
+    // inputs of another dtype are rejected, not truncated to the output's
+    auto u8 = empty({2, 33}, kUInt8).fill_(7);
+    auto f32 = empty({2, 33}, kFloat32).fill_(0.5f);
+    EXPECT_THROW(u8 *= f32, std::exception);
+    EXPECT_THROW(u8 += f32.fill_(300.f), std::exception);
+}
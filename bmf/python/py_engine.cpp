@@ -34,6 +34,11 @@ void engine_bind(py::module &m) {
         .def_nogil(py::init<std::string const &, bool, bool>(),
                    py::arg("graph_config"), py::arg("is_path") = false,
                    py::arg("need_merge") = true)
+        .def_static("from_template", &BMFGraph::from_template,
+                    py::arg("graph_config"),
+                    py::arg("node_options") = std::map<int, std::string>(),
+                    py::arg("need_merge") = true,
+                    py::call_guard<py::gil_scoped_release>())
         .def_nogil("uid", &BMFGraph::uid)
         .def_nogil("start", &BMFGraph::start)
         .def_nogil("update", &BMFGraph::update, py::arg("config"),
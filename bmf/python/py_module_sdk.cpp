@@ -289,7 +289,9 @@ void module_sdk_bind(py::module &m) {
         .def_readwrite("module_path", &ModuleInfo::module_path)
         .def_readwrite("module_type", &ModuleInfo::module_type)
         .def_readwrite("module_description", &ModuleInfo::module_description)
-        .def_readwrite("module_tag", &ModuleInfo::module_tag);
+        .def_readwrite("module_tag", &ModuleInfo::module_tag)
+        .def_readwrite("module_max_batch", &ModuleInfo::module_max_batch)
+        .def_readwrite("module_reusable", &ModuleInfo::module_reusable);
 
     py::class_<OpaqueDataSet>(m, "OpaqueDataSet")
         .def("private_merge", &OpaqueDataSet::private_merge, py::arg("from"))
@@ -235,6 +235,10 @@ BMF_SDK_API void bmf_module_info_set_description(bmf_ModuleInfo info,
                                                  const char *description);
 BMF_SDK_API void bmf_module_info_set_tag(bmf_ModuleInfo info,
                                          const bmf_ModuleTag tag);
+BMF_SDK_API void bmf_module_info_set_max_batch(bmf_ModuleInfo info,
+                                               int32_t max_batch);
+BMF_SDK_API void bmf_module_info_set_reusable(bmf_ModuleInfo info,
+                                              bool reusable);
 
 ///////// ModuleFunctor /////////////
 BMF_SDK_API bmf_ModuleFunctor bmf_module_functor_make(
@@ -62,6 +62,14 @@ class BMF_SDK_API ModuleInfo {
     std::string module_path;
     std::string module_description;
     ModuleTag module_tag;
+    // max number of timestamps the module can handle in one process() call,
+    // modules that drain every packet of a task may raise it to let the
+    // engine batch ready timestamps (see node meta "max_batch")
+    int32_t module_max_batch = 1;
+    // reset() brings the module back to the state right after init(), so
+    // the engine may keep it for the next graph (see node meta
+    // "module_pool")
+    bool module_reusable = false;
 };
 
 /**
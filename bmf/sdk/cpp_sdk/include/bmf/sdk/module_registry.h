@@ -67,6 +67,15 @@ class BMF_SDK_API ModuleRegistry {
 
     static std::string GetModuleUsingSDKVersion(std::string const &module_name);
 
+    // REGISTER_MODULE_INFO functions by module name, the only way to find
+    // them for modules built into the app
+    typedef void (*InfoRegister)(ModuleInfo &info);
+
+    static std::unordered_map<std::string, InfoRegister> &InfoRegistry();
+
+    static void AddInfoRegister(std::string const &module_name,
+                                InfoRegister info_register);
+
   private:
     ModuleRegistry() {}
 };
@@ -84,6 +93,12 @@ class BMF_SDK_API ModuleRegister {
                        int node_id, JsonParam json_param));
 };
 
+class BMF_SDK_API ModuleInfoRegister {
+  public:
+    ModuleInfoRegister(std::string const &module_name,
+                       ModuleRegistry::InfoRegister info_register);
+};
+
 #define REGISTER_MODULE_CONSTRUCTOR(module_name, constructor)                  \
     static ::bmf_sdk::ModuleRegister r_constructor_##module_name(              \
         #module_name, BMF_SDK_VERSION, constructor);
@@ -98,6 +113,10 @@ class BMF_SDK_API ModuleRegister {
     REGISTER_MODULE_CONSTRUCTOR(module_name, Constructor_##module_name##Module);
 
 #define REGISTER_MODULE_INFO(module_name, info)                                \
+    extern "C" BMF_MODULE_EXPORT void register_##module_name##_info(           \
+        ModuleInfo &info);                                                     \
+    static ::bmf_sdk::ModuleInfoRegister r_info_##module_name(                 \
+        #module_name, &register_##module_name##_info);                         \
     extern "C" BMF_MODULE_EXPORT void register_##module_name##_info(           \
         ModuleInfo &info)
 
@@ -24,6 +24,15 @@ namespace bmf_sdk {
 
 class Packet;
 
+// Where the data of a packet entered the graph, only set when the graph
+// tracks latency. source is the id of the node which produced it first, -1
+// for a graph input stream, hops counts the nodes which produced it since.
+struct PacketTraceContext {
+    int64_t ingest_time = 0; // steady clock nanoseconds, 0 if unset
+    int32_t source = -1;
+    int32_t hops = 0;
+};
+
 // like boost::any, but with refcount support
 class BMF_SDK_API PacketImpl : public RefObject {
     std::function<void(void *)> del_;
@@ -31,6 +40,7 @@ class BMF_SDK_API PacketImpl : public RefObject {
     const TypeInfo *type_info_ = nullptr;
     int64_t timestamp_ = Timestamp::UNSET;
     double time_ = 0;
+    PacketTraceContext trace_context_;
 
   public:
     PacketImpl() = delete;
@@ -67,6 +77,12 @@ class BMF_SDK_API PacketImpl : public RefObject {
 
     double time() const { return time_; }
 
+    void set_trace_context(const PacketTraceContext &context) {
+        trace_context_ = context;
+    }
+
+    const PacketTraceContext &trace_context() const { return trace_context_; }
+
   protected:
     friend class Packet;
     PacketImpl(void *obj, const TypeInfo *type_info,
@@ -113,6 +129,11 @@ class BMF_SDK_API Packet {
     void set_time(double time);
     double time() const;
 
+    // where the data of the packet entered the graph, set by the engine when
+    // it tracks latency, see PacketTraceContext
+    void set_trace_context(const PacketTraceContext &context);
+    const PacketTraceContext &trace_context() const;
+
     PacketImpl *unsafe_self();
     const PacketImpl *unsafe_self() const;
 
@@ -30,6 +30,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <filesystem>
+#include <type_traits>
 #include <unordered_map>
 
 #include "time.h"
@@ -200,6 +201,34 @@ inline uint16_t get_trace_allowed() {
 */
 inline const uint16_t TRACE_ALLOWED_TYPES = get_trace_allowed();
 
+// Most names TraceNames keeps, further names share TraceNames::OVERFLOW_ID
+inline const uint32_t TRACE_MAX_NAMES = 4096;
+
+/* TraceNames interns the names of trace events, events only carry the ids
+
+    Ids are stable for the life of the process. Hot paths look their names up
+    once and keep the ids, e.g. a node keeps the id of its name. Other
+    callers go through id(), which answers from a per-thread cache keyed by
+    the name pointer and does not allocate once the name is known
+
+    Names built at run time, e.g. formatted ones or names from Python, would
+    grow the table for good, so it is bounded by TRACE_MAX_NAMES and names
+    past it are all logged as "[overflow]"
+*/
+class BMF_SDK_API TraceNames {
+  public:
+    static constexpr uint32_t OVERFLOW_ID = 0;
+
+    // Get the id of the name, registering it on first use
+    static uint32_t intern(const char *name);
+
+    // Same as intern(), cached for the calling thread
+    static uint32_t id(const char *name);
+
+    // Get the name of a registered id
+    static std::string get(uint32_t id);
+};
+
 /* Add or remove trace during compilation
     Include -DNO_TRACE to totally remove trace
 */
@@ -216,27 +245,59 @@ inline uint64_t BMF_TRACE_CLOCK() {
 
 inline const uint64_t BMF_TRACE_CLOCK_START = BMF_TRACE_CLOCK();
 
-// TraceEvent class encapsulates all the information emitted by trace
-class TraceEvent {
-  public:
+// Bytes of serialized user info a TraceEvent holds, the fields of longer info
+// which do not fit are dropped
+#define TRACE_INFO_SIZE 52
+
+/* TraceEvent encapsulates all the information emitted by trace
+
+    It is a fixed-size POD with the names as TraceNames ids, so emitting an
+    event copies it into the TraceBuffer and never allocates
+*/
+struct TraceEvent {
     int64_t timestamp;
-    std::string name;
-    std::string subname;
-    TraceType category;
-    TracePhase phase;
-    std::string info;
-    TraceEvent();
-
-    TraceEvent(int64_t timestamp, const char *name, const char *subname,
-               TraceType category, TracePhase phase)
-        : timestamp(timestamp), name(name), subname(subname),
-          category(category), phase(phase) {}
-
-    TraceEvent(int64_t timestamp, const char *name, const char *subname,
-               TraceType category, TracePhase phase, std::string info)
-        : timestamp(timestamp), name(name), subname(subname),
-          category(category), phase(phase), info(info) {}
+    uint32_t name;
+    uint32_t subname;
+    uint8_t category;
+    uint8_t phase;
+    uint16_t info_size;
+    char info[TRACE_INFO_SIZE];
 };
+static_assert(std::is_trivially_copyable<TraceEvent>::value,
+              "trace events are copied into the buffers as they are");
+
+// Bytes of serialized user info a TraceEvent keeps, up to the last field
+// which fits in whole
+BMF_SDK_API size_t trace_info_fit(const char *info, size_t size);
+
+/* TraceRecord is the fixed-width record of the binary trace logs
+
+    A log starts with TRACE_LOG_MAGIC followed by records, each of them is
+    followed by size bytes of payload. Strings are interned per log file: a
+    TRACE_RECORD_STRING record defines string id `name` as its payload before
+    the first TRACE_RECORD_EVENT record which refers to it, the payload of an
+    event record is its serialized user info.
+*/
+#define TRACE_LOG_MAGIC "BMFTRC01"
+#define TRACE_LOG_MAGIC_SIZE 8
+
+enum TraceRecordKind : uint16_t {
+    TRACE_RECORD_STRING = 1,
+    TRACE_RECORD_EVENT = 2
+};
+
+struct TraceRecord {
+    uint16_t kind;
+    uint8_t category;
+    uint8_t phase;
+    uint32_t size;
+    int64_t timestamp;
+    uint32_t process;
+    uint32_t thread;
+    uint32_t name;
+    uint32_t subname;
+};
+static_assert(sizeof(TraceRecord) == 32, "trace records are fixed-width");
 
 /* TraceBuffer class is a lock-free circular buffer of fixed size for single
     producer thread and single consumer thread
@@ -255,6 +316,9 @@ class TraceBuffer {
   public:
     std::string process_name;
     std::string thread_name;
+    // TraceNames ids of process_name and thread_name
+    uint32_t process_name_id = 0;
+    uint32_t thread_name_id = 0;
 
     TraceBuffer() : buffer_(trace_get_buffer_size()) {}
 
@@ -341,12 +405,14 @@ class BMF_SDK_API TraceLogger {
     void close_queue(int thread_id);
 
     // Adds a new event to the allocated buffer based on thread
-    void push(int thread_id, TraceEvent &event);
+    void push(int thread_id, const TraceEvent &event);
 
     // Removes the oldest event from the allocated buffer based on thread
     TraceEvent pop(int thread_id);
 
-    // Generate formatted logs
+    // Convert the binary logs of the working directory into a formatted
+    // Chrome/Perfetto trace, event by event, so the memory used does not
+    // grow with the length of the run
     void format_logs(bool include_info = true);
 
   private:
@@ -363,10 +429,19 @@ class BMF_SDK_API TraceLogger {
     int64_t current_limit_ = TRACE_BINLOG_INTERVAL;
     bool enable_printing = true;
     bool enable_format_log = true;
+    // TraceNames ids already defined in the current binary log
+    std::vector<bool> defined_;
 
     // Get the binary log name based on given log index
     std::string get_log_name(int index);
 
+    // Write the definition of a TraceNames id to the current binary log on
+    // its first use there, returns the id
+    uint32_t define(uint32_t id);
+
+    // Append an event of the buffer to the current binary log
+    void write_event(const TraceBuffer &buffer, const TraceEvent &event);
+
     // Creates a new binary log file (overwrites if already exists)
     void create_log();
 
@@ -415,7 +490,8 @@ class BMF_SDK_API ThreadTrace {
 
     // Trace invocation for all event types with user info
     void trace_info(TraceType category, const char *name, TracePhase phase,
-                    std::string info, const char *src = __builtin_FUNCTION());
+                    const std::string &info,
+                    const char *src = __builtin_FUNCTION());
 
     // Trace invocation for processing type event
     void trace_process(const char *name, const char *subname, TracePhase phase);
@@ -423,6 +499,11 @@ class BMF_SDK_API ThreadTrace {
     // Trace invocation for interlatency type event
     void trace_latency(int64_t packet, TracePhase phase);
 
+    // Trace invocation with TraceNames ids and raw serialized user info
+    void emit(TraceType category, uint32_t name, uint32_t subname,
+              TracePhase phase, const char *info = nullptr,
+              size_t info_size = 0);
+
   private:
     int thread_id_;
     std::string thread_name_;
@@ -474,6 +555,18 @@ inline void BMF_TRACE(TraceType category, const char *name, TracePhase phase,
     }
 }
 
+/* Emit a Trace Event with names registered in TraceNames beforehand
+    Example:
+    uint32_t node = TraceNames::intern("Node_A");
+    BMF_TRACE_ID(PROCESSING, node, TraceNames::intern("process"), START)
+*/
+inline void BMF_TRACE_ID(TraceType category, uint32_t name, uint32_t subname,
+                         TracePhase phase = NONE) {
+    if (TRACE_ALLOWED_TYPES >> category & 1) {
+        threadTracer.emit(category, name, subname, phase);
+    }
+}
+
 // Calls the thread-local processing-type trace
 inline void BMF_TRACE_PROCESS(const char *name, const char *subname,
                               TracePhase phase) {
@@ -486,21 +579,29 @@ inline void BMF_TRACE_PROCESS(const char *name, const char *subname,
 inline void BMF_TRACE_QUEUE_INFO(const char *name, int queue_size, int max_size,
                                  const char *src = __builtin_FUNCTION()) {
     if (TRACE_ALLOWED_TYPES >> QUEUE_INFO & 1) {
-        TraceUserInfo info = TraceUserInfo();
-        info.set("size", queue_size);
-        info.set("max", max_size);
-        threadTracer.trace_info(QUEUE_INFO, name, NONE, info.get(), src);
+        // Same as TraceUserInfo serializes it, without building strings.
+        // Room for every field, emit() drops the ones which do not fit
+        char info[2 * TRACE_INFO_SIZE];
+        int size = snprintf(info, sizeof(info), ",size:1:%d,max:1:%d",
+                            queue_size, max_size);
+        threadTracer.emit(QUEUE_INFO, TraceNames::id(name),
+                          TraceNames::id(src), NONE, info,
+                          std::min<int>(size, sizeof(info) - 1));
     }
 }
 
-// Calls the throughput trace
+// Calls the throughput trace, the stream and node ids are fields of the
+// event, the formatted log names it "Stream<id>:Node<id>"
 inline void BMF_TRACE_THROUGHPUT(int stream_id, int node_id, int queue_size) {
     if (TRACE_ALLOWED_TYPES >> THROUGHPUT & 1) {
-        TraceUserInfo info = TraceUserInfo();
-        info.set("size", queue_size);
-        threadTracer.trace_info(
-            THROUGHPUT, ("Stream" + std::to_string(stream_id)).c_str(), NONE,
-            info.get(), ("Node" + std::to_string(node_id)).c_str());
+        static const uint32_t name = TraceNames::intern("Stream");
+        static const uint32_t subname = TraceNames::intern("Node");
+        char info[2 * TRACE_INFO_SIZE];
+        int size =
+            snprintf(info, sizeof(info), ",stream:1:%d,node:1:%d,size:1:%d",
+                     stream_id, node_id, queue_size);
+        threadTracer.emit(THROUGHPUT, name, subname, NONE, info,
+                          std::min<int>(size, sizeof(info) - 1));
     }
 }
 
@@ -526,24 +627,36 @@ inline void BMF_TRACE_INIT(const char *src = __builtin_FUNCTION()) {
 class TraceProcessEmitter {
   public:
     TraceProcessEmitter() = delete;
-    TraceProcessEmitter(TraceType category, std::string node_name,
+    TraceProcessEmitter(TraceType category, uint32_t name,
                         const char *src = __builtin_FUNCTION())
-        : node_name_(node_name), src_(src), category_(category) {
-        BMF_TRACE(category, node_name.c_str(), START, src);
+        : category_(category), enabled_(TRACE_ALLOWED_TYPES >> category & 1),
+          name_(name), src_(enabled_ ? TraceNames::id(src) : 0) {
+        if (enabled_)
+            threadTracer.emit(category_, name_, src_, START);
     };
+    TraceProcessEmitter(TraceType category, const std::string &node_name,
+                        const char *src = __builtin_FUNCTION())
+        : TraceProcessEmitter(category,
+                              TRACE_ALLOWED_TYPES >> category & 1
+                                  ? TraceNames::id(node_name.c_str())
+                                  : 0,
+                              src) {}
     ~TraceProcessEmitter() {
-        BMF_TRACE(category_, node_name_.c_str(), END, src_.c_str());
+        if (enabled_)
+            threadTracer.emit(category_, name_, src_, END);
     };
 
   private:
-    std::string node_name_;
-    std::string src_;
     TraceType category_;
+    bool enabled_;
+    uint32_t name_;
+    uint32_t src_;
 };
 
 #else
 
 #define BMF_TRACE(...)
+#define BMF_TRACE_ID(...)
 #define BMF_TRACE_PROCESS(...)
 #define BMF_TRACE_LATENCY(...)
 #define BMF_TRACE_PROCESS(...)
@@ -542,6 +542,14 @@ void bmf_module_info_set_tag(bmf_ModuleInfo info, const bmf_ModuleTag tag) {
     info->module_tag = *tag;
 }
 
+void bmf_module_info_set_max_batch(bmf_ModuleInfo info, int32_t max_batch) {
+    info->module_max_batch = max_batch;
+}
+
+void bmf_module_info_set_reusable(bmf_ModuleInfo info, bool reusable) {
+    info->module_reusable = reusable;
+}
+
 //////////////// ModuleFunctor ////////////
 bmf_ModuleFunctor bmf_module_functor_make(const char *name, const char *type,
                                           const char *path, const char *entry,
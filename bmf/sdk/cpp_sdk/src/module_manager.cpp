@@ -85,6 +85,13 @@ class CPPModuleFactory : public ModuleFactoryI {
             dump_func(info);
             return true;
         }
+        // in-app modules have no library to look the symbol up in
+        auto &registry = ModuleRegistry::InfoRegistry();
+        auto it = registry.find(class_name_);
+        if (it != registry.end()) {
+            it->second(info);
+            return true;
+        }
         return false;
     }
 
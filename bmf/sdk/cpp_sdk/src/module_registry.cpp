@@ -62,6 +62,18 @@ ModuleRegistry::GetModuleUsingSDKVersion(const std::string &module_name) {
     return registry[module_name].first;
 }
 
+std::unordered_map<std::string, ModuleRegistry::InfoRegister> &
+ModuleRegistry::InfoRegistry() {
+    static auto *registry =
+        new std::unordered_map<std::string, InfoRegister>();
+    return *registry;
+}
+
+void ModuleRegistry::AddInfoRegister(std::string const &module_name,
+                                     InfoRegister info_register) {
+    InfoRegistry()[module_name] = info_register;
+}
+
 ModuleRegister::ModuleRegister(
     std::string const &module_name, std::string const &sdk_version,
     std::shared_ptr<Module> (*constructor)(int node_id, JsonParam json_param)) {
@@ -73,4 +85,10 @@ ModuleRegister::ModuleRegister(
     std::shared_ptr<Module> (*constructor)(int, JsonParam)) {
     ModuleRegistry::AddConstructor(module_name, "V0.0.1", constructor);
 }
+
+ModuleInfoRegister::ModuleInfoRegister(
+    std::string const &module_name,
+    ModuleRegistry::InfoRegister info_register) {
+    ModuleRegistry::AddInfoRegister(module_name, info_register);
+}
 END_BMF_SDK_NS
\ No newline at end of file
@@ -60,6 +60,16 @@ double Packet::time() const {
     return self->time();
 }
 
+void Packet::set_trace_context(const PacketTraceContext &context) {
+    HMP_REQUIRE(*this, "Packet: null packet");
+    self->set_trace_context(context);
+}
+
+const PacketTraceContext &Packet::trace_context() const {
+    HMP_REQUIRE(*this, "Packet: null packet");
+    return self->trace_context();
+}
+
 Packet Packet::generate_eos_packet() {
     Packet pkt = Packet(0);
     pkt.set_timestamp(EOS);
@@ -19,14 +19,83 @@
 #include <unistd.h>
 #include <nlohmann/json.hpp>
 
+#include <deque>
+#include <mutex>
+#include <string_view>
+
 BEGIN_BMF_SDK_NS
 
+namespace {
+
+struct TraceNameTable {
+    std::mutex mutex;
+    // Elements of a deque stay in place, the ids map views of them
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    TraceNameTable() {
+        names.emplace_back("[overflow]");
+        ids.emplace(names.back(), TraceNames::OVERFLOW_ID);
+    }
+};
+
+TraceNameTable &trace_name_table() {
+    static TraceNameTable table;
+    return table;
+}
+
+uint32_t intern_name(const char *name, const char **stored) {
+    auto &table = trace_name_table();
+    std::lock_guard<std::mutex> guard(table.mutex);
+    auto it = table.ids.find(std::string_view(name));
+    if (it == table.ids.end()) {
+        if (table.names.size() >= TRACE_MAX_NAMES) {
+            *stored = table.names[TraceNames::OVERFLOW_ID].data();
+            return TraceNames::OVERFLOW_ID;
+        }
+        table.names.emplace_back(name);
+        it = table.ids.emplace(table.names.back(), table.names.size() - 1)
+                 .first;
+    }
+    *stored = it->first.data();
+    return it->second;
+}
+
+} // namespace
+
+uint32_t TraceNames::intern(const char *name) {
+    const char *stored;
+    return intern_name(name, &stored);
+}
+
+uint32_t TraceNames::id(const char *name) {
+    // Direct mapped by pointer, comparing with the registered copy catches a
+    // pointer reused for another name, e.g. a temporary string
+    struct Slot {
+        const char *ptr;
+        const char *name;
+        uint32_t id;
+    };
+    thread_local Slot cache[256] = {};
+    auto &slot = cache[(reinterpret_cast<uintptr_t>(name) >> 4) & 255];
+    if (slot.ptr == name && std::strcmp(slot.name, name) == 0)
+        return slot.id;
+    slot.id = intern_name(name, &slot.name);
+    // an overflowed name does not match the stored one, it is not cached
+    slot.ptr = std::strcmp(slot.name, name) == 0 ? name : nullptr;
+    return slot.id;
+}
+
+std::string TraceNames::get(uint32_t id) {
+    auto &table = trace_name_table();
+    std::lock_guard<std::mutex> guard(table.mutex);
+    return id < table.names.size() ? table.names[id] : std::string();
+}
+
 #ifndef NO_TRACE
 
 inline TraceLogger *TraceLogger::traceLogger;
 
-TraceEvent::TraceEvent() {}
-
 void TraceBuffer::push_event(const TraceEvent &event) {
     total_count_++;
     // Handle overflow
@@ -130,13 +199,17 @@ void TraceLogger::end() {
 
 int TraceLogger::register_queue(std::string process_name,
                                 std::string thread_name) {
-    // Assign buffer for the thread
-    queue_map_[thread_count_].process_name = process_name;
-    queue_map_[thread_count_].thread_name = thread_name;
+    // Assign buffer for the thread, back to first buffer to reuse buffer
+    // once all are taken
+    int thread_id = thread_count_++ % queue_map_.size();
+    queue_map_[thread_id].process_name = process_name;
+    queue_map_[thread_id].thread_name = thread_name;
+    queue_map_[thread_id].process_name_id =
+        TraceNames::intern(process_name.c_str());
+    queue_map_[thread_id].thread_name_id =
+        TraceNames::intern(thread_name.c_str());
     running_count_++;
-    if (thread_count_ == queue_map_.size() - 1)
-        thread_count_ = 0; // Back to first buffer to reuse buffer
-    return thread_count_++;
+    return thread_id;
 }
 
 void TraceLogger::close_queue(int thread_id) {
@@ -146,7 +219,7 @@ void TraceLogger::close_queue(int thread_id) {
     }
 }
 
-void TraceLogger::push(int thread_id, TraceEvent &event) {
+void TraceLogger::push(int thread_id, const TraceEvent &event) {
     queue_map_[thread_id].push_event(event);
 }
 
@@ -155,12 +228,48 @@ TraceEvent TraceLogger::pop(int thread_id) {
 }
 
 std::string TraceLogger::get_log_name(int index) {
-    return "log" + std::to_string(index) + ".txt";
+    return "log" + std::to_string(index) + ".bin";
 }
 
 void TraceLogger::create_log() {
-    ofs_.open(get_log_name(log_index_),
-              std::ofstream::out | std::ofstream::trunc);
+    ofs_.open(get_log_name(log_index_), std::ofstream::out |
+                                            std::ofstream::trunc |
+                                            std::ofstream::binary);
+    // Every log file carries its own strings
+    defined_.clear();
+    ofs_.write(TRACE_LOG_MAGIC, TRACE_LOG_MAGIC_SIZE);
+}
+
+uint32_t TraceLogger::define(uint32_t id) {
+    if (id < defined_.size() && defined_[id])
+        return id;
+    if (id >= defined_.size())
+        defined_.resize(id + 1);
+    defined_[id] = true;
+    std::string str = TraceNames::get(id);
+    TraceRecord record = {};
+    record.kind = TRACE_RECORD_STRING;
+    record.size = str.size();
+    record.name = id;
+    ofs_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    ofs_.write(str.data(), str.size());
+    return id;
+}
+
+void TraceLogger::write_event(const TraceBuffer &buffer,
+                              const TraceEvent &event) {
+    TraceRecord record = {};
+    record.kind = TRACE_RECORD_EVENT;
+    record.category = event.category;
+    record.phase = event.phase;
+    record.size = event.info_size;
+    record.timestamp = event.timestamp;
+    record.process = define(buffer.process_name_id);
+    record.thread = define(buffer.thread_name_id);
+    record.name = define(event.name);
+    record.subname = define(event.subname);
+    ofs_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    ofs_.write(event.info, event.info_size);
 }
 
 void TraceLogger::close_log() {
@@ -174,10 +283,7 @@ void TraceLogger::process_queues() {
     for (int i = 0; i < queue_map_.size(); i++) {
         while (!queue_map_[i].is_empty()) {
             TraceEvent event = pop(i);
-            ofs_ << queue_map_[i].process_name << ","
-                 << queue_map_[i].thread_name << "," << event.timestamp << ","
-                 << event.name << ":" << event.subname << "," << event.category
-                 << "," << event.phase << event.info << std::endl;
+            write_event(queue_map_[i], event);
         }
     }
 
@@ -242,41 +348,125 @@ ThreadTrace::~ThreadTrace() {
 
 void ThreadTrace::trace(TraceType category, const char *name, TracePhase phase,
                         const char *src) {
-    // Get the current timestamp
-    int64_t timestamp = BMF_TRACE_CLOCK() - BMF_TRACE_CLOCK_START;
-
-    // Create a trace event
-    TraceEvent event = TraceEvent(timestamp, name, src, category, phase);
-
-    // Send the event to buffer
-    TraceLogger::instance()->push(thread_id_, event);
+    emit(category, TraceNames::id(name), TraceNames::id(src), phase);
 }
 
 void ThreadTrace::trace_info(TraceType category, const char *name,
-                             TracePhase phase, std::string info,
+                             TracePhase phase, const std::string &info,
                              const char *src) {
-    // Get the current timestamp
-    int64_t timestamp = BMF_TRACE_CLOCK() - BMF_TRACE_CLOCK_START;
-
-    // Create a trace event
-    TraceEvent event = TraceEvent(timestamp, name, src, category, phase, info);
-
-    // Send the event to buffer
-    TraceLogger::instance()->push(thread_id_, event);
+    emit(category, TraceNames::id(name), TraceNames::id(src), phase,
+         info.data(), info.size());
 }
 
 void ThreadTrace::trace_process(const char *name, const char *subname,
                                 TracePhase phase) {
-    // Get the current timestamp
-    int64_t timestamp = BMF_TRACE_CLOCK() - BMF_TRACE_CLOCK_START;
+    emit(PROCESSING, TraceNames::id(name), TraceNames::id(subname), phase);
+}
 
-    // Create a trace event
-    TraceEvent event = TraceEvent(timestamp, name, subname, PROCESSING, phase);
+size_t trace_info_fit(const char *info, size_t size) {
+    if (size <= TRACE_INFO_SIZE)
+        return size;
+    // keep whole fields only, a cut off value would parse as another one
+    size = TRACE_INFO_SIZE;
+    while (size > 0 && info[size] != ',')
+        --size;
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true))
+        BMFLOG(BMF_WARNING) << "trace info is longer than " << TRACE_INFO_SIZE
+                            << " bytes, the fields beyond are dropped";
+    return size;
+}
+
+void ThreadTrace::emit(TraceType category, uint32_t name, uint32_t subname,
+                       TracePhase phase, const char *info, size_t info_size) {
+    // Create a trace event with the current timestamp
+    TraceEvent event;
+    event.timestamp = BMF_TRACE_CLOCK() - BMF_TRACE_CLOCK_START;
+    event.name = name;
+    event.subname = subname;
+    event.category = category;
+    event.phase = phase;
+    event.info_size = trace_info_fit(info, info_size);
+    if (event.info_size)
+        std::memcpy(event.info, info, event.info_size);
 
     // Send the event to buffer
     TraceLogger::instance()->push(thread_id_, event);
 }
 
+namespace {
+
+// Parse serialized user info ",key:type:value,..." into event args
+nlohmann::json parse_trace_info(const std::string &info) {
+    nlohmann::json args = nlohmann::json::object();
+    std::stringstream ss(info);
+    std::string term;
+    while (getline(ss, term, ',')) {
+        size_t key_end = term.find(':');
+        if (key_end == std::string::npos)
+            continue;
+        size_t type_end = term.find(':', key_end + 1);
+        if (type_end == std::string::npos)
+            continue;
+        std::string key = term.substr(0, key_end);
+        std::string valtype = term.substr(key_end + 1, type_end - key_end - 1);
+        std::string value = term.substr(type_end + 1);
+        if (valtype == "1") {
+            // Handle int type value (decimal string)
+            args[key] = strtoll(value.c_str(), NULL, 10);
+        } else if (valtype == "2") {
+            // Handle double type value (decimal string)
+            args[key] = atof(value.c_str());
+        } else {
+            // Handle string type (default) value
+            args[key] = value;
+        }
+    }
+    return args;
+}
+
+// Read a binary trace log record by record, only the strings of the file are
+// kept in memory. Returns false if the file is not a binary trace log
+template <typename F>
+bool read_trace_log(const std::string &path, F &&on_event) {
+    std::ifstream in(path, std::ifstream::binary);
+    char magic[TRACE_LOG_MAGIC_SIZE];
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, TRACE_LOG_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    static const std::string unknown = "unknown";
+    std::vector<std::string> strings;
+    auto lookup = [&strings](uint32_t id) -> const std::string & {
+        return id < strings.size() ? strings[id] : unknown;
+    };
+
+    TraceRecord record;
+    std::string payload;
+    // A log cut short by a crash ends at its last complete record
+    while (in.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+        if (record.size > (1 << 24))
+            break;
+        payload.resize(record.size);
+        if (record.size && !in.read(&payload[0], record.size))
+            break;
+        if (record.kind == TRACE_RECORD_STRING) {
+            if (record.name >= strings.size())
+                strings.resize(record.name + 1);
+            strings[record.name] = payload;
+        } else if (record.kind == TRACE_RECORD_EVENT &&
+                   record.category <= GRAPH_START && record.phase <= END) {
+            on_event(lookup(record.process), lookup(record.thread),
+                     record.timestamp,
+                     lookup(record.name) + ":" + lookup(record.subname),
+                     record.category, record.phase, payload);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 void TraceLogger::format_logs(bool include_info) {
     if (!enable_format_log)
         return;
@@ -287,11 +477,25 @@ void TraceLogger::format_logs(bool include_info) {
 
     std::string phases[] = {"i", "B", "E"};
 
+    // Binary logs in the order they were written
+    std::vector<std::pair<int, std::string>> logs;
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        std::string filename = entry.path().filename().string();
+        if (filename.size() > 7 && filename.find("log") == 0 &&
+            filename.compare(filename.size() - 4, 4, ".bin") == 0)
+            logs.push_back({atoi(filename.c_str() + 3), filename});
+    }
+    // Short-circuit if no log
+    if (logs.empty())
+        return;
+    std::sort(logs.begin(), logs.end());
+
     // Hold the timestamp of duration event with phase 'B'
     std::map<std::string, long long> previous_ts;
 
-    // Count the additional number of duration event with 'B' phase to add
-    std::map<std::string, std::map<long long, bool>> ts_completed;
+    // Hold the timestamp of the 'B' event the last 'E' event was matched
+    // with, a further 'E' for it needs an additional 'B'
+    std::map<std::string, long long> completed_ts;
 
     // Count the occurrence of each event
     std::map<std::string, uint16_t> occurrence;
@@ -300,259 +504,165 @@ void TraceLogger::format_logs(bool include_info) {
     std::map<std::string, std::map<std::string, std::pair<long long, uint16_t>>>
         throughput;
 
-    nlohmann::json flog;
-    char line[1024];
     long long init_time = LLONG_MAX;
     long long start_time = LLONG_MAX;
     long long final_time = 0;
 
-    for (const auto &entry : std::filesystem::directory_iterator(".")) {
-// Proceed if is a log file
-        std::string filename = entry.path().filename().string();
-        if (filename.size() > 7 && filename.find("log") == 0 &&
-            filename.compare(filename.size() - 4, 4, ".txt") == 0) {
-            FILE *fp = fopen(filename.c_str(), "r");
-
-            while (fgets(line, sizeof(line), fp)) {
-                nlohmann::json linelog;
-
-                // Line by line decoding
-                std::stringstream ss(line);
-                int term_count = 0;
-                int cat_index = 0;
-
-                while (ss.good()) {
-                    std::string term;
-                    getline(ss, term, ',');
-
-                    if (term_count == 0) {
-                        // Process ID
-                        linelog["pid"] = term;
-                    } else if (term_count == 1) {
-                        // Thread ID
-                        linelog["tid"] = term;
-                    } else if (term_count == 2) {
-                        // Timestamp
-                        char *result;
-                        linelog["ts"] = strtoll(term.c_str(), &result, 10);
-                    } else if (term_count == 3) {
-                        // Name
-                        linelog["name"] = term;
-                    } else if (term_count == 4) {
-                        // Category
-                        cat_index = strtoll(term.c_str(), NULL, 10);
-                        linelog["cat"] = categories[cat_index];
-                        if (cat_index == 6) {
-                            // Graph start
-                            init_time = linelog["ts"];
-                        } else if (enable_printing && cat_index == 4) {
-                            // Throughput
-                            std::string line_name = linelog["name"];
-                            std::string stream_name =
-                                line_name.substr(0, line_name.find(":"));
-                            std::string node_name = line_name.substr(
-                                line_name.find(":") + 1, line_name.length());
-                            if (throughput.count(node_name)) {
-                                if (!throughput[node_name].count(stream_name)) {
-                                    throughput[node_name][stream_name] =
-                                        std::make_pair(0, 0);
-                                }
-                                throughput[node_name][stream_name].second += 1;
-                            }
-                        } else {
-                            if (linelog["ts"] < start_time)
-                                start_time = linelog["ts"];
-                            if (linelog["ts"] > final_time)
-                                final_time = linelog["ts"];
-                        }
+    // Events go to the formatted log as they are read, Chrome and Perfetto
+    // sort them on load
+    char tracelog_name[TRACELOG_NAME_SIZE];
+    time_t now = time(0);
+    strftime(tracelog_name, sizeof(tracelog_name), TRACELOG_NAME_FORMAT,
+             localtime(&now));
+    std::ofstream flog_file(tracelog_name);
+    flog_file << "[";
+    uint64_t event_count = 0;
+    auto write = [&flog_file, &event_count](const nlohmann::json &event) {
+        flog_file << (event_count++ ? ",\n" : "\n") << event.dump();
+    };
+
+    auto on_event = [&](const std::string &pid, const std::string &tid,
+                        long long ts, std::string name, int cat_index,
+                        int phase, const std::string &info) {
+        nlohmann::json linelog;
+        linelog["pid"] = pid;
+        linelog["tid"] = tid;
+        linelog["ts"] = ts;
+        linelog["cat"] = categories[cat_index];
+        linelog["ph"] = phases[phase];
+        if (!info.empty())
+            linelog["args"] = parse_trace_info(info);
+        if (cat_index == THROUGHPUT && linelog.count("args") &&
+            linelog["args"].count("stream") && linelog["args"].count("node"))
+            name = "Stream" + linelog["args"]["stream"].dump() + ":Node" +
+                   linelog["args"]["node"].dump();
+        linelog["name"] = name;
+
+        if (cat_index == TRACE_START) {
+            // Graph start
+            init_time = ts;
+        } else if (enable_printing && cat_index == THROUGHPUT) {
+            std::string stream_name = name.substr(0, name.find(":"));
+            std::string node_name = name.substr(name.find(":") + 1);
+            if (throughput.count(node_name)) {
+                if (!throughput[node_name].count(stream_name)) {
+                    throughput[node_name][stream_name] = std::make_pair(0, 0);
+                }
+                throughput[node_name][stream_name].second += 1;
+            }
+        } else {
+            if (ts < start_time)
+                start_time = ts;
+            if (ts > final_time)
+                final_time = ts;
+        }
 
-                        if (enable_printing && cat_index > 0) {
-                            occurrence[linelog["name"]]++;
-                        }
-                    } else if (term_count == 5) {
-                        // Phase
-                        linelog["ph"] = phases[strtoll(term.c_str(), NULL, 10)];
-
-                        // Duration event with phase 'B' will be recorded
-                        if (linelog["ph"] == "B") {
-                            previous_ts[linelog["name"]] = linelog["ts"];
-
-                            if (enable_printing) {
-                                // throughput
-                                std::string line_name = linelog["name"];
-                                std::string node_name =
-                                    line_name.substr(0, line_name.find(":"));
-                                if (!throughput.count(node_name)) {
-                                    throughput[node_name] = std::map<
-                                        std::string,
-                                        std::pair<long long, uint16_t>>();
-                                }
-                            }
-                        } else if (linelog["ph"] == "E") {
-                            // Duration event with phase 'E' will be checked
-                            // against 'E'
-                            if (previous_ts.count(linelog["name"])) {
-                                long long last_ts =
-                                    previous_ts[linelog["name"]];
-                                // Assume 'B' only occur once, while 'E' can
-                                // occur multiple times
-                                if (ts_completed.count(linelog["name"]) &&
-                                    ts_completed[linelog["name"]].count(
-                                        last_ts)) {
-                                    // Duplicate an event for "B" and slot in
-                                    nlohmann::json duplog;
-                                    duplog["pid"] = linelog["pid"];
-                                    duplog["tid"] = linelog["tid"];
-                                    duplog["ts"] = last_ts;
-                                    duplog["name"] = linelog["name"];
-                                    duplog["cat"] = linelog["cat"];
-                                    duplog["ph"] = "B";
-                                    flog.push_back(duplog);
-                                } else {
-                                    ts_completed[linelog["name"]][last_ts] =
-                                        true;
-                                }
-
-                                // Record the event duration
-                                if (enable_printing && cat_index > 0) {
-                                    if (!timings.count(linelog["name"])) {
-                                        timings[linelog["name"]]["total"] = 0;
-                                        timings[linelog["name"]]["count"] = 0;
-                                        timings[linelog["name"]]["ave"] = 0;
-                                        timings[linelog["name"]]["min"] =
-                                            LLONG_MAX;
-                                        timings[linelog["name"]]["max"] = 0;
-                                    }
-                                    long long event_ts = linelog["ts"];
-                                    long long duration = event_ts - last_ts;
-                                    timings[linelog["name"]]["total"] +=
-                                        duration;
-                                    timings[linelog["name"]]["count"]++;
-                                    timings[linelog["name"]]["ave"] =
-                                        timings[linelog["name"]]["total"] /
-                                        timings[linelog["name"]]["count"];
-                                    timings[linelog["name"]]["min"] = std::min(
-                                        timings[linelog["name"]]["min"],
-                                        duration);
-                                    timings[linelog["name"]]["max"] = std::max(
-                                        timings[linelog["name"]]["max"],
-                                        duration);
-
-                                    std::string line_name = linelog["name"];
-                                    std::string node_name = line_name.substr(
-                                        0, line_name.find(":"));
-                                    std::string cat_name = linelog["cat"];
-                                    if (cat_index == 1) {
-                                        // Handle throughput event - only end of
-                                        // processing will be checked
-                                        std::string func_name =
-                                            line_name.substr(
-                                                line_name.find(":") + 1,
-                                                line_name.length());
-                                        if (strcmp(func_name.c_str(),
-                                                   "process_node") == 0) {
-                                            for (auto &it :
-                                                 throughput[node_name]) {
-                                                it.second.first += duration;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    } else {
-                        // Create user info for first occurrence of user info
-                        // within the event log
-                        if (term_count == 6) {
-                            nlohmann::json user_info;
-                            linelog["args"] = user_info;
-                        }
+        if (enable_printing && cat_index > 0) {
+            occurrence[name]++;
+        }
 
-                        // Add user info
-                        size_t pos = 0;
-                        std::string arg, key, valtype;
-                        while ((pos = term.find(":")) != std::string::npos) {
-                            arg = term.substr(0, pos);
-                            if (key.empty()) {
-                                // Handle key
-                                key = arg;
-                            } else {
-                                // Handle string type value
-                                valtype = arg;
-                                arg = term.substr(pos + 1, term.length());
-                                if (!arg.empty() &&
-                                    arg[arg.length() - 1] == '\n') {
-                                    arg.erase(arg.length() - 1);
-                                }
-                                if (valtype == "1") {
-                                    // Handle int type value (decimal string)
-                                    linelog["args"][key] =
-                                        strtoll(arg.c_str(), NULL, 10);
-                                } else if (valtype == "2") {
-                                    // Handle double type value (decimal string)
-                                    linelog["args"][key] = atof(arg.c_str());
-                                } else {
-                                    // Handle string type (default) value
-                                    linelog["args"][key] = arg;
-                                }
-                            }
-                            term.erase(0, pos + 1);
-                        }
-                    }
-                    term_count++;
+        if (phase == START) {
+            // Duration event with phase 'B' will be recorded
+            previous_ts[name] = ts;
+            if (enable_printing) {
+                std::string node_name = name.substr(0, name.find(":"));
+                if (!throughput.count(node_name)) {
+                    throughput[node_name] =
+                        std::map<std::string, std::pair<long long, uint16_t>>();
                 }
+            }
+        } else if (phase == END && previous_ts.count(name)) {
+            // Duration event with phase 'E' will be checked against 'B'
+            long long last_ts = previous_ts[name];
+            // Assume 'B' only occur once, while 'E' can occur multiple times
+            if (completed_ts.count(name) && completed_ts[name] == last_ts) {
+                // Duplicate an event for "B" and slot in
+                nlohmann::json duplog;
+                duplog["pid"] = pid;
+                duplog["tid"] = tid;
+                duplog["ts"] = last_ts;
+                duplog["name"] = name;
+                duplog["cat"] = categories[cat_index];
+                duplog["ph"] = "B";
+                write(duplog);
+            } else {
+                completed_ts[name] = last_ts;
+            }
 
-                // Handle queue info
-                if (enable_printing) {
-                    if (cat_index == 3) {
-                        std::string queue_name = linelog["name"];
-                        queue_name = queue_name.substr(0, queue_name.find(":"));
-                        if (!queue_info.count(queue_name)) {
-                            queue_info[queue_name]["limit"] =
-                                linelog["args"]["max"];
-                            queue_info[queue_name]["max"] = 0;
-                            queue_info[queue_name]["ave"] = 0;
-                            queue_info[queue_name]["total"] = 0;
-                            queue_info[queue_name]["count"] = 0;
+            // Record the event duration
+            if (enable_printing && cat_index > 0) {
+                auto &timing = timings[name];
+                if (!timing.count("count")) {
+                    timing["total"] = 0;
+                    timing["count"] = 0;
+                    timing["ave"] = 0;
+                    timing["min"] = LLONG_MAX;
+                    timing["max"] = 0;
+                }
+                long long duration = ts - last_ts;
+                timing["total"] += duration;
+                timing["count"]++;
+                timing["ave"] = timing["total"] / timing["count"];
+                timing["min"] = std::min(timing["min"], duration);
+                timing["max"] = std::max(timing["max"], duration);
+
+                if (cat_index == PROCESSING) {
+                    // Handle throughput event - only end of processing will
+                    // be checked
+                    std::string node_name = name.substr(0, name.find(":"));
+                    std::string func_name = name.substr(name.find(":") + 1);
+                    if (func_name == "process_node") {
+                        for (auto &it : throughput[node_name]) {
+                            it.second.first += duration;
                         }
-                        if (linelog["args"]["size"] >
-                            queue_info[queue_name]["max"])
-                            queue_info[queue_name]["max"] =
-                                linelog["args"]["size"];
-                        int curr_size = linelog["args"]["size"];
-                        queue_info[queue_name]["total"] += curr_size;
-                        queue_info[queue_name]["count"]++;
-                        queue_info[queue_name]["ave"] =
-                            queue_info[queue_name]["total"] /
-                            queue_info[queue_name]["count"];
                     }
                 }
+            }
+        }
 
-                flog.push_back(linelog);
+        // Handle queue info
+        if (enable_printing && cat_index == QUEUE_INFO &&
+            linelog.count("args")) {
+            auto &args = linelog["args"];
+            std::string queue_name = name.substr(0, name.find(":"));
+            if (!queue_info.count(queue_name)) {
+                queue_info[queue_name]["limit"] = args.value("max", 0);
+                queue_info[queue_name]["max"] = 0;
+                queue_info[queue_name]["ave"] = 0;
+                queue_info[queue_name]["total"] = 0;
+                queue_info[queue_name]["count"] = 0;
             }
+            int curr_size = args.value("size", 0);
+            if (curr_size > queue_info[queue_name]["max"])
+                queue_info[queue_name]["max"] = curr_size;
+            queue_info[queue_name]["total"] += curr_size;
+            queue_info[queue_name]["count"]++;
+            queue_info[queue_name]["ave"] = queue_info[queue_name]["total"] /
+                                            queue_info[queue_name]["count"];
+        }
 
-            fclose(fp);
+        write(linelog);
+    };
 
-            // Handle removal of old binary log
-            // Binary log that has been formatted is no longer needed
-            try {
-                std::filesystem::remove(filename.c_str());
-            } catch (const std::filesystem::filesystem_error &err) {
-                std::cerr << "Filesystem Error: " << err.what() << std::endl;
-            }
+    for (auto &log : logs) {
+        if (!read_trace_log(log.second, on_event))
+            continue;
+
+        // Handle removal of old binary log
+        // Binary log that has been formatted is no longer needed
+        try {
+            std::filesystem::remove(log.second.c_str());
+        } catch (const std::filesystem::filesystem_error &err) {
+            std::cerr << "Filesystem Error: " << err.what() << std::endl;
         }
     }
 
     // Short-circuit if empty log
-    if (!flog.size())
+    if (!event_count) {
+        flog_file.close();
+        std::filesystem::remove(tracelog_name);
         return;
-
-    // Sort the JSON list
-    using json_it_type = decltype(*flog.begin());
-    std::sort(flog.begin(), flog.end(),
-              [](const json_it_type a, const json_it_type b) {
-                  return a["ts"] < b["ts"];
-              });
+    }
 
     // Process and print statistics
     if (enable_printing) {
@@ -637,13 +747,6 @@ void TraceLogger::format_logs(bool include_info) {
                      "- - - - - - -";
     }
 
-    // Sort the JSON list
-    using json_it_type = decltype(*flog.begin());
-    std::sort(flog.begin(), flog.end(),
-              [](const json_it_type a, const json_it_type b) {
-                  return a["ts"] < b["ts"];
-              });
-
     // Output Trace statistics
     if (include_info) {
         nlohmann::json logstats;
@@ -691,16 +794,11 @@ void TraceLogger::format_logs(bool include_info) {
                       << logstats["args"]["buffer_size"];
         }
 
-        flog.push_back(logstats);
+        write(logstats);
     }
 
-    // Write formatted log file
-    char tracelog_name[TRACELOG_NAME_SIZE];
-    time_t now = time(0);
-    strftime(tracelog_name, sizeof(tracelog_name), TRACELOG_NAME_FORMAT,
-             localtime(&now));
-    std::ofstream flog_file(tracelog_name);
-    flog_file << std::setw(4) << flog << std::endl;
+    // Close the formatted log
+    flog_file << "\n]" << std::endl;
     flog_file.close();
 
     if (enable_printing) {
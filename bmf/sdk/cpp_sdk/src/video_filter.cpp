@@ -63,7 +63,8 @@ VideoFrame bmf_scale_func_with_param(VideoFrame &src_vf, int w, int h,
  * @{
  * @arg width: dst frame width
  * @arg height: dst frame height
- * @arg mode: 0 is Nearest, 1 is Bilinear, 2 is Bicubic
+ * @arg mode: 0 is Nearest, 1 is Bilinear, 2 is Bicubic, 3 is Area,
+ *      4 is Lanczos
  * @} */
 VideoFrame bmf_scale_func(VideoFrame &src_vf, JsonParam param) {
     VideoFrame frame;
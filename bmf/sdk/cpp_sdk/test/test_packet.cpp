@@ -117,6 +117,13 @@ TEST(packet, constructors) {
         pkt_c.set_timestamp(111);
         EXPECT_EQ(pkt_c.timestamp(), 111);
 
+        // trace context, shared by the copies of a packet
+        EXPECT_EQ(pkt_c.trace_context().ingest_time, 0);
+        pkt_c.set_trace_context({100, 2, 3});
+        EXPECT_EQ(pkt_cc.trace_context().ingest_time, 100);
+        EXPECT_EQ(pkt_cc.trace_context().source, 2);
+        EXPECT_EQ(pkt_cc.trace_context().hops, 3);
+
         pkt_d.get<test::D>().u_ptr = &d_destroy_flag;
         EXPECT_EQ(d_destroy_flag, 0);
     }
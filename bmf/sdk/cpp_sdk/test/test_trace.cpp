@@ -0,0 +1,152 @@
+/*
+ * Copyright 2023 Babit Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bmf/sdk/trace.h>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <unistd.h>
+
+#ifndef NO_TRACE
+
+USE_BMF_SDK_NS
+
+namespace {
+
+void write_string(std::ofstream &log, uint32_t id, const std::string &str) {
+    TraceRecord record = {};
+    record.kind = TRACE_RECORD_STRING;
+    record.size = str.size();
+    record.name = id;
+    log.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    log.write(str.data(), str.size());
+}
+
+void write_event(std::ofstream &log, int64_t timestamp, uint32_t name,
+                 uint32_t subname, TraceType category, TracePhase phase,
+                 const std::string &info = "") {
+    TraceRecord record = {};
+    record.kind = TRACE_RECORD_EVENT;
+    record.category = category;
+    record.phase = phase;
+    record.size = info.size();
+    record.timestamp = timestamp;
+    record.process = 0;
+    record.thread = 1;
+    record.name = name;
+    record.subname = subname;
+    log.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    log.write(info.data(), info.size());
+}
+
+} // namespace
+
+TEST(trace, names) {
+    uint32_t node = TraceNames::intern("trace_test_node");
+    EXPECT_EQ(TraceNames::intern("trace_test_node"), node);
+    EXPECT_EQ(TraceNames::get(node), "trace_test_node");
+
+    // the per-thread cache must notice a buffer reused for another name
+    char name[32] = "trace_test_a";
+    uint32_t a = TraceNames::id(name);
+    EXPECT_EQ(TraceNames::id(name), a);
+    std::strcpy(name, "trace_test_b");
+    uint32_t b = TraceNames::id(name);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(TraceNames::get(b), "trace_test_b");
+    EXPECT_EQ(TraceNames::intern("trace_test_a"), a);
+}
+
+TEST(trace, format_binary_log) {
+    auto cwd = std::filesystem::current_path();
+    auto dir = std::filesystem::temp_directory_path() /
+               ("bmf_trace_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::filesystem::current_path(dir);
+
+    {
+        std::ofstream log("log0.bin", std::ofstream::binary);
+        log.write(TRACE_LOG_MAGIC, TRACE_LOG_MAGIC_SIZE);
+        write_string(log, 0, "100");
+        write_string(log, 1, "thread");
+        write_string(log, 2, "node_1");
+        write_string(log, 3, "process_node");
+        write_event(log, 10, 2, 3, PROCESSING, START);
+        write_event(log, 25, 2, 3, PROCESSING, END);
+        write_string(log, 4, "queue_1");
+        write_event(log, 30, 4, 3, QUEUE_INFO, NONE, ",size:1:3,max:1:5");
+        write_string(log, 5, "Stream");
+        write_string(log, 6, "Node");
+        write_event(log, 35, 5, 6, THROUGHPUT, NONE,
+                    ",stream:1:2,node:1:7,size:1:4");
+        // a record cut short by a crash is dropped
+        log.write(TRACE_LOG_MAGIC, 4);
+    }
+    TraceLogger logger(1, false);
+    logger.format_logs(false);
+
+    std::string tracelog;
+    for (auto &entry : std::filesystem::directory_iterator("."))
+        tracelog = entry.path().filename().string();
+    ASSERT_EQ(tracelog.compare(0, 9, "tracelog_"), 0);
+    std::ifstream in(tracelog);
+    auto events = nlohmann::json::parse(in);
+    ASSERT_EQ(events.size(), 4);
+    EXPECT_EQ(events[0]["name"], "node_1:process_node");
+    EXPECT_EQ(events[0]["pid"], "100");
+    EXPECT_EQ(events[0]["tid"], "thread");
+    EXPECT_EQ(events[0]["ph"], "B");
+    EXPECT_EQ(events[1]["ts"], 25);
+    EXPECT_EQ(events[1]["ph"], "E");
+    EXPECT_EQ(events[2]["cat"], "QUEUE_INFO");
+    EXPECT_EQ(events[2]["args"]["size"], 3);
+    EXPECT_EQ(events[2]["args"]["max"], 5);
+    // throughput events carry the ids as fields, named as before
+    EXPECT_EQ(events[3]["name"], "Stream2:Node7");
+    EXPECT_EQ(events[3]["args"]["size"], 4);
+
+    std::filesystem::current_path(cwd);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(trace, info_fields_kept_whole) {
+    std::string info = ",size:1:3,max:1:5";
+    EXPECT_EQ(trace_info_fit(info.data(), info.size()), info.size());
+
+    // the field crossing the limit is dropped, not cut to another value
+    info = ",a:1:1,b:1:2";
+    while (info.size() + 6 <= TRACE_INFO_SIZE)
+        info += ",c:1:3";
+    auto fit = info.size();
+    info += ",k:1:12345";
+    EXPECT_EQ(trace_info_fit(info.data(), info.size()), fit);
+}
+
+TEST(trace, names_bounded) {
+    uint32_t kept = TraceNames::intern("trace_test_kept");
+    for (uint32_t i = 0; i < TRACE_MAX_NAMES; i++)
+        TraceNames::intern(("trace_test_bound_" + std::to_string(i)).c_str());
+
+    // the table is full, new names share the overflow id
+    EXPECT_EQ(TraceNames::intern("trace_test_late"), TraceNames::OVERFLOW_ID);
+    char name[32] = "trace_test_late";
+    EXPECT_EQ(TraceNames::id(name), TraceNames::OVERFLOW_ID);
+    EXPECT_EQ(TraceNames::get(TraceNames::OVERFLOW_ID), "[overflow]");
+    EXPECT_EQ(TraceNames::intern("trace_test_kept"), kept);
+    EXPECT_EQ(TraceNames::get(kept), "trace_test_kept");
+}
+
+#endif